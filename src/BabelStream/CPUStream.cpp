@@ -0,0 +1,312 @@
+// Copyright (c) 2015-16 Tom Deakin, Simon McIntosh-Smith,
+// University of Bristol HPC
+//
+// For full license terms please see the LICENSE file distributed with this
+// source code
+
+#include "CPUStream.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+// Alignment of the arrays and of the thread slices
+#define ALIGNMENT 64
+
+// SIMD vectors of 32 bytes (AVX); on narrower targets the compiler splits
+// them up
+template <typename T> struct Vector;
+template <> struct Vector<float> {
+  typedef float type __attribute__((vector_size(32)));
+};
+template <> struct Vector<double> {
+  typedef double type __attribute__((vector_size(32)));
+};
+
+template <class T> T *alloc_array(unsigned int size) {
+  void *p = NULL;
+  if (posix_memalign(&p, ALIGNMENT, std::max(size, 1u) * sizeof(T)) != 0)
+    throw std::runtime_error("Could not allocate the arrays");
+  return (T *)p;
+}
+
+template <class T>
+CPUStream<T>::CPUStream(const unsigned int ARRAY_SIZE,
+                        const unsigned int num_threads)
+    : array_size(ARRAY_SIZE), idx(NULL), generation(0), pending(0),
+      quit(false) {
+  this->num_threads = num_threads;
+  if (this->num_threads == 0)
+    this->num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+  std::cout << "Using CPU with " << this->num_threads << " threads"
+            << std::endl;
+
+  // Untouched until init_arrays
+  a = alloc_array<T>(array_size);
+  b = alloc_array<T>(array_size);
+  c = alloc_array<T>(array_size);
+
+  sums.resize(this->num_threads);
+
+#ifdef __linux__
+  if (sched_getaffinity(0, sizeof(caller_cpus), &caller_cpus) != 0)
+    CPU_ZERO(&caller_cpus);
+#endif
+  pin_thread(0);
+  for (unsigned int thread = 1; thread < this->num_threads; thread++)
+    workers.push_back(std::thread(&CPUStream<T>::worker, this, thread));
+}
+
+template <class T> CPUStream<T>::~CPUStream() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    quit = true;
+    generation++;
+  }
+  start_cv.notify_all();
+  for (size_t i = 0; i < workers.size(); i++)
+    workers[i].join();
+
+#ifdef __linux__
+  if (CPU_COUNT(&caller_cpus) > 0)
+    pthread_setaffinity_np(pthread_self(), sizeof(caller_cpus), &caller_cpus);
+#endif
+
+  free(a);
+  free(b);
+  free(c);
+  free(idx);
+}
+
+// Binds the calling thread to the thread-th of the CPUs the caller was
+// allowed to run on (wrapping around) on Linux, so that it stays next to the
+// memory it touched first
+template <class T> void CPUStream<T>::pin_thread(unsigned int thread) {
+#ifdef __linux__
+  const int count = CPU_COUNT(&caller_cpus);
+  if (count == 0)
+    return;
+  int skip = thread % count;
+  for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if (!CPU_ISSET(cpu, &caller_cpus) || skip-- > 0)
+      continue;
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    return;
+  }
+#endif
+}
+
+template <class T>
+void CPUStream<T>::slice(unsigned int thread, unsigned int &begin,
+                         unsigned int &end) {
+  const unsigned int align = ALIGNMENT / sizeof(T);
+  unsigned int chunk = (array_size + num_threads - 1) / num_threads;
+  chunk = (chunk + align - 1) / align * align;
+  begin = std::min((unsigned long)thread * chunk, (unsigned long)array_size);
+  end = std::min((unsigned long)begin + chunk, (unsigned long)array_size);
+}
+
+template <class T> void CPUStream<T>::worker(unsigned int thread) {
+  pin_thread(thread);
+
+  unsigned int seen = 0;
+  while (true) {
+    std::unique_lock<std::mutex> lock(mutex);
+    start_cv.wait(lock, [&] { return generation != seen; });
+    seen = generation;
+    if (quit)
+      return;
+    lock.unlock();
+
+    unsigned int begin, end;
+    slice(thread, begin, end);
+    job(thread, begin, end);
+
+    lock.lock();
+    if (--pending == 0)
+      done_cv.notify_one();
+  }
+}
+
+template <class T>
+void CPUStream<T>::parallel(
+    const std::function<void(unsigned int, unsigned int, unsigned int)> &f) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    job = f;
+    pending = num_threads - 1;
+    generation++;
+  }
+  start_cv.notify_all();
+
+  unsigned int begin, end;
+  slice(0, begin, end);
+  f(0, begin, end);
+
+  std::unique_lock<std::mutex> lock(mutex);
+  done_cv.wait(lock, [&] { return pending == 0; });
+}
+
+template <class T> void CPUStream<T>::init_arrays(T initA, T initB, T initC) {
+  parallel([&](unsigned int, unsigned int begin, unsigned int end) {
+    for (unsigned int i = begin; i < end; i++) {
+      a[i] = initA;
+      b[i] = initB;
+      c[i] = initC;
+    }
+  });
+}
+
+template <class T>
+void CPUStream<T>::init_indices(const std::vector<unsigned int> &indices) {
+  if (idx == NULL)
+    idx = alloc_array<unsigned int>(array_size);
+  parallel([&](unsigned int, unsigned int begin, unsigned int end) {
+    std::copy(indices.begin() + begin, indices.begin() + end, idx + begin);
+  });
+}
+
+template <class T>
+void CPUStream<T>::write_arrays(const std::vector<T> &h_a,
+                                const std::vector<T> &h_b,
+                                const std::vector<T> &h_c) {
+  parallel([&](unsigned int, unsigned int begin, unsigned int end) {
+    std::copy(h_a.begin() + begin, h_a.begin() + end, a + begin);
+    std::copy(h_b.begin() + begin, h_b.begin() + end, b + begin);
+    std::copy(h_c.begin() + begin, h_c.begin() + end, c + begin);
+  });
+}
+
+template <class T>
+void CPUStream<T>::read_arrays(std::vector<T> &h_a, std::vector<T> &h_b,
+                               std::vector<T> &h_c) {
+  std::copy(a, a + array_size, h_a.begin());
+  std::copy(b, b + array_size, h_b.begin());
+  std::copy(c, c + array_size, h_c.begin());
+}
+
+// The kernels work on whole vectors from the (aligned) start of the slice,
+// then on the elements left over at its end.
+
+template <class T> void CPUStream<T>::copy() {
+  typedef typename Vector<T>::type V;
+  const unsigned int width = sizeof(V) / sizeof(T);
+  parallel([&](unsigned int, unsigned int begin, unsigned int end) {
+    unsigned int i = begin;
+    for (; i + width <= end; i += width)
+      *(V *)(c + i) = *(const V *)(a + i);
+    for (; i < end; i++)
+      c[i] = a[i];
+  });
+}
+
+template <class T> void CPUStream<T>::mul() {
+  typedef typename Vector<T>::type V;
+  const unsigned int width = sizeof(V) / sizeof(T);
+  const T scalar = startScalar;
+  parallel([&](unsigned int, unsigned int begin, unsigned int end) {
+    unsigned int i = begin;
+    for (; i + width <= end; i += width)
+      *(V *)(b + i) = scalar * *(const V *)(c + i);
+    for (; i < end; i++)
+      b[i] = scalar * c[i];
+  });
+}
+
+template <class T> void CPUStream<T>::add() {
+  typedef typename Vector<T>::type V;
+  const unsigned int width = sizeof(V) / sizeof(T);
+  parallel([&](unsigned int, unsigned int begin, unsigned int end) {
+    unsigned int i = begin;
+    for (; i + width <= end; i += width)
+      *(V *)(c + i) = *(const V *)(a + i) + *(const V *)(b + i);
+    for (; i < end; i++)
+      c[i] = a[i] + b[i];
+  });
+}
+
+template <class T> void CPUStream<T>::triad() {
+  typedef typename Vector<T>::type V;
+  const unsigned int width = sizeof(V) / sizeof(T);
+  const T scalar = startScalar;
+  parallel([&](unsigned int, unsigned int begin, unsigned int end) {
+    unsigned int i = begin;
+    for (; i + width <= end; i += width)
+      *(V *)(a + i) = *(const V *)(b + i) + scalar * *(const V *)(c + i);
+    for (; i < end; i++)
+      a[i] = b[i] + scalar * c[i];
+  });
+}
+
+template <class T> void CPUStream<T>::nstream() {
+  typedef typename Vector<T>::type V;
+  const unsigned int width = sizeof(V) / sizeof(T);
+  const T scalar = startScalar;
+  parallel([&](unsigned int, unsigned int begin, unsigned int end) {
+    unsigned int i = begin;
+    for (; i + width <= end; i += width)
+      *(V *)(a + i) += *(const V *)(b + i) + scalar * *(const V *)(c + i);
+    for (; i < end; i++)
+      a[i] += b[i] + scalar * c[i];
+  });
+}
+
+template <class T> T CPUStream<T>::dot() {
+  typedef typename Vector<T>::type V;
+  const unsigned int width = sizeof(V) / sizeof(T);
+  // Summed in blocks, with a compensated sum of the blocks, so that the
+  // rounding error does not grow with the length of the slice
+  const unsigned int block = 1024;
+  parallel([&](unsigned int thread, unsigned int begin, unsigned int end) {
+    T sum = 0.0;
+    T error = 0.0;
+    unsigned int i = begin;
+    while (i + width <= end) {
+      unsigned int block_end = std::min(i + block, end);
+      V vsum = {};
+      for (; i + width <= block_end; i += width)
+        vsum += *(const V *)(a + i) * *(const V *)(b + i);
+
+      T block_sum = -error;
+      for (unsigned int lane = 0; lane < width; lane++)
+        block_sum += vsum[lane];
+      T new_sum = sum + block_sum;
+      error = (new_sum - sum) - block_sum;
+      sum = new_sum;
+    }
+    for (; i < end; i++)
+      sum += a[i] * b[i];
+    sums[thread] = sum - error;
+  });
+
+  T sum = 0.0;
+  for (unsigned int thread = 0; thread < num_threads; thread++)
+    sum += sums[thread];
+
+  return sum;
+}
+
+template <class T> void CPUStream<T>::gather() {
+  parallel([&](unsigned int, unsigned int begin, unsigned int end) {
+    for (unsigned int i = begin; i < end; i++)
+      c[i] = a[idx[i]];
+  });
+}
+
+template <class T> void CPUStream<T>::scatter() {
+  parallel([&](unsigned int, unsigned int begin, unsigned int end) {
+    for (unsigned int i = begin; i < end; i++)
+      c[idx[i]] = a[i];
+  });
+}
+
+template class CPUStream<float>;
+template class CPUStream<double>;
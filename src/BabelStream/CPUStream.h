@@ -0,0 +1,83 @@
+// Copyright (c) 2015-16 Tom Deakin, Simon McIntosh-Smith,
+// University of Bristol HPC
+//
+// For full license terms please see the LICENSE file distributed with this
+// source code
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include "Stream.h"
+
+// Host implementation on a pool of std::threads.  Every thread owns the same
+// contiguous, 64 byte aligned slice of the arrays in every kernel, and
+// init_arrays writes each slice from its owner first, so on NUMA machines
+// the pages of a slice are on the node of the thread that uses them.
+template <class T> class CPUStream : public Stream<T> {
+protected:
+  // Size of arrays
+  unsigned int array_size;
+
+  // Arrays
+  T *a;
+  T *b;
+  T *c;
+  unsigned int *idx;
+
+  // Partial sums of the dot kernel, one per thread
+  std::vector<T> sums;
+
+  // Thread pool; thread 0 is the calling thread
+  unsigned int num_threads;
+  std::vector<std::thread> workers;
+  std::function<void(unsigned int, unsigned int, unsigned int)> job;
+  std::mutex mutex;
+  std::condition_variable start_cv;
+  std::condition_variable done_cv;
+  unsigned int generation;
+  unsigned int pending;
+  bool quit;
+
+#ifdef __linux__
+  // CPUs the calling thread was allowed to run on, restored on destruction
+  cpu_set_t caller_cpus;
+#endif
+
+  void pin_thread(unsigned int thread);
+  void worker(unsigned int thread);
+  void slice(unsigned int thread, unsigned int &begin, unsigned int &end);
+
+  // Runs f(thread, begin, end) on every thread and its slice and waits
+  void parallel(
+      const std::function<void(unsigned int, unsigned int, unsigned int)> &f);
+
+public:
+  // num_threads = 0 uses every hardware thread
+  CPUStream(const unsigned int, const unsigned int num_threads = 0);
+  ~CPUStream();
+
+  virtual void copy() override;
+  virtual void add() override;
+  virtual void mul() override;
+  virtual void triad() override;
+  virtual void nstream() override;
+  virtual T dot() override;
+
+  virtual void gather() override;
+  virtual void scatter() override;
+
+  virtual void init_arrays(T initA, T initB, T initC) override;
+  virtual void init_indices(const std::vector<unsigned int> &idx) override;
+  virtual void write_arrays(const std::vector<T> &a, const std::vector<T> &b,
+                            const std::vector<T> &c) override;
+  virtual void read_arrays(std::vector<T> &a, std::vector<T> &b,
+                           std::vector<T> &c) override;
+};
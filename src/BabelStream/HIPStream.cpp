@@ -7,9 +7,19 @@
 #include "HIPStream.h"
 #include "hip/hip_runtime.h"
 
-// work-group size
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <limits>
+
+// Default work-group size
 #define TBSIZE 256
 #define DOT_NUM_BLOCKS 256
+// Largest work-group size, the size of the dot kernel's shared array
+#define MAX_TBSIZE 1024
+// Pieces of the arrays for the streams start at multiples of this many
+// elements, so that every piece stays aligned for the vector loads
+#define PIECE_ALIGN 64
 
 void check_error(void) {
   hipError_t err = hipGetLastError();
@@ -19,16 +29,80 @@ void check_error(void) {
   }
 }
 
-template <class T>
-HIPStream<T>::HIPStream(const unsigned int ARRAY_SIZE, const int device_index) {
+// N consecutive elements, aligned to be loaded and stored as one vector:
+// float2 and float4, double2, or several of them for larger N
+template <typename T, int N>
+struct alignas((N * sizeof(T) < 16) ? N * sizeof(T) : 16) Pack {
+  T v[N];
+};
+
+// Launches a kernel over the arrays in one piece per stream and waits for
+// all of them.  launch(piece, begin, count) launches the piece of count
+// elements starting at element begin on streams[piece].  Returns the number
+// of pieces launched.
+template <typename Launch>
+unsigned int launch_split(const std::vector<hipStream_t> &streams,
+                          unsigned int array_size, Launch launch) {
+  const unsigned int num_streams = streams.size();
+  unsigned int chunk = (array_size + num_streams - 1) / num_streams;
+  chunk = (chunk + PIECE_ALIGN - 1) / PIECE_ALIGN * PIECE_ALIGN;
+
+  unsigned int piece = 0;
+  for (; piece < num_streams && piece * chunk < array_size; piece++) {
+    unsigned int begin = piece * chunk;
+    launch(piece, begin, std::min(chunk, array_size - begin));
+  }
+  check_error();
+  hipDeviceSynchronize();
+  check_error();
+  return piece;
+}
 
-  // The array size must be divisible by TBSIZE for kernel launches
-  if (ARRAY_SIZE % TBSIZE != 0) {
-    std::stringstream ss;
-    ss << "Array size must be a multiple of " << TBSIZE;
-    // throw std::runtime_error(ss.str());
+// Blocks to launch for count elements
+unsigned int grid_for(const LaunchConfig &config, unsigned int count) {
+  if (config.grid_size > 0)
+    return config.grid_size;
+  unsigned int threads = (count + config.elements - 1) / config.elements;
+  return std::max((threads + config.block_size - 1) / config.block_size, 1u);
+}
+
+// Launches kernel<T, N> with N the elements per thread of the configuration,
+// on count elements.  The kernel arguments follow count.
+#define LAUNCH_KERNEL(kernel, config, stream, count, ...)                     \
+  switch ((config).elements) {                                                 \
+  case 1:                                                                      \
+    hipLaunchKernelGGL(HIP_KERNEL_NAME(kernel<T, 1>),                          \
+                       dim3(grid_for(config, count)),                          \
+                       dim3((config).block_size), 0, stream, __VA_ARGS__);     \
+    break;                                                                     \
+  case 2:                                                                      \
+    hipLaunchKernelGGL(HIP_KERNEL_NAME(kernel<T, 2>),                          \
+                       dim3(grid_for(config, count)),                          \
+                       dim3((config).block_size), 0, stream, __VA_ARGS__);     \
+    break;                                                                     \
+  case 4:                                                                      \
+    hipLaunchKernelGGL(HIP_KERNEL_NAME(kernel<T, 4>),                          \
+                       dim3(grid_for(config, count)),                          \
+                       dim3((config).block_size), 0, stream, __VA_ARGS__);     \
+    break;                                                                     \
+  case 8:                                                                      \
+    hipLaunchKernelGGL(HIP_KERNEL_NAME(kernel<T, 8>),                          \
+                       dim3(grid_for(config, count)),                          \
+                       dim3((config).block_size), 0, stream, __VA_ARGS__);     \
+    break;                                                                     \
+  default:                                                                     \
+    throw std::runtime_error("Elements per thread must be 1, 2, 4 or 8");     \
   }
 
+// The kernels below loop over the packs of N elements with a grid-stride
+// loop, then the first threads take the count % N elements left at the end.
+#define GLOBAL_ID (hipBlockDim_x * hipBlockIdx_x + hipThreadIdx_x)
+#define GLOBAL_SIZE (hipBlockDim_x * hipGridDim_x)
+
+template <class T>
+HIPStream<T>::HIPStream(const unsigned int ARRAY_SIZE, const int device_index,
+                        const unsigned int num_streams) {
+
   // Set device
   int count;
   hipGetDeviceCount(&count);
@@ -44,8 +118,16 @@ HIPStream<T>::HIPStream(const unsigned int ARRAY_SIZE, const int device_index) {
 
   array_size = ARRAY_SIZE;
 
-  // Allocate the host array for partial sums for dot kernels
-  sums = (T *)malloc(sizeof(T) * DOT_NUM_BLOCKS);
+  // Create the streams
+  if (num_streams > 1) {
+    streams.resize(num_streams);
+    for (unsigned int i = 0; i < num_streams; i++)
+      hipStreamCreate(&streams[i]);
+    check_error();
+    std::cout << "Streams: " << num_streams << std::endl;
+  } else {
+    streams.push_back(0);
+  }
 
   // Check buffers fit on the device
   hipDeviceProp_t props;
@@ -54,6 +136,7 @@ HIPStream<T>::HIPStream(const unsigned int ARRAY_SIZE, const int device_index) {
     // throw std::runtime_error("Device does not have enough memory for all 3
     // buffers");
     std::cout << "Device does not have enough memory for all 3 buffers\n";
+  num_sms = std::max(props.multiProcessorCount, 1);
 
   // Create device buffers
   hipMalloc((void **)&d_a, ARRAY_SIZE * sizeof(T));
@@ -62,13 +145,26 @@ HIPStream<T>::HIPStream(const unsigned int ARRAY_SIZE, const int device_index) {
   check_error();
   hipMalloc((void **)&d_c, ARRAY_SIZE * sizeof(T));
   check_error();
-  hipMalloc((void **)&d_sum, DOT_NUM_BLOCKS * sizeof(T));
+
+  // Dot results, one per stream, read by the host without a copy
+  hipHostMalloc((void **)&sums, streams.size() * sizeof(T),
+                hipHostMallocMapped);
+  check_error();
+  hipHostGetDevicePointer((void **)&d_result, sums, 0);
   check_error();
+
+  // Partial sums of the blocks of dot kernels, one set per stream
+  d_sum = NULL;
+  max_dot_blocks = 0;
+  reserve_sums(DOT_NUM_BLOCKS);
+
+  // The index array is only allocated by init_indices
+  d_idx = NULL;
+
+  set_launch({TBSIZE, 0, 1});
 }
 
 template <class T> HIPStream<T>::~HIPStream() {
-  free(sums);
-
   hipFree(d_a);
   check_error();
   hipFree(d_b);
@@ -77,21 +173,90 @@ template <class T> HIPStream<T>::~HIPStream() {
   check_error();
   hipFree(d_sum);
   check_error();
+  hipHostFree(sums);
+  check_error();
+  if (d_idx != NULL) {
+    hipFree(d_idx);
+    check_error();
+  }
+
+  for (size_t i = 0; i < streams.size(); i++)
+    if (streams[i] != 0)
+      hipStreamDestroy(streams[i]);
+}
+
+template <class T> void HIPStream<T>::set_launch(const LaunchConfig &launch) {
+  if (launch.block_size == 0 || launch.block_size > MAX_TBSIZE ||
+      (launch.block_size & (launch.block_size - 1)) != 0)
+    throw std::runtime_error("Block size must be a power of two up to 1024");
+  if (launch.elements != 1 && launch.elements != 2 && launch.elements != 4 &&
+      launch.elements != 8)
+    throw std::runtime_error("Elements per thread must be 1, 2, 4 or 8");
+
+  for (int kernel = 0; kernel < NumKernels; kernel++)
+    config[kernel] = launch;
+  if (d_sum != NULL)
+    reserve_sums(dot_blocks());
+}
+
+template <class T> unsigned int HIPStream<T>::dot_blocks() const {
+  return (config[Dot].grid_size > 0) ? config[Dot].grid_size : DOT_NUM_BLOCKS;
+}
+
+template <class T> void HIPStream<T>::reserve_sums(unsigned int blocks) {
+  if (blocks <= max_dot_blocks)
+    return;
+
+  if (d_sum != NULL)
+    hipFree(d_sum);
+  max_dot_blocks = blocks;
+  hipMalloc((void **)&d_sum, max_dot_blocks * streams.size() * sizeof(T));
+  check_error();
 }
 
 template <typename T>
-__global__ void init_kernel(T *a, T *b, T *c, T initA, T initB, T initC) {
-  const int i = hipBlockDim_x * hipBlockIdx_x + hipThreadIdx_x;
-  a[i] = initA;
-  b[i] = initB;
-  c[i] = initC;
+__global__ void init_kernel(T *a, T *b, T *c, T initA, T initB, T initC,
+                            unsigned int count) {
+  for (unsigned int i = GLOBAL_ID; i < count; i += GLOBAL_SIZE) {
+    a[i] = initA;
+    b[i] = initB;
+    c[i] = initC;
+  }
 }
 
 template <class T> void HIPStream<T>::init_arrays(T initA, T initB, T initC) {
-  hipLaunchKernelGGL(HIP_KERNEL_NAME(init_kernel<T>), dim3(array_size / TBSIZE),
-                     dim3(TBSIZE), 0, 0, d_a, d_b, d_c, initA, initB, initC);
+  launch_split(
+      streams, array_size,
+      [&](unsigned int piece, unsigned int begin, unsigned int count) {
+        unsigned int blocks = (count + TBSIZE - 1) / TBSIZE;
+        hipLaunchKernelGGL(HIP_KERNEL_NAME(init_kernel<T>),
+                           dim3(std::max(blocks, 1u)), dim3(TBSIZE), 0,
+                           streams[piece], d_a + begin, d_b + begin,
+                           d_c + begin, initA, initB, initC, count);
+      });
+}
+
+template <class T>
+void HIPStream<T>::init_indices(const std::vector<unsigned int> &idx) {
+  if (d_idx == NULL) {
+    hipMalloc((void **)&d_idx, array_size * sizeof(unsigned int));
+    check_error();
+  }
+  hipMemcpy(d_idx, idx.data(), array_size * sizeof(unsigned int),
+            hipMemcpyHostToDevice);
   check_error();
-  hipDeviceSynchronize();
+}
+
+template <class T>
+void HIPStream<T>::write_arrays(const std::vector<T> &a,
+                                const std::vector<T> &b,
+                                const std::vector<T> &c) {
+  // Copy host memory to device
+  hipMemcpy(d_a, a.data(), a.size() * sizeof(T), hipMemcpyHostToDevice);
+  check_error();
+  hipMemcpy(d_b, b.data(), b.size() * sizeof(T), hipMemcpyHostToDevice);
+  check_error();
+  hipMemcpy(d_c, c.data(), c.size() * sizeof(T), hipMemcpyHostToDevice);
   check_error();
 }
 
@@ -107,75 +272,212 @@ void HIPStream<T>::read_arrays(std::vector<T> &a, std::vector<T> &b,
   check_error();
 }
 
-template <typename T> __global__ void copy_kernel(const T *a, T *c) {
-  const int i = hipBlockDim_x * hipBlockIdx_x + hipThreadIdx_x;
-  c[i] = a[i];
+template <typename T, int N>
+__global__ void copy_kernel(const T *a, T *c, unsigned int count) {
+  typedef Pack<T, N> P;
+  for (unsigned int i = GLOBAL_ID; i < count / N; i += GLOBAL_SIZE)
+    ((P *)c)[i] = ((const P *)a)[i];
+
+  const unsigned int i = count / N * N + GLOBAL_ID;
+  if (i < count)
+    c[i] = a[i];
 }
 
 template <class T> void HIPStream<T>::copy() {
-  hipLaunchKernelGGL(HIP_KERNEL_NAME(copy_kernel<T>), dim3(array_size / TBSIZE),
-                     dim3(TBSIZE), 0, 0, d_a, d_c);
-  check_error();
-  hipDeviceSynchronize();
-  check_error();
+  launch_split(
+      streams, array_size,
+      [&](unsigned int piece, unsigned int begin, unsigned int count) {
+        LAUNCH_KERNEL(copy_kernel, config[Copy], streams[piece], count,
+                      d_a + begin, d_c + begin, count);
+      });
 }
 
-template <typename T> __global__ void mul_kernel(T *b, const T *c) {
+template <typename T, int N>
+__global__ void mul_kernel(T *b, const T *c, unsigned int count) {
+  typedef Pack<T, N> P;
   const T scalar = startScalar;
-  const int i = hipBlockDim_x * hipBlockIdx_x + hipThreadIdx_x;
-  b[i] = scalar * c[i];
+  for (unsigned int i = GLOBAL_ID; i < count / N; i += GLOBAL_SIZE) {
+    const P pc = ((const P *)c)[i];
+    P pb;
+    for (int k = 0; k < N; k++)
+      pb.v[k] = scalar * pc.v[k];
+    ((P *)b)[i] = pb;
+  }
+
+  const unsigned int i = count / N * N + GLOBAL_ID;
+  if (i < count)
+    b[i] = scalar * c[i];
 }
 
 template <class T> void HIPStream<T>::mul() {
-  hipLaunchKernelGGL(HIP_KERNEL_NAME(mul_kernel<T>), dim3(array_size / TBSIZE),
-                     dim3(TBSIZE), 0, 0, d_b, d_c);
-  check_error();
-  hipDeviceSynchronize();
-  check_error();
+  launch_split(
+      streams, array_size,
+      [&](unsigned int piece, unsigned int begin, unsigned int count) {
+        LAUNCH_KERNEL(mul_kernel, config[Mul], streams[piece], count,
+                      d_b + begin, d_c + begin, count);
+      });
 }
 
-template <typename T> __global__ void add_kernel(const T *a, const T *b, T *c) {
-  const int i = hipBlockDim_x * hipBlockIdx_x + hipThreadIdx_x;
-  c[i] = a[i] + b[i];
+template <typename T, int N>
+__global__ void add_kernel(const T *a, const T *b, T *c, unsigned int count) {
+  typedef Pack<T, N> P;
+  for (unsigned int i = GLOBAL_ID; i < count / N; i += GLOBAL_SIZE) {
+    const P pa = ((const P *)a)[i];
+    const P pb = ((const P *)b)[i];
+    P pc;
+    for (int k = 0; k < N; k++)
+      pc.v[k] = pa.v[k] + pb.v[k];
+    ((P *)c)[i] = pc;
+  }
+
+  const unsigned int i = count / N * N + GLOBAL_ID;
+  if (i < count)
+    c[i] = a[i] + b[i];
 }
 
 template <class T> void HIPStream<T>::add() {
-  hipLaunchKernelGGL(HIP_KERNEL_NAME(add_kernel<T>), dim3(array_size / TBSIZE),
-                     dim3(TBSIZE), 0, 0, d_a, d_b, d_c);
-  check_error();
-  hipDeviceSynchronize();
-  check_error();
+  launch_split(
+      streams, array_size,
+      [&](unsigned int piece, unsigned int begin, unsigned int count) {
+        LAUNCH_KERNEL(add_kernel, config[Add], streams[piece], count,
+                      d_a + begin, d_b + begin, d_c + begin, count);
+      });
 }
 
-template <typename T>
-__global__ void triad_kernel(T *a, const T *b, const T *c) {
+template <typename T, int N>
+__global__ void triad_kernel(T *a, const T *b, const T *c, unsigned int count) {
+  typedef Pack<T, N> P;
   const T scalar = startScalar;
-  const int i = hipBlockDim_x * hipBlockIdx_x + hipThreadIdx_x;
-  a[i] = b[i] + scalar * c[i];
+  for (unsigned int i = GLOBAL_ID; i < count / N; i += GLOBAL_SIZE) {
+    const P pb = ((const P *)b)[i];
+    const P pc = ((const P *)c)[i];
+    P pa;
+    for (int k = 0; k < N; k++)
+      pa.v[k] = pb.v[k] + scalar * pc.v[k];
+    ((P *)a)[i] = pa;
+  }
+
+  const unsigned int i = count / N * N + GLOBAL_ID;
+  if (i < count)
+    a[i] = b[i] + scalar * c[i];
 }
 
 template <class T> void HIPStream<T>::triad() {
-  hipLaunchKernelGGL(HIP_KERNEL_NAME(triad_kernel<T>),
-                     dim3(array_size / TBSIZE), dim3(TBSIZE), 0, 0, d_a, d_b,
-                     d_c);
-  check_error();
-  hipDeviceSynchronize();
-  check_error();
+  launch_split(
+      streams, array_size,
+      [&](unsigned int piece, unsigned int begin, unsigned int count) {
+        LAUNCH_KERNEL(triad_kernel, config[Triad], streams[piece], count,
+                      d_a + begin, d_b + begin, d_c + begin, count);
+      });
 }
 
-template <class T>
-__global__ void dot_kernel(const T *a, const T *b, T *sum,
-                           unsigned int array_size) {
-  __shared__ T tb_sum[TBSIZE];
+template <typename T, int N>
+__global__ void nstream_kernel(T *a, const T *b, const T *c,
+                               unsigned int count) {
+  typedef Pack<T, N> P;
+  const T scalar = startScalar;
+  for (unsigned int i = GLOBAL_ID; i < count / N; i += GLOBAL_SIZE) {
+    P pa = ((const P *)a)[i];
+    const P pb = ((const P *)b)[i];
+    const P pc = ((const P *)c)[i];
+    for (int k = 0; k < N; k++)
+      pa.v[k] += pb.v[k] + scalar * pc.v[k];
+    ((P *)a)[i] = pa;
+  }
 
-  int i = hipBlockDim_x * hipBlockIdx_x + hipThreadIdx_x;
-  const size_t local_i = hipThreadIdx_x;
+  const unsigned int i = count / N * N + GLOBAL_ID;
+  if (i < count)
+    a[i] += b[i] + scalar * c[i];
+}
 
-  tb_sum[local_i] = 0.0;
-  for (; i < array_size; i += hipBlockDim_x * hipGridDim_x)
-    tb_sum[local_i] += a[i] * b[i];
+template <class T> void HIPStream<T>::nstream() {
+  launch_split(
+      streams, array_size,
+      [&](unsigned int piece, unsigned int begin, unsigned int count) {
+        LAUNCH_KERNEL(nstream_kernel, config[Nstream], streams[piece], count,
+                      d_a + begin, d_b + begin, d_c + begin, count);
+      });
+}
 
-  for (int offset = hipBlockDim_x / 2; offset > 0; offset /= 2) {
+// The indexed side of gather and scatter spans the whole array, so only the
+// indices and the contiguous side are loaded as vectors.
+
+template <typename T, int N>
+__global__ void gather_kernel(const T *a, T *c, const unsigned int *idx,
+                              unsigned int count) {
+  typedef Pack<T, N> P;
+  typedef Pack<unsigned int, N> I;
+  for (unsigned int i = GLOBAL_ID; i < count / N; i += GLOBAL_SIZE) {
+    const I pi = ((const I *)idx)[i];
+    P pc;
+    for (int k = 0; k < N; k++)
+      pc.v[k] = a[pi.v[k]];
+    ((P *)c)[i] = pc;
+  }
+
+  const unsigned int i = count / N * N + GLOBAL_ID;
+  if (i < count)
+    c[i] = a[idx[i]];
+}
+
+template <class T> void HIPStream<T>::gather() {
+  launch_split(
+      streams, array_size,
+      [&](unsigned int piece, unsigned int begin, unsigned int count) {
+        LAUNCH_KERNEL(gather_kernel, config[Gather], streams[piece], count, d_a,
+                      d_c + begin, d_idx + begin, count);
+      });
+}
+
+template <typename T, int N>
+__global__ void scatter_kernel(const T *a, T *c, const unsigned int *idx,
+                               unsigned int count) {
+  typedef Pack<T, N> P;
+  typedef Pack<unsigned int, N> I;
+  for (unsigned int i = GLOBAL_ID; i < count / N; i += GLOBAL_SIZE) {
+    const P pa = ((const P *)a)[i];
+    const I pi = ((const I *)idx)[i];
+    for (int k = 0; k < N; k++)
+      c[pi.v[k]] = pa.v[k];
+  }
+
+  const unsigned int i = count / N * N + GLOBAL_ID;
+  if (i < count)
+    c[idx[i]] = a[i];
+}
+
+template <class T> void HIPStream<T>::scatter() {
+  launch_split(
+      streams, array_size,
+      [&](unsigned int piece, unsigned int begin, unsigned int count) {
+        LAUNCH_KERNEL(scatter_kernel, config[Scatter], streams[piece], count,
+                      d_a + begin, d_c, d_idx + begin, count);
+      });
+}
+
+// First stage: every block writes the sum of its threads to sum[block]
+template <typename T, int N>
+__global__ void dot_kernel(const T *a, const T *b, T *sum,
+                           unsigned int count) {
+  typedef Pack<T, N> P;
+  __shared__ T tb_sum[MAX_TBSIZE];
+
+  const unsigned int local_i = hipThreadIdx_x;
+
+  T thread_sum = 0.0;
+  for (unsigned int i = GLOBAL_ID; i < count / N; i += GLOBAL_SIZE) {
+    const P pa = ((const P *)a)[i];
+    const P pb = ((const P *)b)[i];
+    for (int k = 0; k < N; k++)
+      thread_sum += pa.v[k] * pb.v[k];
+  }
+
+  const unsigned int i = count / N * N + GLOBAL_ID;
+  if (i < count)
+    thread_sum += a[i] * b[i];
+  tb_sum[local_i] = thread_sum;
+
+  for (unsigned int offset = hipBlockDim_x / 2; offset > 0; offset /= 2) {
     __syncthreads();
     if (local_i < offset) {
       tb_sum[local_i] += tb_sum[local_i + offset];
@@ -183,24 +485,149 @@ __global__ void dot_kernel(const T *a, const T *b, T *sum,
   }
 
   if (local_i == 0)
-    sum[hipBlockIdx_x] = tb_sum[local_i];
+    sum[hipBlockIdx_x] = tb_sum[0];
 }
 
-template <class T> T HIPStream<T>::dot() {
-  hipLaunchKernelGGL(HIP_KERNEL_NAME(dot_kernel<T>), dim3(DOT_NUM_BLOCKS),
-                     dim3(TBSIZE), 0, 0, d_a, d_b, d_sum, array_size);
-  check_error();
+// Second stage, in a single block: adds up the block sums of the first
+// stage into result
+template <typename T>
+__global__ void dot_final_kernel(const T *sum, unsigned int blocks,
+                                 T *result) {
+  __shared__ T tb_sum[MAX_TBSIZE];
 
-  hipMemcpy(sums, d_sum, DOT_NUM_BLOCKS * sizeof(T), hipMemcpyDeviceToHost);
-  check_error();
+  const unsigned int local_i = hipThreadIdx_x;
+
+  T thread_sum = 0.0;
+  for (unsigned int block = local_i; block < blocks; block += hipBlockDim_x)
+    thread_sum += sum[block];
+  tb_sum[local_i] = thread_sum;
+
+  for (unsigned int offset = hipBlockDim_x / 2; offset > 0; offset /= 2) {
+    __syncthreads();
+    if (local_i < offset) {
+      tb_sum[local_i] += tb_sum[local_i + offset];
+    }
+  }
+
+  if (local_i == 0)
+    *result = tb_sum[0];
+}
 
+template <class T> T HIPStream<T>::dot() {
+  // Each piece reduces to its own result, both stages on its stream, and
+  // the final stage writes it straight to host memory
+  const unsigned int blocks = dot_blocks();
+  LaunchConfig launch = config[Dot];
+  launch.grid_size = blocks;
+  unsigned int num_pieces = launch_split(
+      streams, array_size,
+      [&](unsigned int piece, unsigned int begin, unsigned int count) {
+        LAUNCH_KERNEL(dot_kernel, launch, streams[piece], count, d_a + begin,
+                      d_b + begin, d_sum + piece * blocks, count);
+        hipLaunchKernelGGL(HIP_KERNEL_NAME(dot_final_kernel<T>), dim3(1),
+                           dim3(launch.block_size), 0, streams[piece],
+                           d_sum + piece * blocks, blocks, d_result + piece);
+      });
+
+  // launch_split synchronized, so the results are in place
   T sum = 0.0;
-  for (int i = 0; i < DOT_NUM_BLOCKS; i++)
-    sum += sums[i];
+  for (unsigned int piece = 0; piece < num_pieces; piece++)
+    sum += ((volatile T *)sums)[piece];
 
   return sum;
 }
 
+// Best time of a few runs of a kernel with a candidate configuration
+template <class T>
+double HIPStream<T>::time_kernel(int kernel, const LaunchConfig &candidate) {
+  const int num_runs = 3;
+  config[kernel] = candidate;
+  if (kernel == Dot)
+    reserve_sums(dot_blocks());
+
+  double best = std::numeric_limits<double>::max();
+  for (int run = 0; run < num_runs; run++) {
+    auto t1 = std::chrono::high_resolution_clock::now();
+    switch (kernel) {
+    case Copy:
+      copy();
+      break;
+    case Mul:
+      mul();
+      break;
+    case Add:
+      add();
+      break;
+    case Triad:
+      triad();
+      break;
+    case Nstream:
+      nstream();
+      break;
+    case Dot:
+      dot();
+      break;
+    case Gather:
+      gather();
+      break;
+    case Scatter:
+      scatter();
+      break;
+    }
+    auto t2 = std::chrono::high_resolution_clock::now();
+    best = std::min(
+        best,
+        std::chrono::duration_cast<std::chrono::duration<double>>(t2 - t1)
+            .count());
+  }
+  return best;
+}
+
+// Tries every block size from 64 to 1024, elements per thread of 1 to 8, and
+// grids covering the array in one pass or of 1 to 32 blocks per
+// multiprocessor with a grid-stride loop, and keeps the fastest of each
+// kernel.
+template <class T> void HIPStream<T>::autotune() {
+  const char *names[NumKernels] = {"Copy",    "Mul", "Add",    "Triad",
+                                   "Nstream", "Dot", "Gather", "Scatter"};
+  const unsigned int block_sizes[] = {64, 128, 256, 512, 1024};
+  const unsigned int elements[] = {1, 2, 4, 8};
+  const unsigned int blocks_per_sm[] = {0, 1, 2, 4, 8, 16, 32};
+
+  // Valid values in the arrays, so that no kernel runs on NaNs
+  init_arrays(startA, startB, startC);
+
+  std::cout << std::left << std::setw(12) << "Kernel" << std::setw(12)
+            << "Block size" << std::setw(12) << "Grid size" << std::setw(12)
+            << "Elements" << std::setw(12) << "Min (sec)" << std::endl;
+
+  for (int kernel = 0; kernel < NumKernels; kernel++) {
+    if ((kernel == Gather || kernel == Scatter) && d_idx == NULL)
+      continue;
+
+    LaunchConfig best = config[kernel];
+    double best_time = std::numeric_limits<double>::max();
+    for (unsigned int block_size : block_sizes)
+      for (unsigned int n : elements)
+        for (unsigned int per_sm : blocks_per_sm) {
+          LaunchConfig candidate = {block_size, per_sm * num_sms, n};
+          double time = time_kernel(kernel, candidate);
+          if (time < best_time) {
+            best_time = time;
+            best = candidate;
+          }
+        }
+    config[kernel] = best;
+    if (kernel == Dot)
+      reserve_sums(dot_blocks());
+
+    std::cout << std::left << std::setw(12) << names[kernel] << std::setw(12)
+              << best.block_size << std::setw(12) << best.grid_size
+              << std::setw(12) << best.elements << std::setw(12)
+              << std::setprecision(5) << best_time << std::endl;
+  }
+}
+
 void listDevices(void) {
   // Get number of devices
   int count;
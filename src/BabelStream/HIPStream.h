@@ -12,34 +12,77 @@
 #include <stdexcept>
 
 #include "Stream.h"
+#include "hip/hip_runtime.h"
 
 #define IMPLEMENTATION_STRING "HIP"
 
+// Launch configuration of a kernel
+struct LaunchConfig {
+  // Threads per block, a power of two up to 1024
+  unsigned int block_size;
+  // Blocks; 0 for enough blocks to cover the array in one pass (256 for dot)
+  unsigned int grid_size;
+  // Consecutive elements per thread and pass, loaded as one vector: 1, 2, 4
+  // or 8
+  unsigned int elements;
+};
+
 template <class T> class HIPStream : public Stream<T> {
 protected:
   // Size of arrays
   unsigned int array_size;
 
-  // Host array for partial sums for dot kernel
+  // Streams the kernels are split across; a single null stream by default
+  std::vector<hipStream_t> streams;
+
+  // Launch configuration of each kernel
+  enum { Copy, Mul, Add, Triad, Nstream, Dot, Gather, Scatter, NumKernels };
+  LaunchConfig config[NumKernels];
+
+  // Multiprocessors of the device, for the grid sizes tried by autotune
+  unsigned int num_sms;
+
+  // Result of the dot kernel of each piece, in mapped pinned host memory
+  // the final kernel writes through d_result, and the number of blocks per
+  // piece d_sum has room for
   T *sums;
+  unsigned int max_dot_blocks;
 
   // Device side pointers to arrays
   T *d_a;
   T *d_b;
   T *d_c;
   T *d_sum;
+  T *d_result; // device pointer to sums
+  unsigned int *d_idx;
+
+  unsigned int dot_blocks() const;
+  void reserve_sums(unsigned int blocks);
+  double time_kernel(int kernel, const LaunchConfig &candidate);
 
 public:
-  HIPStream(const unsigned int, const int);
+  HIPStream(const unsigned int, const int, const unsigned int num_streams = 1);
   ~HIPStream();
 
+  // Uses the same configuration for all kernels
+  void set_launch(const LaunchConfig &launch);
+
   virtual void copy() override;
   virtual void add() override;
   virtual void mul() override;
   virtual void triad() override;
+  virtual void nstream() override;
   virtual T dot() override;
 
+  virtual void gather() override;
+  virtual void scatter() override;
+
+  virtual void autotune() override;
+
   virtual void init_arrays(T initA, T initB, T initC) override;
+  virtual void init_indices(const std::vector<unsigned int> &idx) override;
+  virtual void write_arrays(const std::vector<T> &a, const std::vector<T> &b,
+                            const std::vector<T> &c) override;
   virtual void read_arrays(std::vector<T> &a, std::vector<T> &b,
                            std::vector<T> &c) override;
 };
@@ -26,10 +26,23 @@ public:
   virtual void mul() = 0;
   virtual void add() = 0;
   virtual void triad() = 0;
+  virtual void nstream() = 0;
   virtual T dot() = 0;
 
+  // Indexed kernels using the indices given to init_indices
+  // gather: c[i] = a[idx[i]], scatter: c[idx[i]] = a[i]
+  virtual void gather() = 0;
+  virtual void scatter() = 0;
+
+  // Picks the fastest launch configuration of each kernel, if the
+  // implementation has any.  Leaves the arrays to be initialised again.
+  virtual void autotune() {}
+
   // Copy memory between host and device
   virtual void init_arrays(T initA, T initB, T initC) = 0;
+  virtual void init_indices(const std::vector<unsigned int> &idx) = 0;
+  virtual void write_arrays(const std::vector<T> &a, const std::vector<T> &b,
+                            const std::vector<T> &c) = 0;
   virtual void read_arrays(std::vector<T> &a, std::vector<T> &b,
                            std::vector<T> &c) = 0;
 };
@@ -9,14 +9,17 @@
 #include <chrono>
 #include <cmath>
 #include <cstring>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <limits>
 #include <numeric>
+#include <random>
 #include <vector>
 
 #define VERSION_STRING "3.4"
 
+#include "CPUStream.h"
 #include "HIPStream.h"
 #include "Stream.h"
 
@@ -24,20 +27,53 @@
 unsigned int ARRAY_SIZE = 33554432;
 unsigned int num_times = 100;
 unsigned int deviceIndex = 0;
+unsigned int num_streams = 1;
+unsigned int num_threads = 0;
+unsigned int block_size = 256;
+unsigned int grid_size = 0;
+unsigned int elements_per_thread = 1;
+bool autotune = false;
+unsigned int gather_stride = 1;
+bool gather_random = false;
 bool use_float = false;
-bool triad_only = false;
 bool output_as_csv = false;
 bool mibibytes = false;
 std::string csv_separator = ",";
 
+// Array size sweep
+bool sweep = false;
+unsigned int sweep_min = 1024;
+unsigned int sweep_steps = 4;
+double sweep_ci = 0.01;
+std::string sweep_json = "sweep.json";
+
+// Implementation to run on
+enum class Backend { HIP, CPU };
+Backend backend = Backend::HIP;
+
+// Kernels to run
+enum class Benchmark { All, Triad, Nstream, GatherScatter };
+Benchmark selection = Benchmark::All;
+
 template <typename T>
 void check_solution(const unsigned int ntimes, std::vector<T> &a,
                     std::vector<T> &b, std::vector<T> &c, T &sum);
 
+template <typename T>
+void check_gather_scatter(Stream<T> *stream,
+                          const std::vector<unsigned int> &idx,
+                          const std::vector<T> &goldA);
+
 template <typename T> void run();
 
 template <typename T> void run_triad();
 
+template <typename T> void run_sweep();
+
+std::vector<unsigned int> make_indices();
+
+template <typename T> Stream<T> *make_stream();
+
 void parseArguments(int argc, char *argv[]);
 
 int main(int argc, char *argv[]) {
@@ -47,11 +83,18 @@ int main(int argc, char *argv[]) {
   if (!output_as_csv) {
     std::cout << "BabelStream" << std::endl
               << "Version: " << VERSION_STRING << std::endl
-              << "Implementation: " << IMPLEMENTATION_STRING << std::endl;
+              << "Implementation: "
+              << ((backend == Backend::CPU) ? "CPU" : IMPLEMENTATION_STRING)
+              << std::endl;
   }
 
   // TODO: Fix Kokkos to allow multiple template specializations
-  if (triad_only) {
+  if (sweep) {
+    if (use_float)
+      run_sweep<float>();
+    else
+      run_sweep<double>();
+  } else if (selection == Benchmark::Triad) {
     if (use_float)
       run_triad<float>();
     else
@@ -68,7 +111,13 @@ template <typename T> void run() {
   std::streamsize ss = std::cout.precision();
 
   if (!output_as_csv) {
-    std::cout << "Running kernels " << num_times << " times" << std::endl;
+    if (selection == Benchmark::Nstream)
+      std::cout << "Running nstream " << num_times << " times" << std::endl;
+    else if (selection == Benchmark::GatherScatter)
+      std::cout << "Running gather/scatter " << num_times << " times"
+                << std::endl;
+    else
+      std::cout << "Running kernels " << num_times << " times" << std::endl;
 
     if (sizeof(T) == sizeof(float))
       std::cout << "Precision: float" << std::endl;
@@ -106,23 +155,95 @@ template <typename T> void run() {
   std::vector<T> c(ARRAY_SIZE);
 
   // Result of the Dot kernel
-  T sum;
-
-  Stream<T> *stream;
+  T sum = 0.0;
 
-  // Use the HIP implementation
-  stream = new HIPStream<T>(ARRAY_SIZE, deviceIndex);
+  Stream<T> *stream = make_stream<T>();
 
   stream->init_arrays(startA, startB, startC);
 
+  std::vector<unsigned int> idx;
+  if (selection == Benchmark::GatherScatter) {
+    if (!output_as_csv) {
+      if (gather_random)
+        std::cout << "Indices: random permutation" << std::endl;
+      else
+        std::cout << "Indices: stride " << gather_stride << std::endl;
+    }
+    idx = make_indices();
+    stream->init_indices(idx);
+  }
+
+  if (autotune) {
+    stream->autotune();
+    stream->init_arrays(startA, startB, startC);
+  }
+
+  // Gather and scatter only move elements, so a holds its index to show
+  // where each element went
+  if (selection == Benchmark::GatherScatter) {
+    for (unsigned int i = 0; i < ARRAY_SIZE; i++) {
+      a[i] = static_cast<T>(i);
+      b[i] = startB;
+      c[i] = startC;
+    }
+    stream->write_arrays(a, b, c);
+  }
+
+  // Kernels and the bytes each moves
+  std::vector<std::string> labels;
+  std::vector<size_t> sizes;
+  if (selection == Benchmark::Nstream) {
+    labels = {"Nstream"};
+    sizes = {4 * sizeof(T) * ARRAY_SIZE};
+  } else if (selection == Benchmark::GatherScatter) {
+    labels = {"Gather", "Scatter"};
+    sizes = {(2 * sizeof(T) + sizeof(unsigned int)) * ARRAY_SIZE,
+             (2 * sizeof(T) + sizeof(unsigned int)) * ARRAY_SIZE};
+  } else {
+    labels = {"Copy", "Mul", "Add", "Triad", "Dot"};
+    sizes = {2 * sizeof(T) * ARRAY_SIZE, 2 * sizeof(T) * ARRAY_SIZE,
+             3 * sizeof(T) * ARRAY_SIZE, 3 * sizeof(T) * ARRAY_SIZE,
+             2 * sizeof(T) * ARRAY_SIZE};
+  }
+
   // List of times
-  std::vector<std::vector<double>> timings(5);
+  std::vector<std::vector<double>> timings(labels.size());
 
   // Declare timers
   std::chrono::high_resolution_clock::time_point t1, t2;
 
   // Main loop
   for (unsigned int k = 0; k < num_times; k++) {
+    if (selection == Benchmark::Nstream) {
+      // Execute Nstream
+      t1 = std::chrono::high_resolution_clock::now();
+      stream->nstream();
+      t2 = std::chrono::high_resolution_clock::now();
+      timings[0].push_back(
+          std::chrono::duration_cast<std::chrono::duration<double>>(t2 - t1)
+              .count());
+      continue;
+    }
+
+    if (selection == Benchmark::GatherScatter) {
+      // Execute Gather
+      t1 = std::chrono::high_resolution_clock::now();
+      stream->gather();
+      t2 = std::chrono::high_resolution_clock::now();
+      timings[0].push_back(
+          std::chrono::duration_cast<std::chrono::duration<double>>(t2 - t1)
+              .count());
+
+      // Execute Scatter
+      t1 = std::chrono::high_resolution_clock::now();
+      stream->scatter();
+      t2 = std::chrono::high_resolution_clock::now();
+      timings[1].push_back(
+          std::chrono::duration_cast<std::chrono::duration<double>>(t2 - t1)
+              .count());
+      continue;
+    }
+
     // Execute Copy
     t1 = std::chrono::high_resolution_clock::now();
     stream->copy();
@@ -165,8 +286,12 @@ template <typename T> void run() {
   }
 
   // Check solutions
-  stream->read_arrays(a, b, c);
-  check_solution<T>(num_times, a, b, c, sum);
+  if (selection == Benchmark::GatherScatter) {
+    check_gather_scatter<T>(stream, idx, a);
+  } else {
+    stream->read_arrays(a, b, c);
+    check_solution<T>(num_times, a, b, c, sum);
+  }
 
   // Display timing results
   if (output_as_csv) {
@@ -184,12 +309,7 @@ template <typename T> void run() {
               << std::fixed;
   }
 
-  std::string labels[5] = {"Copy", "Mul", "Add", "Triad", "Dot"};
-  size_t sizes[5] = {2 * sizeof(T) * ARRAY_SIZE, 2 * sizeof(T) * ARRAY_SIZE,
-                     3 * sizeof(T) * ARRAY_SIZE, 3 * sizeof(T) * ARRAY_SIZE,
-                     2 * sizeof(T) * ARRAY_SIZE};
-
-  for (int i = 0; i < 5; i++) {
+  for (size_t i = 0; i < labels.size(); i++) {
     // Get min/max; ignore the first result
     auto minmax = std::minmax_element(timings[i].begin() + 1, timings[i].end());
 
@@ -262,13 +382,15 @@ template <typename T> void run_triad() {
   std::vector<T> b(ARRAY_SIZE);
   std::vector<T> c(ARRAY_SIZE);
 
-  Stream<T> *stream;
-
-  // Use the HIP implementation
-  stream = new HIPStream<T>(ARRAY_SIZE, deviceIndex);
+  Stream<T> *stream = make_stream<T>();
 
   stream->init_arrays(startA, startB, startC);
 
+  if (autotune) {
+    stream->autotune();
+    stream->init_arrays(startA, startB, startC);
+  }
+
   // Declare timers
   std::chrono::high_resolution_clock::time_point t1, t2;
 
@@ -313,6 +435,258 @@ template <typename T> void run_triad() {
   delete stream;
 }
 
+// Two-sided 95% quantile of Student's t distribution with dof degrees of
+// freedom
+double student_t95(unsigned int dof) {
+  static const double table[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447,
+                                 2.365,  2.306, 2.262, 2.228, 2.201, 2.179,
+                                 2.160,  2.145, 2.131, 2.120, 2.110, 2.101,
+                                 2.093,  2.086, 2.080, 2.074, 2.069, 2.064,
+                                 2.060,  2.056, 2.052, 2.048, 2.045, 2.042};
+  if (dof == 0)
+    return std::numeric_limits<double>::infinity();
+  if (dof <= 30)
+    return table[dof - 1];
+  return 1.96;
+}
+
+// Statistics of the run times of a kernel at one array size
+struct SweepResult {
+  std::string label;
+  unsigned int n_elements;
+  size_t bytes;
+  unsigned int reps;
+  double min, median, max, mean, stddev;
+  // Half width of the 95% confidence interval of the mean, relative to it
+  double ci;
+};
+
+SweepResult sweep_statistics(std::vector<double> times) {
+  SweepResult r;
+  r.reps = times.size();
+  std::sort(times.begin(), times.end());
+  r.min = times.front();
+  r.max = times.back();
+  r.median = (times[(r.reps - 1) / 2] + times[r.reps / 2]) / 2.0;
+  r.mean = std::accumulate(times.begin(), times.end(), 0.0) / r.reps;
+  double var = 0.0;
+  for (size_t i = 0; i < times.size(); i++)
+    var += (times[i] - r.mean) * (times[i] - r.mean);
+  r.stddev = (r.reps > 1) ? sqrt(var / (r.reps - 1)) : 0.0;
+  r.ci = student_t95(r.reps - 1) * r.stddev / sqrt((double)r.reps) / r.mean;
+  return r;
+}
+
+// Runs every kernel at array sizes growing geometrically from --sweep-min to
+// --arraysize, so that the working set goes from the L1 cache out to memory.
+// Each kernel is repeated until the 95% confidence interval of its mean time
+// is within --sweep-ci of the mean, or --numtimes runs, and the statistics
+// of every size are written to --sweep-json.
+template <typename T> void run_sweep() {
+  // Runs per kernel and size before the confidence interval is looked at
+  const unsigned int min_reps = 5;
+
+  const unsigned int max_size = ARRAY_SIZE;
+  std::vector<unsigned int> array_sizes;
+  for (unsigned int step = 0;; step++) {
+    double size = sweep_min * pow(2.0, (double)step / sweep_steps);
+    if (size > max_size)
+      break;
+    unsigned int n = (unsigned int)(size + 0.5);
+    if (array_sizes.empty() || n != array_sizes.back())
+      array_sizes.push_back(n);
+  }
+  if (array_sizes.empty() || array_sizes.back() != max_size)
+    array_sizes.push_back(max_size);
+
+  if (!output_as_csv) {
+    std::cout << "Sweeping " << array_sizes.size() << " array sizes from "
+              << array_sizes.front() << " to " << array_sizes.back()
+              << " elements" << std::endl;
+    if (sizeof(T) == sizeof(float))
+      std::cout << "Precision: float" << std::endl;
+    else
+      std::cout << "Precision: double" << std::endl;
+    if (gather_random)
+      std::cout << "Indices: random permutation" << std::endl;
+    else
+      std::cout << "Indices: stride " << gather_stride << std::endl;
+  }
+
+  const double unit = (mibibytes) ? pow(2.0, -20.0) : 1.0E-6;
+  std::vector<SweepResult> results;
+
+  std::streamsize ss = std::cout.precision();
+  if (output_as_csv) {
+    std::cout << "function" << csv_separator << "n_elements" << csv_separator
+              << "sizeof" << csv_separator << "reps" << csv_separator
+              << ((mibibytes) ? "max_mibytes_per_sec" : "max_mbytes_per_sec")
+              << csv_separator << "min_runtime" << csv_separator
+              << "median_runtime" << csv_separator << "max_runtime"
+              << csv_separator << "stddev_runtime" << std::endl;
+  }
+
+  for (size_t s = 0; s < array_sizes.size(); s++) {
+    ARRAY_SIZE = array_sizes[s];
+
+    std::vector<T> a(ARRAY_SIZE);
+    std::vector<T> b(ARRAY_SIZE);
+    std::vector<T> c(ARRAY_SIZE);
+
+    // A stream is made for every size, but only the first one announces
+    // the device, and none does in a CSV table.  Autotuning only reports
+    // its choice outside CSV tables.
+    std::streambuf *out = std::cout.rdbuf();
+    if (output_as_csv || s > 0)
+      std::cout.rdbuf(NULL);
+    Stream<T> *stream = make_stream<T>();
+    std::cout.rdbuf(out);
+
+    stream->init_arrays(startA, startB, startC);
+    stream->init_indices(make_indices());
+    if (autotune) {
+      if (output_as_csv)
+        std::cout.rdbuf(NULL);
+      stream->autotune();
+      std::cout.rdbuf(out);
+      stream->init_arrays(startA, startB, startC);
+    }
+
+    const std::vector<std::string> labels = {
+        "Copy", "Mul", "Add", "Triad", "Nstream", "Dot", "Gather", "Scatter"};
+    const size_t gather_bytes = (2 * sizeof(T) + sizeof(unsigned int));
+    const std::vector<size_t> sizes = {
+        2 * sizeof(T) * ARRAY_SIZE, 2 * sizeof(T) * ARRAY_SIZE,
+        3 * sizeof(T) * ARRAY_SIZE, 3 * sizeof(T) * ARRAY_SIZE,
+        4 * sizeof(T) * ARRAY_SIZE, 2 * sizeof(T) * ARRAY_SIZE,
+        gather_bytes * ARRAY_SIZE,  gather_bytes * ARRAY_SIZE};
+
+    if (!output_as_csv) {
+      std::cout << std::endl
+                << "Array size: " << ARRAY_SIZE << " elements" << std::endl;
+      std::cout << std::left << std::setw(12) << "Function" << std::left
+                << std::setw(12) << ((mibibytes) ? "MiBytes/sec" : "MBytes/sec")
+                << std::left << std::setw(12) << "Median" << std::left
+                << std::setw(8) << "Reps" << std::left << std::setw(12)
+                << "CI (%)" << std::endl
+                << std::fixed;
+    }
+
+    for (size_t k = 0; k < labels.size(); k++) {
+      std::vector<double> times;
+      // The first run is not timed
+      for (unsigned int rep = 0; rep <= num_times; rep++) {
+        std::chrono::high_resolution_clock::time_point t1, t2;
+        t1 = std::chrono::high_resolution_clock::now();
+        switch (k) {
+        case 0:
+          stream->copy();
+          break;
+        case 1:
+          stream->mul();
+          break;
+        case 2:
+          stream->add();
+          break;
+        case 3:
+          stream->triad();
+          break;
+        case 4:
+          stream->nstream();
+          break;
+        case 5:
+          stream->dot();
+          break;
+        case 6:
+          stream->gather();
+          break;
+        case 7:
+          stream->scatter();
+          break;
+        }
+        t2 = std::chrono::high_resolution_clock::now();
+        if (rep == 0)
+          continue;
+        times.push_back(
+            std::chrono::duration_cast<std::chrono::duration<double>>(t2 - t1)
+                .count());
+        if (times.size() >= min_reps &&
+            sweep_statistics(times).ci <= sweep_ci)
+          break;
+      }
+
+      SweepResult r = sweep_statistics(times);
+      r.label = labels[k];
+      r.n_elements = ARRAY_SIZE;
+      r.bytes = sizes[k];
+      results.push_back(r);
+
+      if (output_as_csv) {
+        std::cout << r.label << csv_separator << r.n_elements << csv_separator
+                  << sizeof(T) << csv_separator << r.reps << csv_separator
+                  << unit * r.bytes / r.min << csv_separator << r.min
+                  << csv_separator << r.median << csv_separator << r.max
+                  << csv_separator << r.stddev << std::endl;
+      } else {
+        std::cout << std::left << std::setw(12) << r.label << std::left
+                  << std::setw(12) << std::setprecision(3)
+                  << unit * r.bytes / r.min << std::left << std::setw(12)
+                  << unit * r.bytes / r.median << std::left << std::setw(8)
+                  << r.reps << std::left << std::setw(12)
+                  << std::setprecision(2) << 100.0 * r.ci << std::endl;
+      }
+    }
+
+    // Check the kernels on a fresh run of the usual sequence
+    stream->init_arrays(startA, startB, startC);
+    stream->copy();
+    stream->mul();
+    stream->add();
+    stream->triad();
+    T sum = stream->dot();
+    stream->read_arrays(a, b, c);
+    check_solution<T>(1, a, b, c, sum);
+
+    delete stream;
+  }
+  std::cout.precision(ss);
+
+  std::ofstream json(sweep_json.c_str());
+  if (!json) {
+    std::cerr << "Could not write " << sweep_json << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  json << std::setprecision(9);
+  json << "{" << std::endl
+       << "  \"version\": \"" << VERSION_STRING << "\"," << std::endl
+       << "  \"implementation\": \""
+       << ((backend == Backend::CPU) ? "CPU" : IMPLEMENTATION_STRING) << "\","
+       << std::endl
+       << "  \"sizeof\": " << sizeof(T) << "," << std::endl
+       << "  \"bandwidth_unit\": \"" << ((mibibytes) ? "MiB/s" : "MB/s")
+       << "\"," << std::endl
+       << "  \"confidence_target\": " << sweep_ci << "," << std::endl
+       << "  \"results\": [" << std::endl;
+  for (size_t i = 0; i < results.size(); i++) {
+    const SweepResult &r = results[i];
+    json << "    {\"function\": \"" << r.label
+         << "\", \"n_elements\": " << r.n_elements
+         << ", \"bytes\": " << r.bytes << ", \"reps\": " << r.reps
+         << ", \"min_runtime\": " << r.min
+         << ", \"median_runtime\": " << r.median
+         << ", \"max_runtime\": " << r.max << ", \"mean_runtime\": " << r.mean
+         << ", \"stddev_runtime\": " << r.stddev
+         << ", \"confidence\": " << r.ci
+         << ", \"max_bandwidth\": " << unit * r.bytes / r.min
+         << ", \"median_bandwidth\": " << unit * r.bytes / r.median << "}"
+         << ((i + 1 < results.size()) ? "," : "") << std::endl;
+  }
+  json << "  ]" << std::endl << "}" << std::endl;
+
+  if (!output_as_csv)
+    std::cout << std::endl << "Wrote " << sweep_json << std::endl;
+}
+
 template <typename T>
 void check_solution(const unsigned int ntimes, std::vector<T> &a,
                     std::vector<T> &b, std::vector<T> &c, T &sum) {
@@ -326,7 +700,11 @@ void check_solution(const unsigned int ntimes, std::vector<T> &a,
 
   for (unsigned int i = 0; i < ntimes; i++) {
     // Do STREAM!
-    if (!triad_only) {
+    if (selection == Benchmark::Nstream) {
+      goldA += goldB + scalar * goldC;
+      continue;
+    }
+    if (selection == Benchmark::All) {
       goldC = goldA;
       goldB = scalar * goldC;
       goldC = goldA + goldB;
@@ -367,18 +745,98 @@ void check_solution(const unsigned int ntimes, std::vector<T> &a,
     std::cerr << "Validation failed on c[]. Average error " << errC
               << std::endl;
   // Check sum to 8 decimal places
-  if (!triad_only && errSum > 1.0E-8)
+  if (selection == Benchmark::All && errSum > 1.0E-8)
     std::cerr << "Validation failed on sum. Error " << errSum << std::endl
               << std::setprecision(15) << "Sum was " << sum << " but should be "
               << goldSum << std::endl;
 }
 
+// Checks gather and scatter against the same permutation done on the host.
+// The timed loop ends with a scatter, so c is checked after it and again
+// after one more gather.  Both only copy elements, so they must match
+// exactly.
+template <typename T>
+void check_gather_scatter(Stream<T> *stream,
+                          const std::vector<unsigned int> &idx,
+                          const std::vector<T> &goldA) {
+  std::vector<T> a(ARRAY_SIZE);
+  std::vector<T> b(ARRAY_SIZE);
+  std::vector<T> c(ARRAY_SIZE);
+  std::vector<T> goldC(ARRAY_SIZE);
+
+  const char *kernel[2] = {"scatter", "gather"};
+  for (int pass = 0; pass < 2; pass++) {
+    if (pass == 0) {
+      for (unsigned int i = 0; i < ARRAY_SIZE; i++)
+        goldC[idx[i]] = goldA[i];
+    } else {
+      stream->gather();
+      for (unsigned int i = 0; i < ARRAY_SIZE; i++)
+        goldC[i] = goldA[idx[i]];
+    }
+    stream->read_arrays(a, b, c);
+
+    unsigned int wrongA = 0, wrongB = 0, wrongC = 0;
+    for (unsigned int i = 0; i < ARRAY_SIZE; i++) {
+      wrongA += (a[i] != goldA[i]);
+      wrongB += (b[i] != T(startB));
+      wrongC += (c[i] != goldC[i]);
+    }
+
+    if (wrongA > 0)
+      std::cerr << "Validation failed on a[] after " << kernel[pass] << ". "
+                << wrongA << " wrong elements" << std::endl;
+    if (wrongB > 0)
+      std::cerr << "Validation failed on b[] after " << kernel[pass] << ". "
+                << wrongB << " wrong elements" << std::endl;
+    if (wrongC > 0)
+      std::cerr << "Validation failed on c[] after " << kernel[pass] << ". "
+                << wrongC << " wrong elements" << std::endl;
+  }
+}
+
+// Creates the implementation selected with --backend
+template <typename T> Stream<T> *make_stream() {
+  if (backend == Backend::CPU)
+    return new CPUStream<T>(ARRAY_SIZE, num_threads);
+  HIPStream<T> *stream =
+      new HIPStream<T>(ARRAY_SIZE, deviceIndex, num_streams);
+  stream->set_launch({block_size, grid_size, elements_per_thread});
+  return stream;
+}
+
+// Indices for gather and scatter: a random permutation, or the elements in
+// order of the stride (every stride-th element from 0, then from 1, ...)
+std::vector<unsigned int> make_indices() {
+  std::vector<unsigned int> idx;
+  idx.reserve(ARRAY_SIZE);
+
+  if (gather_random) {
+    for (unsigned int i = 0; i < ARRAY_SIZE; i++)
+      idx.push_back(i);
+    std::mt19937 generator(ARRAY_SIZE);
+    std::shuffle(idx.begin(), idx.end(), generator);
+  } else {
+    for (unsigned int first = 0; first < gather_stride; first++)
+      for (unsigned int i = first; i < ARRAY_SIZE; i += gather_stride)
+        idx.push_back(i);
+  }
+
+  return idx;
+}
+
 int parseUInt(const char *str, unsigned int *output) {
   char *next;
   *output = strtoul(str, &next, 10);
   return !strlen(next);
 }
 
+int parseDouble(const char *str, double *output) {
+  char *next;
+  *output = strtod(str, &next);
+  return !strlen(next);
+}
+
 void parseArguments(int argc, char *argv[]) {
   for (int i = 1; i < argc; i++) {
     if (!std::string("--list").compare(argv[i])) {
@@ -389,6 +847,43 @@ void parseArguments(int argc, char *argv[]) {
         std::cerr << "Invalid device index." << std::endl;
         exit(EXIT_FAILURE);
       }
+    } else if (!std::string("--backend").compare(argv[i])) {
+      if (++i < argc && !std::string("hip").compare(argv[i])) {
+        backend = Backend::HIP;
+      } else if (i < argc && !std::string("cpu").compare(argv[i])) {
+        backend = Backend::CPU;
+      } else {
+        std::cerr << "Invalid backend." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    } else if (!std::string("--threads").compare(argv[i])) {
+      if (++i >= argc || !parseUInt(argv[i], &num_threads)) {
+        std::cerr << "Invalid number of threads." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    } else if (!std::string("--block-size").compare(argv[i])) {
+      if (++i >= argc || !parseUInt(argv[i], &block_size) ||
+          block_size == 0 || block_size > 1024 ||
+          (block_size & (block_size - 1)) != 0) {
+        std::cerr << "Invalid block size (a power of two up to 1024)."
+                  << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    } else if (!std::string("--grid-size").compare(argv[i])) {
+      if (++i >= argc || !parseUInt(argv[i], &grid_size)) {
+        std::cerr << "Invalid grid size." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    } else if (!std::string("--elements").compare(argv[i])) {
+      if (++i >= argc || !parseUInt(argv[i], &elements_per_thread) ||
+          (elements_per_thread != 1 && elements_per_thread != 2 &&
+           elements_per_thread != 4 && elements_per_thread != 8)) {
+        std::cerr << "Invalid elements per thread (1, 2, 4 or 8)."
+                  << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    } else if (!std::string("--autotune").compare(argv[i])) {
+      autotune = true;
     } else if (!std::string("--arraysize").compare(argv[i]) ||
                !std::string("-s").compare(argv[i])) {
       if (++i >= argc || !parseUInt(argv[i], &ARRAY_SIZE)) {
@@ -408,7 +903,49 @@ void parseArguments(int argc, char *argv[]) {
     } else if (!std::string("--float").compare(argv[i])) {
       use_float = true;
     } else if (!std::string("--triad-only").compare(argv[i])) {
-      triad_only = true;
+      selection = Benchmark::Triad;
+    } else if (!std::string("--nstream-only").compare(argv[i])) {
+      selection = Benchmark::Nstream;
+    } else if (!std::string("--gather-scatter").compare(argv[i])) {
+      selection = Benchmark::GatherScatter;
+    } else if (!std::string("--stride").compare(argv[i])) {
+      if (++i >= argc || !parseUInt(argv[i], &gather_stride) ||
+          gather_stride == 0) {
+        std::cerr << "Invalid stride." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    } else if (!std::string("--random").compare(argv[i])) {
+      gather_random = true;
+    } else if (!std::string("--streams").compare(argv[i])) {
+      if (++i >= argc || !parseUInt(argv[i], &num_streams) ||
+          num_streams == 0) {
+        std::cerr << "Invalid number of streams." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    } else if (!std::string("--sweep").compare(argv[i])) {
+      sweep = true;
+    } else if (!std::string("--sweep-min").compare(argv[i])) {
+      if (++i >= argc || !parseUInt(argv[i], &sweep_min) || sweep_min == 0) {
+        std::cerr << "Invalid smallest array size." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    } else if (!std::string("--sweep-steps").compare(argv[i])) {
+      if (++i >= argc || !parseUInt(argv[i], &sweep_steps) ||
+          sweep_steps == 0) {
+        std::cerr << "Invalid number of steps." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    } else if (!std::string("--sweep-ci").compare(argv[i])) {
+      if (++i >= argc || !parseDouble(argv[i], &sweep_ci) || sweep_ci < 0.0) {
+        std::cerr << "Invalid confidence interval." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    } else if (!std::string("--sweep-json").compare(argv[i])) {
+      if (++i >= argc) {
+        std::cerr << "Missing file name." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      sweep_json = argv[i];
     } else if (!std::string("--csv").compare(argv[i])) {
       output_as_csv = true;
     } else if (!std::string("--mibibytes").compare(argv[i])) {
@@ -424,6 +961,23 @@ void parseArguments(int argc, char *argv[]) {
                 << std::endl;
       std::cout << "      --device     INDEX   Select device at INDEX"
                 << std::endl;
+      std::cout << "      --backend    NAME    Run on hip (default) or cpu"
+                << std::endl;
+      std::cout << "      --threads    NUM     Use NUM threads with the cpu "
+                   "backend (default all)"
+                << std::endl;
+      std::cout << "      --block-size NUM     Use NUM threads per block "
+                   "(default 256)"
+                << std::endl;
+      std::cout << "      --grid-size  NUM     Use NUM blocks with grid-stride "
+                   "loops (default 0, one pass)"
+                << std::endl;
+      std::cout << "      --elements   NUM     Use NUM elements per thread: "
+                   "1, 2, 4 or 8"
+                << std::endl;
+      std::cout << "      --autotune           Pick the fastest launch of "
+                   "each kernel"
+                << std::endl;
       std::cout << "  -s  --arraysize  SIZE    Use SIZE elements in the array"
                 << std::endl;
       std::cout
@@ -432,6 +986,37 @@ void parseArguments(int argc, char *argv[]) {
       std::cout << "      --float              Use floats (rather than doubles)"
                 << std::endl;
       std::cout << "      --triad-only         Only run triad" << std::endl;
+      std::cout << "      --nstream-only       Only run nstream" << std::endl;
+      std::cout << "      --gather-scatter     Only run gather and scatter"
+                << std::endl;
+      std::cout << "      --stride     NUM     Gather/scatter every NUM-th "
+                   "element (default 1)"
+                << std::endl;
+      std::cout << "      --random             Gather/scatter in random order"
+                << std::endl;
+      std::cout << "      --streams    NUM     Split the kernels across NUM "
+                   "streams"
+                << std::endl;
+      std::cout << "      --sweep              Run every kernel at sizes from "
+                   "--sweep-min to SIZE"
+                << std::endl;
+      std::cout << "      --sweep-min  SIZE    Start the sweep at SIZE elements"
+                   " (default 1024)"
+                << std::endl;
+      std::cout << "      --sweep-steps NUM    Sweep NUM sizes per doubling "
+                   "(default 4)"
+                << std::endl;
+      std::cout << "      --sweep-ci   FRAC    Repeat each kernel until the "
+                   "95% confidence"
+                << std::endl
+                << "                           interval is within FRAC of the "
+                   "mean, at most NUM"
+                << std::endl
+                << "                           times (default 0.01)"
+                << std::endl;
+      std::cout << "      --sweep-json FILE    Write the sweep to FILE "
+                   "(default sweep.json)"
+                << std::endl;
       std::cout << "      --csv                Output as csv table"
                 << std::endl;
       std::cout << "      --mibibytes          Use MiB=2^20 for bandwidth "
@@ -445,4 +1030,12 @@ void parseArguments(int argc, char *argv[]) {
       exit(EXIT_FAILURE);
     }
   }
+
+  // The sweep always runs every kernel
+  if (sweep && selection != Benchmark::All) {
+    std::cerr << "--sweep cannot be combined with --triad-only, "
+                 "--nstream-only or --gather-scatter."
+              << std::endl;
+    exit(EXIT_FAILURE);
+  }
 }
@@ -10,8 +10,8 @@
 
 #if defined(HAVE_CUDA)
 
-// If in a CUDA GPU section use the CUDA atomics
-#ifdef __CUDA_ARCH__
+// If in a CUDA (or HIP) GPU section use the CUDA atomics
+#if defined(__CUDA_ARCH__) || defined(__HIP_DEVICE_COMPILE__)
 
 // Currently not atomic here. But its only used when it does not necissarially
 // need to be atomic.
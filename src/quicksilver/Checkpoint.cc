@@ -0,0 +1,296 @@
+#include "Checkpoint.hh"
+#include "MC_Base_Particle.hh"
+#include "MC_Domain.hh"
+#include "MC_Processor_Info.hh"
+#include "MC_RNG_State.hh"
+#include "MC_Time_Info.hh"
+#include "MonteCarlo.hh"
+#include "NVTX_Range.hh"
+#include "ParticleVault.hh"
+#include "ParticleVaultContainer.hh"
+#include "Tallies.hh"
+#include "utils.hh"
+#include "utilsMpi.hh"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+const char checkpointMagic[8] = {'Q', 'S', 'C', 'K', 'P', 'T', '\0', '\0'};
+// Version 2: Balance gained _xsCacheMiss.
+const uint32_t checkpointVersion = 2;
+
+// The particle records start at a multiple of this many bytes.
+const uint64_t particleAlignment = 64;
+
+struct CheckpointHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t particleBytes; // sizeof(MC_Base_Particle) of the writer
+  int32_t rank;
+  int32_t numRanks;
+  int32_t cycle;
+  int32_t rngType;
+  double time;
+  uint64_t numDomains;
+  uint64_t numCells;          // over all domains
+  uint64_t numSpectrumBins;   // 0 without an energy spectrum
+  uint64_t numFluenceDomains; // 0 unless the fluence is tallied
+  uint64_t numParticles;
+  uint64_t particleOffset; // bytes from the start of the file
+  Balance balanceCumulative;
+};
+
+// After the header:
+//   uint64_t cellsPerDomain[numDomains]
+//   uint64_t sourceTally[numCells]
+//   uint64_t spectrum[numSpectrumBins]
+//   uint64_t fluenceCells[numFluenceDomains]
+//   double   fluence[sum of fluenceCells]
+//   padding up to particleOffset
+//   MC_Base_Particle particle[numParticles]
+
+std::string rankFileName(MonteCarlo *monteCarlo, const std::string &fileName) {
+  if (monteCarlo->processor_info->num_processors == 1)
+    return fileName;
+  char suffix[32];
+  snprintf(suffix, sizeof(suffix), ".%d", monteCarlo->processor_info->rank);
+  return fileName + suffix;
+}
+
+template <class T> bool writeArray(FILE *file, const std::vector<T> &array) {
+  return array.empty() ||
+         fwrite(&array[0], sizeof(T), array.size(), file) == array.size();
+}
+
+void checkpointFatal(const std::string &fileName, const char *message) {
+  fprintf(stderr, "Fatal Error: checkpoint %s: %s\n", fileName.c_str(),
+          message);
+  mpiAbort(MPI_COMM_WORLD, -1);
+  abort();
+}
+
+// Sequential reader of the mapped file.
+class MappedReader {
+public:
+  MappedReader(const char *base, uint64_t size, const std::string &fileName)
+      : _base(base), _size(size), _offset(0), _fileName(fileName) {}
+
+  const void *take(uint64_t bytes) {
+    if (bytes > _size - _offset)
+      checkpointFatal(_fileName, "file is truncated");
+    const void *ptr = _base + _offset;
+    _offset += bytes;
+    return ptr;
+  }
+
+  uint64_t offset() const { return _offset; }
+
+private:
+  const char *_base;
+  uint64_t _size;
+  uint64_t _offset;
+  const std::string &_fileName;
+};
+} // namespace
+
+// -----------------------------------------------------------------------
+void WriteCheckpoint(MonteCarlo *monteCarlo, const std::string &fileName) {
+  NVTX_Range range("WriteCheckpoint");
+  double start = mpiWtime();
+
+  const std::string name = rankFileName(monteCarlo, fileName);
+  const std::string tmpName = name + ".tmp";
+  ParticleVaultContainer *container = monteCarlo->_particleVaultContainer;
+  Tallies *tallies = monteCarlo->_tallies;
+
+  std::vector<uint64_t> cellsPerDomain;
+  std::vector<uint64_t> sourceTally;
+  for (int domain = 0; domain < monteCarlo->domain.size(); domain++) {
+    const qs_vector<MC_Cell_State> &cells =
+        monteCarlo->domain[domain].cell_state;
+    cellsPerDomain.push_back(cells.size());
+    for (int cell = 0; cell < cells.size(); cell++)
+      sourceTally.push_back(cells[cell]._sourceTally);
+  }
+
+  std::vector<uint64_t> &spectrum = tallies->_spectrum.censusEnergySpectrum();
+  std::vector<uint64_t> fluenceCells;
+  std::vector<double> fluence;
+  for (size_t domain = 0; domain < tallies->_fluence._domain.size();
+       domain++) {
+    FluenceDomain *fluenceDomain = tallies->_fluence._domain[domain];
+    fluenceCells.push_back(fluenceDomain->size());
+    for (int cell = 0; cell < fluenceDomain->size(); cell++)
+      fluence.push_back(fluenceDomain->getCell(cell));
+  }
+
+  CheckpointHeader header = CheckpointHeader();
+  memcpy(header.magic, checkpointMagic, sizeof(header.magic));
+  header.version = checkpointVersion;
+  header.particleBytes = sizeof(MC_Base_Particle);
+  header.rank = monteCarlo->processor_info->rank;
+  header.numRanks = monteCarlo->processor_info->num_processors;
+  header.cycle = monteCarlo->time_info->cycle;
+  header.rngType = rng_type;
+  header.time = monteCarlo->time_info->time;
+  header.numDomains = cellsPerDomain.size();
+  header.numCells = sourceTally.size();
+  header.numSpectrumBins = spectrum.size();
+  header.numFluenceDomains = fluenceCells.size();
+  header.numParticles = container->sizeProcessed();
+  header.balanceCumulative = tallies->_balanceCumulative;
+
+  uint64_t arrayBytes =
+      sizeof(uint64_t) * (cellsPerDomain.size() + sourceTally.size() +
+                          spectrum.size() + fluenceCells.size()) +
+      sizeof(double) * fluence.size();
+  header.particleOffset =
+      (sizeof(header) + arrayBytes + particleAlignment - 1) /
+      particleAlignment * particleAlignment;
+
+  FILE *file = fopen(tmpName.c_str(), "wb");
+  if (file == NULL) {
+    fprintf(stderr, "Unable to open checkpoint file %s\n", tmpName.c_str());
+    return;
+  }
+
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+  ok = ok && writeArray(file, cellsPerDomain) &&
+       writeArray(file, sourceTally) && writeArray(file, spectrum) &&
+       writeArray(file, fluenceCells) && writeArray(file, fluence);
+
+  char padding[particleAlignment] = {0};
+  uint64_t padBytes = header.particleOffset - sizeof(header) - arrayBytes;
+  ok = ok && fwrite(padding, 1, padBytes, file) == padBytes;
+
+  // One write per vault.  The vaults may be SoA, so the particles are
+  // gathered into whole records first.
+  std::vector<MC_Base_Particle> buffer(container->getVaultSize());
+  for (uint64_t vault = 0; ok && vault < container->processedSize();
+       vault++) {
+    ParticleVault *processed = container->getTaskProcessedVault(vault);
+    size_t numParticles = processed->size();
+    if (numParticles == 0)
+      continue;
+    if (buffer.size() < numParticles)
+      buffer.resize(numParticles);
+    for (size_t ii = 0; ii < numParticles; ii++)
+      processed->getBaseParticle(buffer[ii], ii);
+    ok = fwrite(&buffer[0], sizeof(MC_Base_Particle), numParticles, file) ==
+         numParticles;
+  }
+
+  ok = (fclose(file) == 0) && ok;
+  if (!ok || rename(tmpName.c_str(), name.c_str()) != 0) {
+    fprintf(stderr, "Unable to write checkpoint file %s\n", name.c_str());
+    remove(tmpName.c_str());
+    return;
+  }
+
+  double seconds = mpiWtime() - start;
+  double bytes = header.particleOffset +
+                 (double)header.numParticles * sizeof(MC_Base_Particle);
+  Print0("Checkpoint of cycle %d written to %s: %.1f MiB in %.3f s\n",
+         header.cycle, fileName.c_str(), bytes / (1024. * 1024.), seconds);
+}
+
+// -----------------------------------------------------------------------
+void ReadCheckpoint(MonteCarlo *monteCarlo, const std::string &fileName) {
+  NVTX_Range range("ReadCheckpoint");
+  double start = mpiWtime();
+
+  const std::string name = rankFileName(monteCarlo, fileName);
+  ParticleVaultContainer *container = monteCarlo->_particleVaultContainer;
+  Tallies *tallies = monteCarlo->_tallies;
+
+  int fd = open(name.c_str(), O_RDONLY);
+  if (fd < 0)
+    checkpointFatal(name, "unable to open the file");
+  struct stat status;
+  if (fstat(fd, &status) != 0 || status.st_size == 0)
+    checkpointFatal(name, "unable to read the file size");
+  uint64_t fileSize = status.st_size;
+  void *map = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    checkpointFatal(name, "unable to map the file");
+  madvise(map, fileSize, MADV_SEQUENTIAL);
+
+  MappedReader reader((const char *)map, fileSize, name);
+  const CheckpointHeader &header =
+      *(const CheckpointHeader *)reader.take(sizeof(CheckpointHeader));
+
+  if (memcmp(header.magic, checkpointMagic, sizeof(header.magic)) != 0 ||
+      header.version != checkpointVersion)
+    checkpointFatal(name, "not a checkpoint file of this version");
+  if (header.particleBytes != sizeof(MC_Base_Particle))
+    checkpointFatal(name, "written by a build with another particle layout");
+  if (header.rank != monteCarlo->processor_info->rank ||
+      header.numRanks != monteCarlo->processor_info->num_processors)
+    checkpointFatal(name, "written with another number of ranks");
+  if (header.rngType != rng_type)
+    checkpointFatal(name, "written with another rngType");
+  if (header.numDomains != (uint64_t)monteCarlo->domain.size())
+    checkpointFatal(name, "written for another decomposition");
+
+  const uint64_t *cellsPerDomain = (const uint64_t *)reader.take(
+      header.numDomains * sizeof(uint64_t));
+  const uint64_t *sourceTally =
+      (const uint64_t *)reader.take(header.numCells * sizeof(uint64_t));
+  uint64_t cellIndex = 0;
+  for (int domain = 0; domain < monteCarlo->domain.size(); domain++) {
+    qs_vector<MC_Cell_State> &cells = monteCarlo->domain[domain].cell_state;
+    if (cellsPerDomain[domain] != (uint64_t)cells.size() ||
+        cellIndex + cells.size() > header.numCells)
+      checkpointFatal(name, "written for another mesh");
+    for (int cell = 0; cell < cells.size(); cell++)
+      cells[cell]._sourceTally = sourceTally[cellIndex++];
+  }
+
+  std::vector<uint64_t> &spectrum = tallies->_spectrum.censusEnergySpectrum();
+  if (header.numSpectrumBins != spectrum.size())
+    checkpointFatal(name, "written with another energy spectrum");
+  const uint64_t *spectrumIn = (const uint64_t *)reader.take(
+      header.numSpectrumBins * sizeof(uint64_t));
+  spectrum.assign(spectrumIn, spectrumIn + header.numSpectrumBins);
+
+  const uint64_t *fluenceCells = (const uint64_t *)reader.take(
+      header.numFluenceDomains * sizeof(uint64_t));
+  for (uint64_t domain = 0; domain < header.numFluenceDomains; domain++) {
+    const double *fluence =
+        (const double *)reader.take(fluenceCells[domain] * sizeof(double));
+    FluenceDomain *fluenceDomain = new FluenceDomain(fluenceCells[domain]);
+    for (uint64_t cell = 0; cell < fluenceCells[domain]; cell++)
+      fluenceDomain->addCell(cell, fluence[cell]);
+    tallies->_fluence._domain.push_back(fluenceDomain);
+  }
+
+  if (header.particleOffset < reader.offset())
+    checkpointFatal(name, "corrupt particle offset");
+  reader.take(header.particleOffset - reader.offset());
+  const MC_Base_Particle *particle = (const MC_Base_Particle *)reader.take(
+      header.numParticles * sizeof(MC_Base_Particle));
+
+  // The particles go where cycleFinalize leaves the census particles.
+  uint64_t fill_vault_index = 0;
+  for (uint64_t ii = 0; ii < header.numParticles; ii++) {
+    MC_Base_Particle base_particle = particle[ii];
+    container->addProcessedParticle(base_particle, fill_vault_index);
+  }
+
+  tallies->_balanceCumulative = header.balanceCumulative;
+  monteCarlo->time_info->cycle = header.cycle;
+  monteCarlo->time_info->start_cycle = header.cycle;
+  monteCarlo->time_info->time = header.time;
+
+  Print0("Restarted at cycle %d from %s in %.3f s\n", header.cycle,
+         fileName.c_str(), mpiWtime() - start);
+
+  munmap(map, fileSize);
+}
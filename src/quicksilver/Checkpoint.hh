@@ -0,0 +1,34 @@
+#ifndef CHECKPOINT_HH
+#define CHECKPOINT_HH
+
+#include <string>
+
+class MonteCarlo;
+
+//---------------------------------------------------------------
+// Binary checkpoint and restart of a run.
+//
+// A checkpoint holds what the next cycle of a rank starts from:
+// the census particles (with their random number seeds), the
+// source counters of the cells (the seeds of the next source
+// particles), the cumulative balance, fluence and energy spectrum
+// tallies and the cycle counter.  Every rank writes its own file,
+// named <checkpointFile>.<rank> when there is more than one rank.
+//
+// The file is a header, the small arrays, and then the particles
+// as MC_Base_Particle records, written with one large write per
+// vault.  The format is the memory image of this build, so it is
+// only meant to be read by the same executable with the same
+// problem and number of ranks; the header is checked for that.
+// A restart maps the file into memory and pushes the particles
+// straight from the mapping into the processed vaults.
+//--------------------------------------------------------------
+
+// Call after cycleFinalize.  Writes to a temporary file and renames it,
+// so a crash while writing leaves the previous checkpoint intact.
+void WriteCheckpoint(MonteCarlo *monteCarlo, const std::string &fileName);
+
+// Call at the end of initMC, before the first cycleInit.
+void ReadCheckpoint(MonteCarlo *monteCarlo, const std::string &fileName);
+
+#endif
@@ -66,7 +66,29 @@ bool CollisionEvent(MonteCarlo *monteCarlo, MC_Particle &mc_particle,
   int numIsos =
       (int)monteCarlo->_materialDatabase->_mat[globalMatIndex]._iso.size();
 
-  for (int isoIndex = 0; isoIndex < numIsos && currentCrossSection >= 0;
+  if (cell._cellNumberDensity != 0.0) {
+    // Walk the contiguous (isotope, reaction) row of the material table.
+    const MacroscopicCrossSectionTable *table = monteCarlo->_crossSectionTable;
+    const double *reactionCrossSection =
+        table->reactions(globalMatIndex, mc_particle.energy_group);
+    int rowOffset = globalMatIndex * table->_rowLength;
+    int numIsoReactions = table->_numIsoReactions[globalMatIndex];
+    for (int ii = 0; ii < numIsoReactions; ii++) {
+      currentCrossSection -= reactionCrossSection[ii] * cell._cellNumberDensity;
+      if (currentCrossSection < 0) {
+        selectedIso = table->_isotope[rowOffset + ii];
+        selectedReact = table->_reactIndex[rowOffset + ii];
+        selectedUniqueNumber =
+            monteCarlo->_materialDatabase->_mat[globalMatIndex]
+                ._iso[selectedIso]
+                ._gid;
+        break;
+      }
+    }
+  }
+
+  for (int isoIndex = 0; selectedIso == -1 && isoIndex < numIsos &&
+                         currentCrossSection >= 0;
        isoIndex++) {
     int uniqueNumber =
         monteCarlo->_materialDatabase->_mat[globalMatIndex]._iso[isoIndex]._gid;
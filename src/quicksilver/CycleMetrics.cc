@@ -0,0 +1,183 @@
+#include "CycleMetrics.hh"
+#include "MC_Fast_Timer.hh"
+#include "MC_Particle_Buffer.hh"
+#include "MC_Processor_Info.hh"
+#include "MC_Time_Info.hh"
+#include "MonteCarlo.hh"
+#include "ParticleVaultContainer.hh"
+#include "Tallies.hh"
+#include "qs_assert.hh"
+#include "utilsMpi.hh"
+
+namespace {
+// Set once the first run of this process opened the file, so that the
+// runs of the benchmarks append instead of overwriting it.
+bool metricsFileOpened = false;
+
+bool endsWith(const std::string &str, const std::string &suffix) {
+  return str.size() >= suffix.size() &&
+         str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+} // namespace
+
+CycleMetrics::CycleMetrics(const std::string &fileName, int rank)
+    : _enabled(!fileName.empty()), _csv(endsWith(fileName, ".csv")),
+      _needHeader(false), _file(NULL) {
+  for (int timer_index = 0; timer_index < MC_Fast_Timer::Num_Timers;
+       timer_index++) {
+    _timerName.push_back(std::string(mc_fast_timer_names[timer_index]) +
+                         "_us_avg");
+    _timerName.push_back(std::string(mc_fast_timer_names[timer_index]) +
+                         "_us_max");
+  }
+
+  if (!_enabled || rank != 0)
+    return;
+
+  _file = fopen(fileName.c_str(), metricsFileOpened ? "a" : "w");
+  if (_file == NULL) {
+    fprintf(stderr, "Unable to open metrics file %s\n", fileName.c_str());
+    return;
+  }
+  _needHeader = _csv && !metricsFileOpened;
+  metricsFileOpened = true;
+}
+
+CycleMetrics::~CycleMetrics() {
+  if (_file != NULL)
+    fclose(_file);
+}
+
+void CycleMetrics::record(MonteCarlo *monteCarlo) {
+  if (!_enabled)
+    return;
+
+  MC_Processor_Info *processor_info = monteCarlo->processor_info;
+  ParticleVaultContainer *container = monteCarlo->_particleVaultContainer;
+  MC_Particle_Buffer *particle_buffer = monteCarlo->particle_buffer;
+
+  // The timers, then the per rank counters.
+  const int numTimers = MC_Fast_Timer::Num_Timers;
+  std::vector<uint64_t> local(numTimers + 5);
+  for (int timer_index = 0; timer_index < numTimers; timer_index++)
+    local[timer_index] =
+        monteCarlo->fast_timer->timers[timer_index].lastCycleClock;
+  local[numTimers + 0] = particle_buffer->num_particles_sent;
+  local[numTimers + 1] = particle_buffer->num_particles_received;
+  local[numTimers + 2] = container->processedSize();
+  local[numTimers + 3] = container->sizeProcessed();
+  local[numTimers + 4] = container->sizeExtra();
+
+  std::vector<uint64_t> sum(local.size());
+  std::vector<uint64_t> max(local.size());
+  mpiReduce(&local[0], &sum[0], local.size(), MPI_UINT64_T, MPI_SUM, 0,
+            processor_info->comm_mc_world);
+  mpiReduce(&local[0], &max[0], local.size(), MPI_UINT64_T, MPI_MAX, 0,
+            processor_info->comm_mc_world);
+
+  if (processor_info->rank != 0 || _file == NULL)
+    return;
+
+  const int numRanks = processor_info->num_processors;
+  const Balance &bal = monteCarlo->_tallies->_balanceLastCycle;
+  std::vector<const char *> name;
+  std::vector<double> value;
+
+  // cycleFinalize already advanced the cycle counter.
+  name.push_back("cycle");
+  value.push_back(monteCarlo->time_info->cycle - 1);
+  name.push_back("ranks");
+  value.push_back(numRanks);
+
+  for (int timer_index = 0; timer_index < numTimers; timer_index++) {
+    name.push_back(_timerName[2 * timer_index].c_str());
+    value.push_back(sum[timer_index] / numRanks);
+    name.push_back(_timerName[2 * timer_index + 1].c_str());
+    value.push_back(max[timer_index]);
+  }
+
+  name.push_back("start");
+  value.push_back(bal._start);
+  name.push_back("source");
+  value.push_back(bal._source);
+  name.push_back("rr");
+  value.push_back(bal._rr);
+  name.push_back("split");
+  value.push_back(bal._split);
+  name.push_back("absorb");
+  value.push_back(bal._absorb);
+  name.push_back("scatter");
+  value.push_back(bal._scatter);
+  name.push_back("fission");
+  value.push_back(bal._fission);
+  name.push_back("produce");
+  value.push_back(bal._produce);
+  name.push_back("collisions");
+  value.push_back(bal._collision);
+  name.push_back("escape");
+  value.push_back(bal._escape);
+  name.push_back("census");
+  value.push_back(bal._census);
+  name.push_back("end");
+  value.push_back(bal._end);
+  name.push_back("segments");
+  value.push_back(bal._numSegments);
+  name.push_back("facet_crossings");
+  value.push_back(bal._facetCrossing);
+  // Every segment looks up the total cross section of its cell once.
+  name.push_back("xs_cache_hits");
+  value.push_back(bal._numSegments - bal._xsCacheMiss);
+  name.push_back("xs_cache_misses");
+  value.push_back(bal._xsCacheMiss);
+
+  name.push_back("particles_sent");
+  value.push_back(sum[numTimers + 0]);
+  name.push_back("particles_received");
+  value.push_back(sum[numTimers + 1]);
+
+  // Occupancy of the vaults holding the particles for the next cycle.
+  uint64_t vaultSize = container->getVaultSize();
+  uint64_t numVaults = sum[numTimers + 2];
+  name.push_back("vault_size");
+  value.push_back(vaultSize);
+  name.push_back("vaults");
+  value.push_back(numVaults);
+  name.push_back("vaults_max_per_rank");
+  value.push_back(max[numTimers + 2]);
+  name.push_back("vault_particles");
+  value.push_back(sum[numTimers + 3]);
+  name.push_back("vault_particles_max_per_rank");
+  value.push_back(max[numTimers + 3]);
+  name.push_back("vault_occupancy");
+  value.push_back(numVaults > 0 ? (double)sum[numTimers + 3] /
+                                      (numVaults * vaultSize)
+                                : 0.0);
+  name.push_back("extra_vault_particles");
+  value.push_back(sum[numTimers + 4]);
+
+  write(name, value);
+}
+
+void CycleMetrics::write(const std::vector<const char *> &name,
+                         const std::vector<double> &value) {
+  qs_assert(name.size() == value.size());
+
+  if (_csv) {
+    if (_needHeader) {
+      for (size_t ii = 0; ii < name.size(); ii++)
+        fprintf(_file, "%s%s", ii > 0 ? "," : "", name[ii]);
+      fprintf(_file, "\n");
+      _needHeader = false;
+    }
+    for (size_t ii = 0; ii < value.size(); ii++)
+      fprintf(_file, "%s%.15g", ii > 0 ? "," : "", value[ii]);
+    fprintf(_file, "\n");
+  } else {
+    fprintf(_file, "{");
+    for (size_t ii = 0; ii < name.size(); ii++)
+      fprintf(_file, "%s\"%s\": %.15g", ii > 0 ? ", " : "", name[ii],
+              value[ii]);
+    fprintf(_file, "}\n");
+  }
+  fflush(_file);
+}
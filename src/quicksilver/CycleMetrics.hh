@@ -0,0 +1,53 @@
+#ifndef CYCLE_METRICS_HH
+#define CYCLE_METRICS_HH
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+class MonteCarlo;
+
+//---------------------------------------------------------------
+// CycleMetrics writes one record per cycle to the file named by
+// the metricsFile parameter, for scripts and dashboards that
+// should not have to scrape the text reports on stdout.
+//
+// A record holds the average and maximum over all ranks of the
+// last cycle time of every MC_Fast_Timer (in microseconds, the
+// tally reduction is cycleFinalize_Tallies), the balance tallies
+// summed over all ranks (segments, collisions, facet crossings,
+// census, ...), the particles sent to and received from other
+// ranks, and the occupancy of the particle vaults at the end of
+// the cycle.
+//
+// If the file name ends in .csv the records are CSV rows below a
+// header row, otherwise they are JSON objects, one per line.
+// Both use the same field names.  Only rank 0 writes, but
+// record() has to be called by all ranks.  Later runs in the
+// same process (the benchmarks) append to the file.
+//--------------------------------------------------------------
+
+class CycleMetrics {
+public:
+  CycleMetrics(const std::string &fileName, int rank);
+  ~CycleMetrics();
+
+  // Call after cycleFinalize() and before the last cycle timers are
+  // cleared by MC_Fast_Timer_Container::Last_Cycle_Report.
+  void record(MonteCarlo *monteCarlo);
+
+private:
+  CycleMetrics(const CycleMetrics &);
+  CycleMetrics &operator=(const CycleMetrics &);
+
+  void write(const std::vector<const char *> &name,
+             const std::vector<double> &value);
+
+  bool _enabled;
+  bool _csv;
+  bool _needHeader;
+  FILE *_file;
+  std::vector<std::string> _timerName;
+};
+
+#endif
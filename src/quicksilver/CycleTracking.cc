@@ -14,15 +14,15 @@
 HOST_DEVICE
 void CycleTrackingGuts(MonteCarlo *monteCarlo, int particle_index,
                        ParticleVault *processingVault,
-                       ParticleVault *processedVault) {
+                       ParticleVault *processedVault, int vault) {
   MC_Particle mc_particle;
 
   // Copy a single particle from the particle vault into mc_particle
   MC_Load_Particle(monteCarlo, mc_particle, processingVault, particle_index);
 
-  // set the particle.task to the index of the processed vault the particle will
-  // census into.
-  mc_particle.task = 0; // processed_vault;
+  // set the particle.task to the index of the processing vault in the batch of
+  // a persistent tracking launch, which the send queue records.
+  mc_particle.task = vault;
 
   // loop over this particle until we cannot do anything more with it on this
   // processor
@@ -42,9 +42,9 @@ void CycleTrackingFunction(MonteCarlo *monteCarlo, MC_Particle &mc_particle,
   unsigned int tally_index =
       (particle_index) % monteCarlo->_tallies->GetNumBalanceReplications();
   unsigned int flux_tally_index =
-      (particle_index) % monteCarlo->_tallies->GetNumFluxReplications();
+      monteCarlo->_tallies->GetFluxTallyIndex(particle_index);
   unsigned int cell_tally_index =
-      (particle_index) % monteCarlo->_tallies->GetNumCellTallyReplications();
+      monteCarlo->_tallies->GetCellTallyIndex(particle_index);
   do {
     // Determine the outcome of a particle at the end of this segment such as:
     //
@@ -80,6 +80,8 @@ void CycleTrackingFunction(MonteCarlo *monteCarlo, MC_Particle &mc_particle,
 
     case MC_Segment_Outcome_type::Facet_Crossing: {
       // The particle has reached a cell facet.
+      ATOMIC_UPDATE(
+          monteCarlo->_tallies->_balanceTask[tally_index]._facetCrossing);
       MC_Tally_Event::Enum facet_crossing_type = MC_Facet_Crossing_Event(
           mc_particle, monteCarlo, particle_index, processingVault);
 
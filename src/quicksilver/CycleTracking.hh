@@ -8,7 +8,7 @@ class MC_Particle;
 HOST_DEVICE
 void CycleTrackingGuts(MonteCarlo *monteCarlo, int particle_index,
                        ParticleVault *processingVault,
-                       ParticleVault *processedVault);
+                       ParticleVault *processedVault, int vault = 0);
 HOST_DEVICE_END
 
 HOST_DEVICE
@@ -0,0 +1,187 @@
+#include "CycleTrackingEvent.hh"
+#include "AtomicMacro.hh"
+#include "CollisionEvent.hh"
+#include "Globals.hh"
+#include "MCT.hh"
+#include "MC_Facet_Crossing_Event.hh"
+#include "MC_Processor_Info.hh"
+#include "MC_Segment_Outcome.hh"
+#include "MonteCarlo.hh"
+#include "ParticleVault.hh"
+#include "ParticleVaultContainer.hh"
+#include "macros.hh"
+#include "qs_assert.hh"
+
+void EventTrackingBuffers::resize(size_t numParticles) {
+  if (particle.size() < numParticles) {
+    particle.resize(numParticles);
+    outcome.resize(numParticles);
+    keepTracking.resize(numParticles);
+  }
+  live.reserve(numParticles);
+  collision.reserve(numParticles);
+  facetCrossing.reserve(numParticles);
+  census.reserve(numParticles);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//  Tracks every particle of the processing vault until it collides out,
+//  escapes, leaves the processor or reaches census, one segment per sweep.
+//
+//  Each history consumes its own random number stream and uses the same tally
+//  replication indices as CycleTrackingGuts, so every particle follows the
+//  same history as in the history-based mode.  Only the order in which
+//  secondaries and censused particles are appended to the vaults differs.
+//----------------------------------------------------------------------------------------------------------------------
+
+void CycleTrackingEventBased(MonteCarlo *monteCarlo,
+                             ParticleVault *processingVault,
+                             ParticleVault *processedVault,
+                             EventTrackingBuffers &buffers) {
+  const int numParticles = processingVault->size();
+  const unsigned int numBalanceReplications =
+      monteCarlo->_tallies->GetNumBalanceReplications();
+
+  buffers.resize(numParticles);
+  MC_Particle *particle = &buffers.particle[0];
+  int *outcome = &buffers.outcome[0];
+  int *keepTracking = &buffers.keepTracking[0];
+
+  // Copy the particles out of the vault.
+#include "mc_omp_parallel_for_schedule_static.hh"
+  for (int particle_index = 0; particle_index < numParticles;
+       particle_index++) {
+    MC_Load_Particle(monteCarlo, particle[particle_index], processingVault,
+                     particle_index);
+    particle[particle_index].task = 0;
+  }
+
+  std::vector<int> &live = buffers.live;
+  live.resize(numParticles);
+  for (int particle_index = 0; particle_index < numParticles; particle_index++)
+    live[particle_index] = particle_index;
+
+  while (!live.empty()) {
+    const int numLive = live.size();
+
+    // Advance every live particle by one segment.
+#include "mc_omp_parallel_for_schedule_static.hh"
+    for (int ii = 0; ii < numLive; ii++) {
+      int particle_index = live[ii];
+      MC_Particle &mc_particle = particle[particle_index];
+      unsigned int tally_index = particle_index % numBalanceReplications;
+      unsigned int flux_tally_index =
+          monteCarlo->_tallies->GetFluxTallyIndex(particle_index);
+
+#ifdef EXPONENTIAL_TALLY
+      unsigned int cell_tally_index =
+          monteCarlo->_tallies->GetCellTallyIndex(particle_index);
+      monteCarlo->_tallies->TallyCellValue(
+          exp(rngSample(&mc_particle.random_number_seed)), mc_particle.domain,
+          cell_tally_index, mc_particle.cell);
+#endif
+      outcome[particle_index] =
+          MC_Segment_Outcome(monteCarlo, mc_particle, flux_tally_index);
+
+      ATOMIC_UPDATE(
+          monteCarlo->_tallies->_balanceTask[tally_index]._numSegments);
+
+      mc_particle.num_segments += 1.;
+    }
+
+    // Bucket the live particles by the outcome of their segment.
+    buffers.collision.clear();
+    buffers.facetCrossing.clear();
+    buffers.census.clear();
+    for (int ii = 0; ii < numLive; ii++) {
+      int particle_index = live[ii];
+      switch (outcome[particle_index]) {
+      case MC_Segment_Outcome_type::Collision:
+        buffers.collision.push_back(particle_index);
+        break;
+      case MC_Segment_Outcome_type::Facet_Crossing:
+        buffers.facetCrossing.push_back(particle_index);
+        break;
+      case MC_Segment_Outcome_type::Census:
+        buffers.census.push_back(particle_index);
+        break;
+      default:
+        qs_assert(false);
+        break;
+      }
+    }
+
+    const int numCollision = buffers.collision.size();
+    const int numFacetCrossing = buffers.facetCrossing.size();
+    const int numCensus = buffers.census.size();
+
+    // Collisions.
+#include "mc_omp_parallel_for_schedule_static.hh"
+    for (int ii = 0; ii < numCollision; ii++) {
+      int particle_index = buffers.collision[ii];
+      unsigned int tally_index = particle_index % numBalanceReplications;
+      keepTracking[particle_index] =
+          (CollisionEvent(monteCarlo, particle[particle_index], tally_index) ==
+           MC_Collision_Event_Return::Continue_Tracking);
+    }
+
+    // Facet crossings.
+#include "mc_omp_parallel_for_schedule_static.hh"
+    for (int ii = 0; ii < numFacetCrossing; ii++) {
+      int particle_index = buffers.facetCrossing[ii];
+      MC_Particle &mc_particle = particle[particle_index];
+      unsigned int tally_index = particle_index % numBalanceReplications;
+      ATOMIC_UPDATE(
+          monteCarlo->_tallies->_balanceTask[tally_index]._facetCrossing);
+
+      MC_Tally_Event::Enum facet_crossing_type = MC_Facet_Crossing_Event(
+          mc_particle, monteCarlo, particle_index, processingVault);
+
+      if (facet_crossing_type == MC_Tally_Event::Facet_Crossing_Transit_Exit) {
+        keepTracking[particle_index] = true; // Transit Event
+      } else if (facet_crossing_type == MC_Tally_Event::Facet_Crossing_Escape) {
+        ATOMIC_UPDATE(monteCarlo->_tallies->_balanceTask[tally_index]._escape);
+        mc_particle.last_event = MC_Tally_Event::Facet_Crossing_Escape;
+        mc_particle.species = -1;
+        keepTracking[particle_index] = false;
+      } else if (facet_crossing_type ==
+                 MC_Tally_Event::Facet_Crossing_Reflection) {
+        MCT_Reflect_Particle(monteCarlo, mc_particle);
+        keepTracking[particle_index] = true;
+      } else {
+        // Enters an adjacent cell in an off-processor domain.
+        keepTracking[particle_index] = false;
+      }
+    }
+
+    // Census.
+#include "mc_omp_parallel_for_schedule_static.hh"
+    for (int ii = 0; ii < numCensus; ii++) {
+      int particle_index = buffers.census[ii];
+      unsigned int tally_index = particle_index % numBalanceReplications;
+      processedVault->pushParticle(particle[particle_index]);
+      ATOMIC_UPDATE(monteCarlo->_tallies->_balanceTask[tally_index]._census);
+      keepTracking[particle_index] = false;
+    }
+
+    // Rebuild the live list from the particles that are still being tracked
+    // and mark the others as completed.
+    live.clear();
+    for (int ii = 0; ii < numCollision; ii++) {
+      int particle_index = buffers.collision[ii];
+      if (keepTracking[particle_index])
+        live.push_back(particle_index);
+      else
+        processingVault->invalidateParticle(particle_index);
+    }
+    for (int ii = 0; ii < numFacetCrossing; ii++) {
+      int particle_index = buffers.facetCrossing[ii];
+      if (keepTracking[particle_index])
+        live.push_back(particle_index);
+      else
+        processingVault->invalidateParticle(particle_index);
+    }
+    for (int ii = 0; ii < numCensus; ii++)
+      processingVault->invalidateParticle(buffers.census[ii]);
+  }
+}
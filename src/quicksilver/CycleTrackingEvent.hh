@@ -0,0 +1,50 @@
+#ifndef CYCLETRACKINGEVENT_HH
+#define CYCLETRACKINGEVENT_HH
+
+#include "MC_Particle.hh"
+#include <vector>
+
+// Forward Declaration
+class ParticleVault;
+class MonteCarlo;
+
+//---------------------------------------------------------------
+// Event-based tracking.
+//
+// Instead of following one history from birth to census in a
+// single divergent loop, all live particles of a vault advance
+// one segment at a time.  After each segment the particles are
+// bucketed by their MC_Segment_Outcome_type and every bucket is
+// processed by its own tight loop, so all iterations of a loop
+// run the same event code.
+//
+// EventTrackingBuffers holds the per-vault scratch space.  It is
+// grown on demand and reused for every vault of a cycle.
+//--------------------------------------------------------------
+
+struct EventTrackingBuffers {
+  // The particles being tracked, indexed by their processing
+  // vault index.
+  std::vector<MC_Particle> particle;
+
+  // The outcome of the last segment and whether the particle
+  // is still being tracked, indexed like particle.
+  std::vector<int> outcome;
+  std::vector<int> keepTracking;
+
+  // Vault indices of the live particles and of the particles in
+  // each outcome bucket.
+  std::vector<int> live;
+  std::vector<int> collision;
+  std::vector<int> facetCrossing;
+  std::vector<int> census;
+
+  void resize(size_t numParticles);
+};
+
+void CycleTrackingEventBased(MonteCarlo *monteCarlo,
+                             ParticleVault *processingVault,
+                             ParticleVault *processedVault,
+                             EventTrackingBuffers &buffers);
+
+#endif
@@ -11,6 +11,9 @@ public:
       : _fileName(name), _censusEnergySpectrum(size, 0){};
   void UpdateSpectrum(MonteCarlo *monteCarlo);
   void PrintSpectrum(MonteCarlo *monteCarlo);
+  std::vector<uint64_t> &censusEnergySpectrum() {
+    return _censusEnergySpectrum;
+  }
 
 private:
   std::string _fileName;
@@ -37,25 +37,32 @@ MC_Vector GlobalFccGrid::cellCenter(Long64 iCell) const {
   return r;
 }
 
+namespace {
+vector<Tuple4> makeCornerTupleOffsets() {
+  vector<Tuple4> offset;
+  offset.reserve(14);
+  offset.push_back(Tuple4(0, 0, 0, 0)); // 0
+  offset.push_back(Tuple4(1, 0, 0, 0)); // 1
+  offset.push_back(Tuple4(0, 1, 0, 0)); // 2
+  offset.push_back(Tuple4(1, 1, 0, 0)); // 3
+  offset.push_back(Tuple4(0, 0, 1, 0)); // 4
+  offset.push_back(Tuple4(1, 0, 1, 0)); // 5
+  offset.push_back(Tuple4(0, 1, 1, 0)); // 6
+  offset.push_back(Tuple4(1, 1, 1, 0)); // 7
+  offset.push_back(Tuple4(1, 0, 0, 1)); // 8
+  offset.push_back(Tuple4(0, 0, 0, 1)); // 9
+  offset.push_back(Tuple4(0, 1, 0, 2)); // 10
+  offset.push_back(Tuple4(0, 0, 0, 2)); // 11
+  offset.push_back(Tuple4(0, 0, 1, 3)); // 12
+  offset.push_back(Tuple4(0, 0, 0, 3)); // 13
+  return offset;
+}
+} // namespace
+
+// The offsets are built by the (thread safe) initialization of the static,
+// so concurrent thread ranks can call this.
 const vector<Tuple4> &GlobalFccGrid::cornerTupleOffsets() const {
-  static vector<Tuple4> offset;
-  if (offset.size() == 0) {
-    offset.reserve(14);
-    offset.push_back(Tuple4(0, 0, 0, 0)); // 0
-    offset.push_back(Tuple4(1, 0, 0, 0)); // 1
-    offset.push_back(Tuple4(0, 1, 0, 0)); // 2
-    offset.push_back(Tuple4(1, 1, 0, 0)); // 3
-    offset.push_back(Tuple4(0, 0, 1, 0)); // 4
-    offset.push_back(Tuple4(1, 0, 1, 0)); // 5
-    offset.push_back(Tuple4(0, 1, 1, 0)); // 6
-    offset.push_back(Tuple4(1, 1, 1, 0)); // 7
-    offset.push_back(Tuple4(1, 0, 0, 1)); // 8
-    offset.push_back(Tuple4(0, 0, 0, 1)); // 9
-    offset.push_back(Tuple4(0, 1, 0, 2)); // 10
-    offset.push_back(Tuple4(0, 0, 0, 2)); // 11
-    offset.push_back(Tuple4(0, 0, 1, 3)); // 12
-    offset.push_back(Tuple4(0, 0, 0, 3)); // 13
-  }
+  static const vector<Tuple4> offset = makeCornerTupleOffsets();
   return offset;
 }
 
@@ -119,19 +126,20 @@ void GlobalFccGrid::snapTuple(Tuple &tt) const {
 }
 
 namespace {
-const vector<Tuple> &getFaceTupleOffset() {
-  static vector<Tuple> faceTupleOffset;
-
-  if (faceTupleOffset.size() == 0) {
-    faceTupleOffset.reserve(6);
-    faceTupleOffset.push_back(Tuple(1, 0, 0));
-    faceTupleOffset.push_back(Tuple(-1, 0, 0));
-    faceTupleOffset.push_back(Tuple(0, 1, 0));
-    faceTupleOffset.push_back(Tuple(0, -1, 0));
-    faceTupleOffset.push_back(Tuple(0, 0, 1));
-    faceTupleOffset.push_back(Tuple(0, 0, -1));
-  }
+vector<Tuple> makeFaceTupleOffset() {
+  vector<Tuple> faceTupleOffset;
+  faceTupleOffset.reserve(6);
+  faceTupleOffset.push_back(Tuple(1, 0, 0));
+  faceTupleOffset.push_back(Tuple(-1, 0, 0));
+  faceTupleOffset.push_back(Tuple(0, 1, 0));
+  faceTupleOffset.push_back(Tuple(0, -1, 0));
+  faceTupleOffset.push_back(Tuple(0, 0, 1));
+  faceTupleOffset.push_back(Tuple(0, 0, -1));
+  return faceTupleOffset;
+}
 
+const vector<Tuple> &getFaceTupleOffset() {
+  static const vector<Tuple> faceTupleOffset = makeFaceTupleOffset();
   return faceTupleOffset;
 }
 } // namespace
@@ -2,6 +2,8 @@
 #define GLOBALS_HH
 
 class MonteCarlo;
-extern MonteCarlo *mcco;
+// One MonteCarlo object per rank.  Thread local because ThreadRanks can run
+// several ranks in one process.
+extern thread_local MonteCarlo *mcco;
 
 #endif
@@ -5,7 +5,6 @@
 #include "DeclareMacro.hh"
 #include "DirectionCosine.hh"
 #include "Globals.hh"
-#include "MC_Distance_To_Facet.hh"
 #include "MC_Domain.hh"
 #include "MC_Location.hh"
 #include "MC_Nearest_Facet.hh"
@@ -36,9 +35,8 @@ void MCT_Nearest_Facet_3D_G_Move_Particle(
     double move_factor);   // input: multiplication factor for move
 
 HOST_DEVICE_CUDA
-MC_Nearest_Facet
-MCT_Nearest_Facet_Find_Nearest(int num_facets_per_cell,
-                               MC_Distance_To_Facet *distance_to_facet);
+MC_Nearest_Facet MCT_Nearest_Facet_Find_Nearest(int num_facets_per_cell,
+                                                const double *distance);
 
 HOST_DEVICE_CUDA
 MC_Nearest_Facet
@@ -47,7 +45,7 @@ MCT_Nearest_Facet_Find_Nearest(MC_Particle *mc_particle, MC_Domain *domain,
                                int &iteration,      // input/output
                                double &move_factor, // input/output
                                int num_facets_per_cell,
-                               MC_Distance_To_Facet *distance_to_facet,
+                               const double *distance,
                                int &retry /* output */);
 
 HOST_DEVICE_CUDA
@@ -58,12 +56,10 @@ void MCT_Facet_Points_3D_G(const MC_Domain &domain,  // input
                            int *facet_points /* output */);
 
 HOST_DEVICE_CUDA
-double MCT_Nearest_Facet_3D_G_Distance_To_Segment(
-    double plane_tolerance, double facet_normal_dot_direction_cosine, double A,
-    double B, double C, double D, const MC_Vector &facet_coords0,
-    const MC_Vector &facet_coords1, const MC_Vector &facet_coords2,
-    const MC_Vector &coordinate, const DirectionCosine *direction_cosine,
-    bool allow_enter);
+void MCT_Nearest_Facet_3D_G_Distances(const MC_Facet_Planes_Cell &planes,
+                                      const MC_Vector &coordinate,
+                                      const DirectionCosine *direction_cosine,
+                                      double plane_tolerance, double *distance);
 
 } // namespace
 
@@ -255,115 +251,90 @@ void MCT_Facet_Points_3D_G(const MC_Domain &domain,  // input
 } // namespace
 
 namespace {
-///  Calculates the distance from the specified coordinates to the
-///  input segment. This is used to track to the faces of a 3D_G
-///  mesh.
+///  Calculates the distance along the direction cosine from the specified
+///  coordinates to each facet of a 3D_G mesh cell, or _hugeDouble if the
+///  particle does not leave the cell through the facet: the facet faces
+///  away from the direction, the particle is too far behind the facet
+///  plane, or the ray hits the plane outside of the triangle.  The facets
+///  are evaluated side by side without branches so the loop vectorizes.
 HOST_DEVICE_CUDA
-double MCT_Nearest_Facet_3D_G_Distance_To_Segment(
-    double plane_tolerance, double facet_normal_dot_direction_cosine, double A,
-    double B, double C, double D, const MC_Vector &facet_coords0,
-    const MC_Vector &facet_coords1, const MC_Vector &facet_coords2,
-    const MC_Vector &coordinate, const DirectionCosine *direction_cosine,
-    bool allow_enter) {
-  double boundingBox_tolerance = 1e-9;
-  double numerator =
-      -1.0 * (A * coordinate.x + B * coordinate.y + C * coordinate.z + D);
-
-  /* Plane equation: numerator = -P(x,y,z) = -(Ax + By + Cz + D)
-     if: numerator < -1e-8*length(x,y,z)   too negative!
-     if: numerator < 0 && numerator^2 > ( 1e-8*length(x,y,z) )^2   too negative!
-     reverse inequality since squaring function is decreasing for negative
-     inputs. If numerator is just SLIGHTLY negative, then the particle is just
-     outside of the face */
-
-  // Filter out too negative distances
-  if (!allow_enter && numerator < 0.0 &&
-      numerator * numerator > plane_tolerance) {
-    return PhysicalConstants::_hugeDouble;
-  }
-
-  // we have to restrict the solution to within the triangular face
-  double distance = numerator / facet_normal_dot_direction_cosine;
-
-  // see if the intersection point of the ray and the plane is within the
-  // triangular facet
-  MC_Vector intersection_pt;
-  intersection_pt.x = coordinate.x + distance * direction_cosine->alpha;
-  intersection_pt.y = coordinate.y + distance * direction_cosine->beta;
-  intersection_pt.z = coordinate.z + distance * direction_cosine->gamma;
-
-  // if the point is completely below the triangle, it is not in the triangle
-#define IF_POINT_BELOW_CONTINUE(axis)                                          \
-  if (facet_coords0.axis > intersection_pt.axis + boundingBox_tolerance &&     \
-      facet_coords1.axis > intersection_pt.axis + boundingBox_tolerance &&     \
-      facet_coords2.axis > intersection_pt.axis + boundingBox_tolerance) {     \
-    return PhysicalConstants::_hugeDouble;                                     \
-  }
-
-#define IF_POINT_ABOVE_CONTINUE(axis)                                          \
-  if (facet_coords0.axis < intersection_pt.axis - boundingBox_tolerance &&     \
-      facet_coords1.axis < intersection_pt.axis - boundingBox_tolerance &&     \
-      facet_coords2.axis < intersection_pt.axis - boundingBox_tolerance) {     \
-    return PhysicalConstants::_hugeDouble;                                     \
+void MCT_Nearest_Facet_3D_G_Distances(const MC_Facet_Planes_Cell &planes,
+                                      const MC_Vector &coordinate,
+                                      const DirectionCosine *direction_cosine,
+                                      double plane_tolerance,
+                                      double *distance) {
+  const double boundingBox_tolerance = 1e-9;
+  const double x = coordinate.x, y = coordinate.y, z = coordinate.z;
+  const double alpha = direction_cosine->alpha;
+  const double beta = direction_cosine->beta;
+  const double gamma = direction_cosine->gamma;
+
+#ifdef HAVE_OPENMP
+#pragma omp simd
+#endif
+  for (int facet = 0; facet < MC_FACETS_PER_CELL; facet++) {
+    const double A = planes.A[facet], B = planes.B[facet];
+    const double C = planes.C[facet], D = planes.D[facet];
+
+    // Consider only those facets whose outer normals have a positive dot
+    // product with the direction cosine, i.e. the particle is LEAVING the
+    // cell.
+    double facet_normal_dot_direction_cosine =
+        (A * alpha + B * beta + C * gamma);
+    bool leaving = facet_normal_dot_direction_cosine > 0.0;
+
+    /* Plane equation: numerator = -P(x,y,z) = -(Ax + By + Cz + D)
+       if: numerator < -1e-8*length(x,y,z)   too negative!
+       if: numerator < 0 && numerator^2 > ( 1e-8*length(x,y,z) )^2   too
+       negative! reverse inequality since squaring function is decreasing for
+       negative inputs. If numerator is just SLIGHTLY negative, then the
+       particle is just outside of the face */
+    double numerator = -1.0 * (A * x + B * y + C * z + D);
+    bool too_negative =
+        (numerator < 0.0) & (numerator * numerator > plane_tolerance);
+
+    double t = numerator / facet_normal_dot_direction_cosine;
+
+    // The intersection point of the ray and the plane, projected to the
+    // coordinate plane of the in-triangle test.
+    double ix = x + t * alpha;
+    double iy = y + t * beta;
+    double iz = z + t * gamma;
+    const int uAxis = planes.uAxis[facet], vAxis = planes.vAxis[facet];
+    double iu = uAxis == 0 ? ix : (uAxis == 1 ? iy : iz);
+    double iv = vAxis == 0 ? ix : (vAxis == 1 ? iy : iz);
+
+    const double u0 = planes.u0[facet], v0 = planes.v0[facet];
+    const double u1 = planes.u1[facet], v1 = planes.v1[facet];
+    const double u2 = planes.u2[facet], v2 = planes.v2[facet];
+
+    // if the point is completely below or above the triangle on either axis
+    // it is not in the triangle
+    const double iu_plus = iu + boundingBox_tolerance;
+    const double iu_minus = iu - boundingBox_tolerance;
+    const double iv_plus = iv + boundingBox_tolerance;
+    const double iv_minus = iv - boundingBox_tolerance;
+    bool outside_box = ((u0 > iu_plus) & (u1 > iu_plus) & (u2 > iu_plus)) |
+                       ((u0 < iu_minus) & (u1 < iu_minus) & (u2 < iu_minus)) |
+                       ((v0 > iv_plus) & (v1 > iv_plus) & (v2 > iv_plus)) |
+                       ((v0 < iv_minus) & (v1 < iv_minus) & (v2 < iv_minus));
+
+    double cross1 = (u1 - u0) * (iv - v0) - (v1 - v0) * (iu - u0);
+    double cross2 = (u2 - u1) * (iv - v1) - (v2 - v1) * (iu - u1);
+    double cross0 = (u0 - u2) * (iv - v2) - (v0 - v2) * (iu - u2);
+
+    double cross_tol =
+        1e-9 * MC_FABS(cross0 + cross1 + cross2); // cross product tolerance
+
+    bool inside =
+        ((cross0 > -cross_tol) & (cross1 > -cross_tol) &
+         (cross2 > -cross_tol)) |
+        ((cross0 < cross_tol) & (cross1 < cross_tol) & (cross2 < cross_tol));
+
+    distance[facet] = (leaving & !too_negative & !outside_box & inside)
+                          ? t
+                          : PhysicalConstants::_hugeDouble;
   }
-
-  // Is the intersection point inside the triangular facet?  Project to 2D and
-  // see.
-
-  // A^2 + B^2 + C^2 = 1, so max(|A|,|B|,|C|) >= 1/sqrt(3) = 0.577
-  // (all coefficients can't be small)
-  double cross0 = 0, cross1 = 0, cross2 = 0;
-  if (C < -0.5 || C > 0.5) {
-    IF_POINT_BELOW_CONTINUE(x);
-    IF_POINT_ABOVE_CONTINUE(x);
-    IF_POINT_BELOW_CONTINUE(y);
-    IF_POINT_ABOVE_CONTINUE(y);
-
-#define AB_CROSS_AC(ax, ay, bx, by, cx, cy)                                    \
-  ((bx - ax) * (cy - ay) - (by - ay) * (cx - ax))
-
-    cross1 = AB_CROSS_AC(facet_coords0.x, facet_coords0.y, facet_coords1.x,
-                         facet_coords1.y, intersection_pt.x, intersection_pt.y);
-    cross2 = AB_CROSS_AC(facet_coords1.x, facet_coords1.y, facet_coords2.x,
-                         facet_coords2.y, intersection_pt.x, intersection_pt.y);
-    cross0 = AB_CROSS_AC(facet_coords2.x, facet_coords2.y, facet_coords0.x,
-                         facet_coords0.y, intersection_pt.x, intersection_pt.y);
-
-  } else if (B < -0.5 || B > 0.5) {
-    IF_POINT_BELOW_CONTINUE(x);
-    IF_POINT_ABOVE_CONTINUE(x);
-    IF_POINT_BELOW_CONTINUE(z);
-    IF_POINT_ABOVE_CONTINUE(z);
-
-    cross1 = AB_CROSS_AC(facet_coords0.z, facet_coords0.x, facet_coords1.z,
-                         facet_coords1.x, intersection_pt.z, intersection_pt.x);
-    cross2 = AB_CROSS_AC(facet_coords1.z, facet_coords1.x, facet_coords2.z,
-                         facet_coords2.x, intersection_pt.z, intersection_pt.x);
-    cross0 = AB_CROSS_AC(facet_coords2.z, facet_coords2.x, facet_coords0.z,
-                         facet_coords0.x, intersection_pt.z, intersection_pt.x);
-
-  } else if (A < -0.5 || A > 0.5) {
-    IF_POINT_BELOW_CONTINUE(z);
-    IF_POINT_ABOVE_CONTINUE(z);
-    IF_POINT_BELOW_CONTINUE(y);
-    IF_POINT_ABOVE_CONTINUE(y);
-
-    cross1 = AB_CROSS_AC(facet_coords0.y, facet_coords0.z, facet_coords1.y,
-                         facet_coords1.z, intersection_pt.y, intersection_pt.z);
-    cross2 = AB_CROSS_AC(facet_coords1.y, facet_coords1.z, facet_coords2.y,
-                         facet_coords2.z, intersection_pt.y, intersection_pt.z);
-    cross0 = AB_CROSS_AC(facet_coords2.y, facet_coords2.z, facet_coords0.y,
-                         facet_coords0.z, intersection_pt.y, intersection_pt.z);
-  }
-
-  double cross_tol =
-      1e-9 * MC_FABS(cross0 + cross1 + cross2); // cross product tolerance
-
-  if ((cross0 > -cross_tol && cross1 > -cross_tol && cross2 > -cross_tol) ||
-      (cross0 < cross_tol && cross1 < cross_tol && cross2 < cross_tol)) {
-    return distance;
-  }
-  return PhysicalConstants::_hugeDouble;
 }
 } // namespace
 
@@ -401,46 +372,46 @@ HOST_DEVICE_END
 
 namespace {
 ///  Loop over all the facets, return the minimum distance.
+///
+///  The smallest positive distance wins, on ties the facet with the
+///  highest index.  Without any positive distance the largest negative (or
+///  zero) distance wins, on ties the facet with the lowest index.  Both
+///  extremes are found with vectorized min/max reductions first.
 HOST_DEVICE_CUDA
-MC_Nearest_Facet
-MCT_Nearest_Facet_Find_Nearest(int num_facets_per_cell,
-                               MC_Distance_To_Facet *distance_to_facet) {
+MC_Nearest_Facet MCT_Nearest_Facet_Find_Nearest(int num_facets_per_cell,
+                                                const double *distance) {
   MC_Nearest_Facet nearest_facet;
 
+  double min_positive = nearest_facet.distance_to_facet;
   // largest negative distance (smallest magnitude, but negative)
-  MC_Nearest_Facet nearest_negative_facet;
-  nearest_negative_facet.distance_to_facet = -PhysicalConstants::_hugeDouble;
+  double max_negative = -PhysicalConstants::_hugeDouble;
 
-  // Determine the facet that is closest to the specified coordinates.
+#ifdef HAVE_OPENMP
+#pragma omp simd reduction(min : min_positive) reduction(max : max_negative)
+#endif
   for (int facet_index = 0; facet_index < num_facets_per_cell; facet_index++) {
-    if (distance_to_facet[facet_index].distance > 0.0) {
-      if (distance_to_facet[facet_index].distance <=
-          nearest_facet.distance_to_facet) {
-        nearest_facet.distance_to_facet =
-            distance_to_facet[facet_index].distance;
-        nearest_facet.facet = facet_index;
-      }
-    } else // zero or negative distance
-    {
-      if (distance_to_facet[facet_index].distance >
-          nearest_negative_facet.distance_to_facet) {
-        // smallest in magnitude, but negative
-        nearest_negative_facet.distance_to_facet =
-            distance_to_facet[facet_index].distance;
-        nearest_negative_facet.facet = facet_index;
-      }
-    }
+    double d = distance[facet_index];
+    min_positive = (d > 0.0 && d < min_positive) ? d : min_positive;
+    max_negative = (d <= 0.0 && d > max_negative) ? d : max_negative;
   }
 
-  if (nearest_facet.distance_to_facet == PhysicalConstants::_hugeDouble) {
-    if (nearest_negative_facet.distance_to_facet !=
-        -PhysicalConstants::_hugeDouble) {
-      // no positive solution, so allow a negative solution, that had really
-      // small magnitude.
-      nearest_facet.distance_to_facet =
-          nearest_negative_facet.distance_to_facet;
-      nearest_facet.facet = nearest_negative_facet.facet;
+  for (int facet_index = 0; facet_index < num_facets_per_cell; facet_index++) {
+    if (distance[facet_index] > 0.0 && distance[facet_index] == min_positive)
+      nearest_facet.facet = facet_index;
+  }
+  nearest_facet.distance_to_facet = min_positive;
+
+  if (nearest_facet.distance_to_facet == PhysicalConstants::_hugeDouble &&
+      max_negative != -PhysicalConstants::_hugeDouble) {
+    // no positive solution, so allow a negative solution, that had really
+    // small magnitude.
+    for (int facet_index = num_facets_per_cell - 1; facet_index >= 0;
+         facet_index--) {
+      if (distance[facet_index] <= 0.0 &&
+          distance[facet_index] == max_negative)
+        nearest_facet.facet = facet_index;
     }
+    nearest_facet.distance_to_facet = max_negative;
   }
 
   return nearest_facet;
@@ -456,10 +427,10 @@ MCT_Nearest_Facet_Find_Nearest(MC_Particle *mc_particle, MC_Domain *domain,
                                int &iteration,      // input/output
                                double &move_factor, // input/output
                                int num_facets_per_cell,
-                               MC_Distance_To_Facet *distance_to_facet,
+                               const double *distance,
                                int &retry /* output */) {
   MC_Nearest_Facet nearest_facet =
-      MCT_Nearest_Facet_Find_Nearest(num_facets_per_cell, distance_to_facet);
+      MCT_Nearest_Facet_Find_Nearest(num_facets_per_cell, distance);
 
   const int max_allowed_segments = 10000000;
 
@@ -510,14 +481,14 @@ MC_Nearest_Facet
 MCT_Nearest_Facet_3D_G(MC_Particle *mc_particle, MC_Domain &domain,
                        MC_Location &location, MC_Vector &coordinate,
                        const DirectionCosine *direction_cosine) {
-  // int my_task_num = mc_particle == NULL ? 0 : mc_particle->task;
-  MC_Vector *facet_coords[3];
   int iteration = 0;
   double move_factor = 0.5 * PhysicalConstants::_smallDouble;
 
   // Initialize some data for the unstructured, hexahedral mesh.
   int num_facets_per_cell =
       domain.mesh._cellConnectivity[location.cell].num_facets;
+  const MC_Facet_Planes_Cell &planes =
+      domain.mesh._cellFacetPlanes[location.cell];
 
   while (true) // will break out when distance is found
   {
@@ -527,59 +498,15 @@ MCT_Nearest_Facet_3D_G(MC_Particle *mc_particle, MC_Domain &domain,
         1e-16 * (coordinate.x * coordinate.x + coordinate.y * coordinate.y +
                  coordinate.z * coordinate.z);
 
-    MC_Distance_To_Facet distance_to_facet[24];
-
-    for (int facet_index = 0; facet_index < num_facets_per_cell;
-         facet_index++) {
-      // to-do
-      // mcco->distance_to_facet->task[my_task_num].facet[facet_index].distance =
-      // PhysicalConstants::_hugeDouble;
-      distance_to_facet[facet_index].distance = PhysicalConstants::_hugeDouble;
-
-      MC_General_Plane &plane =
-          domain.mesh._cellGeometry[location.cell]._facet[facet_index];
-
-      double facet_normal_dot_direction_cosine =
-          (plane.A * direction_cosine->alpha +
-           plane.B * direction_cosine->beta +
-           plane.C * direction_cosine->gamma);
-
-      // Consider only those facets whose outer normals have
-      // a positive dot product with the direction cosine.
-      // I.e. the particle is LEAVING the cell.
-      if (facet_normal_dot_direction_cosine <= 0.0) {
-        continue;
-      }
-
-      /* profiling with gprof showed that putting a call to
-         MC_Facet_Coordinates_3D_G
-         slowed down the code by about 10%, so we get the facet coords "by
-         hand." */
-      int *point = domain.mesh._cellConnectivity[location.cell]
-                       ._facet[facet_index]
-                       .point;
-      facet_coords[0] = &domain.mesh._node[point[0]];
-      facet_coords[1] = &domain.mesh._node[point[1]];
-      facet_coords[2] = &domain.mesh._node[point[2]];
-
-      double t = MCT_Nearest_Facet_3D_G_Distance_To_Segment(
-          plane_tolerance, facet_normal_dot_direction_cosine, plane.A, plane.B,
-          plane.C, plane.D, *facet_coords[0], *facet_coords[1],
-          *facet_coords[2], coordinate, direction_cosine, false);
-
-      // to-do
-      // mcco->distance_to_facet->task[my_task_num].facet[facet_index].distance =
-      // t;
-      distance_to_facet[facet_index].distance = t;
-    } // for facet_index
+    double distance[MC_FACETS_PER_CELL];
+    MCT_Nearest_Facet_3D_G_Distances(planes, coordinate, direction_cosine,
+                                     plane_tolerance, distance);
 
     int retry = 0;
 
     MC_Nearest_Facet nearest_facet = MCT_Nearest_Facet_Find_Nearest(
         mc_particle, &domain, &location, coordinate, iteration, move_factor,
-        num_facets_per_cell,
-        // to-do       mcco->distance_to_facet->task[my_task_num].facet,
-        distance_to_facet, retry);
+        num_facets_per_cell, distance, retry);
 
     if (!retry)
       return nearest_facet;
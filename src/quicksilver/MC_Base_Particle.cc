@@ -1,4 +1,6 @@
 #include "MC_Base_Particle.hh"
+#include "MC_Compact_Particle.hh"
+#include <cstring>
 
 #define MCP_DATA_MEMBER_OLD(member, buffer, index, mode)                       \
   {                                                                            \
@@ -80,6 +82,27 @@ void MC_Base_Particle::Serialize(int *int_data, double *float_data,
                                  char *char_data, int &int_index,
                                  int &float_index, int &char_index,
                                  MC_Data_Member_Operation::Enum mode) {
+  if (compact_comm) {
+    // The whole particle goes to the char data as one compact record.
+    MC_Compact_Particle compact;
+    if (mode == MC_Data_Member_Operation::Pack) {
+      compact.pack(*this);
+      memcpy(&char_data[char_index], &compact, sizeof(compact));
+    } else if (mode == MC_Data_Member_Operation::Unpack ||
+               mode == MC_Data_Member_Operation::Reset) {
+      // The char data has no alignment, so the record is copied out byte
+      // by byte; Reset unpacks an all zero record.
+      if (mode == MC_Data_Member_Operation::Unpack)
+        memcpy(static_cast<void *>(&compact), &char_data[char_index],
+               sizeof(compact));
+      else
+        memset(static_cast<void *>(&compact), 0, sizeof(compact));
+      compact.unpack(*this);
+    }
+    char_index += sizeof(compact);
+    return;
+  }
+
   MCP_DATA_MEMBER_OLD(coordinate.x, float_data, float_index, mode);
   MCP_DATA_MEMBER_OLD(coordinate.y, float_data, float_index, mode);
   MCP_DATA_MEMBER_OLD(coordinate.z, float_data, float_index, mode);
@@ -109,14 +132,16 @@ void MC_Base_Particle::Serialize(int *int_data, double *float_data,
 int MC_Base_Particle::num_base_ints = 0;
 int MC_Base_Particle::num_base_floats = 0;
 int MC_Base_Particle::num_base_chars = 0;
+bool MC_Base_Particle::compact_comm = false;
 
 //----------------------------------------------------------------------------------------------------------------------
 //  Updates the num base counts by creating an instance and callingthe broadcast
 //  routine.
 //
 //----------------------------------------------------------------------------------------------------------------------
-void MC_Base_Particle::Update_Counts() {
+void MC_Base_Particle::Update_Counts(bool compact) {
   MC_Base_Particle base_particle;
+  compact_comm = compact;
   num_base_ints = 0;
   num_base_floats = 0;
   num_base_chars = 0;
@@ -17,7 +17,9 @@ public:
 class MC_Base_Particle {
 public:
   static void Cycle_Setup();
-  static void Update_Counts();
+  // With compact = true the particle buffers carry MC_Compact_Particle
+  // records instead of the full particle.
+  static void Update_Counts(bool compact = false);
 
   HOST_DEVICE_CUDA
   MC_Base_Particle();
@@ -26,6 +28,8 @@ public:
   HOST_DEVICE_CUDA
   MC_Base_Particle(const MC_Base_Particle &particle);
 
+  HOST_DEVICE_CUDA
+  MC_Base_Particle &operator=(const MC_Base_Particle &) = default;
   HOST_DEVICE_CUDA
   MC_Base_Particle &operator=(const MC_Particle &);
 
@@ -81,6 +85,7 @@ public:
   static int num_base_ints;   // Number of ints for communication
   static int num_base_floats; // Number of floats for communication
   static int num_base_chars;  // Number of chars for communication
+  static bool compact_comm;   // Communicate MC_Compact_Particle records
 
 private:
 };
@@ -13,6 +13,10 @@ public:
   // pre-computed cross-sections for material
   double *_total; // [energy groups]
 
+  // The MonteCarlo::_crossSectionEpoch _total was last brought up to
+  // date in (0 = stale).
+  uint64_t _crossSectionEpoch;
+
   double _volume;            // cell volume
   double _cellNumberDensity; // number density of ions in cel
 
@@ -25,7 +29,7 @@ private:
 };
 
 inline MC_Cell_State::MC_Cell_State()
-    : _material(0), _total(), _volume(0.0), _cellNumberDensity(0.0),
-      _sourceTally(0) {}
+    : _material(0), _total(), _crossSectionEpoch(0), _volume(0.0),
+      _cellNumberDensity(0.0), _sourceTally(0) {}
 
 #endif
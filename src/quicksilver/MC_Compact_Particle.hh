@@ -0,0 +1,166 @@
+#ifndef MC_COMPACT_PARTICLE_HH
+#define MC_COMPACT_PARTICLE_HH
+
+#include "DeclareMacro.hh"
+#include "MC_Base_Particle.hh"
+#include "portability.hh"
+#include "qs_assert.hh"
+#include <cmath>
+
+//---------------------------------------------------------------
+// MC_Compact_Particle is a mixed precision MC_Base_Particle of 88
+// instead of 136 bytes.  Vaults with the Compact layout store
+// particles in this form, and with compactComm the particle
+// buffers send it between ranks (the queues of threadRanks still
+// pass full particles).  Tracking still works on a full precision
+// MC_Particle, unpacked when a particle is loaded and packed again
+// when it is put back.
+//
+// The position, kinetic energy, random number seed and identifier
+// keep their full width: the cell and facet geometry is sensitive
+// to the position, the energy group lookup to the energy, and the
+// seed and identifier have to be exact.  The rest is reduced:
+//  - the direction is encoded on the octahedron in two 16 bit
+//    integers (each cosine within 1e-4), and the velocity
+//    is rebuilt as the speed, a float, times that direction;
+//  - weight, time to census, age and mean free paths to the next
+//    collision are floats;
+//  - the counters are 32 bit, species, breed and last event bytes;
+//  - domain and cell share 32 bits (cell < 2^24, domain < 2^8).
+//--------------------------------------------------------------
+
+class MC_Compact_Particle {
+public:
+  HOST_DEVICE_CUDA
+  MC_Compact_Particle() : species(-1) {}
+
+  HOST_DEVICE_CUDA
+  explicit MC_Compact_Particle(const MC_Base_Particle &particle) {
+    pack(particle);
+  }
+
+  HOST_DEVICE_CUDA
+  void pack(const MC_Base_Particle &particle);
+
+  HOST_DEVICE_CUDA
+  void unpack(MC_Base_Particle &particle) const;
+
+  MC_Vector coordinate;
+  double kinetic_energy;
+  uint64_t random_number_seed;
+  uint64_t identifier;
+  float speed;
+  float weight;
+  float time_to_census;
+  float age;
+  float num_mean_free_paths;
+  uint32_t num_segments;
+  int32_t num_collisions;
+  uint32_t location;     // cell in the low 24 bits, domain in the high 8
+  uint16_t direction[2]; // octahedral encoding of the unit velocity
+  int8_t species;
+  uint8_t breed;
+  uint8_t last_event;
+  uint8_t padding;
+
+  static const int cellBits = 24;
+};
+
+static_assert(sizeof(MC_Compact_Particle) == 88,
+              "MC_Compact_Particle is not packed as documented");
+
+namespace MC_Compact {
+// [-1, 1] to 16 bits and back.
+HOST_DEVICE_CUDA
+inline uint16_t quantize(double value) {
+  return (uint16_t)floor((value * 0.5 + 0.5) * 65535.0 + 0.5);
+}
+
+HOST_DEVICE_CUDA
+inline double dequantize(uint16_t value) { return value / 65535.0 * 2.0 - 1.0; }
+
+HOST_DEVICE_CUDA
+inline double signNotZero(double value) { return (value < 0.0) ? -1.0 : 1.0; }
+} // namespace MC_Compact
+
+// -----------------------------------------------------------------------
+HOST_DEVICE_CUDA
+inline void MC_Compact_Particle::pack(const MC_Base_Particle &particle) {
+  coordinate = particle.coordinate;
+  kinetic_energy = particle.kinetic_energy;
+  random_number_seed = particle.random_number_seed;
+  identifier = particle.identifier;
+
+  // Project the direction onto the octahedron |u| + |v| + |w| = 1 and fold
+  // the lower half over the upper one.
+  const MC_Vector &velocity = particle.velocity;
+  double norm = fabs(velocity.x) + fabs(velocity.y) + fabs(velocity.z);
+  double uu = 0.0;
+  double vv = 0.0;
+  if (norm > 0.0) {
+    uu = velocity.x / norm;
+    vv = velocity.y / norm;
+    if (velocity.z < 0.0) {
+      double foldU = (1.0 - fabs(vv)) * MC_Compact::signNotZero(uu);
+      vv = (1.0 - fabs(uu)) * MC_Compact::signNotZero(vv);
+      uu = foldU;
+    }
+  }
+  direction[0] = MC_Compact::quantize(uu);
+  direction[1] = MC_Compact::quantize(vv);
+  speed = (float)velocity.Length();
+
+  weight = (float)particle.weight;
+  time_to_census = (float)particle.time_to_census;
+  age = (float)particle.age;
+  num_mean_free_paths = (float)particle.num_mean_free_paths;
+  num_segments = (uint32_t)particle.num_segments;
+  num_collisions = particle.num_collisions;
+
+  qs_assert(particle.cell >= 0 && particle.cell < (1 << cellBits));
+  qs_assert(particle.domain >= 0 && particle.domain < (1 << (32 - cellBits)));
+  location = ((uint32_t)particle.domain << cellBits) | (uint32_t)particle.cell;
+
+  species = (int8_t)particle.species;
+  breed = (uint8_t)particle.breed;
+  last_event = (uint8_t)particle.last_event;
+  padding = 0;
+}
+
+// -----------------------------------------------------------------------
+HOST_DEVICE_CUDA
+inline void MC_Compact_Particle::unpack(MC_Base_Particle &particle) const {
+  particle.coordinate = coordinate;
+  particle.kinetic_energy = kinetic_energy;
+  particle.random_number_seed = random_number_seed;
+  particle.identifier = identifier;
+
+  double uu = MC_Compact::dequantize(direction[0]);
+  double vv = MC_Compact::dequantize(direction[1]);
+  double ww = 1.0 - fabs(uu) - fabs(vv);
+  if (ww < 0.0) {
+    double foldU = (1.0 - fabs(vv)) * MC_Compact::signNotZero(uu);
+    vv = (1.0 - fabs(uu)) * MC_Compact::signNotZero(vv);
+    uu = foldU;
+  }
+  double factor = speed / sqrt(uu * uu + vv * vv + ww * ww);
+  particle.velocity.x = factor * uu;
+  particle.velocity.y = factor * vv;
+  particle.velocity.z = factor * ww;
+
+  particle.weight = weight;
+  particle.time_to_census = time_to_census;
+  particle.age = age;
+  particle.num_mean_free_paths = num_mean_free_paths;
+  particle.num_segments = num_segments;
+  particle.num_collisions = num_collisions;
+
+  particle.cell = (int)(location & ((1u << cellBits) - 1));
+  particle.domain = (int)(location >> cellBits);
+
+  particle.species = species;
+  particle.breed = breed;
+  particle.last_event = (MC_Tally_Event::Enum)last_event;
+}
+
+#endif
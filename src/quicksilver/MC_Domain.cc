@@ -107,6 +107,7 @@ MC_Mesh_Domain::MC_Mesh_Domain(
   { // limit scope
     // initialize _cellGeometry
     _cellGeometry.resize(_cellConnectivity.size(), VAR_MEM);
+    _cellFacetPlanes.resize(_cellConnectivity.size(), VAR_MEM);
 
     // First, we need to count up the total number of facets of all
     // cells in this domain and initialize the BulkStorage
@@ -132,6 +133,8 @@ MC_Mesh_Domain::MC_Mesh_Domain(
         const MC_Vector &r1 = _node[nodeIndex1];
         const MC_Vector &r2 = _node[nodeIndex2];
         _cellGeometry[iCell]._facet[jFacet] = MC_General_Plane(r0, r1, r2);
+        _cellFacetPlanes[iCell].setFacet(
+            jFacet, _cellGeometry[iCell]._facet[jFacet], r0, r1, r2);
       }
     }
   } // limit scope
@@ -323,8 +326,9 @@ MC_Domain::MC_Domain(const MeshPartition &meshPartition,
       global_domain(meshPartition.domainGid()),
       mesh(meshPartition, grid, ddc, getBoundaryCondition(params)) {
   cell_state.resize(mesh._cellGeometry.size(), VAR_MEM);
-  _cachedCrossSectionStorage.setCapacity(cell_state.size() * numEnergyGroups,
-                                         VAR_MEM);
+  _cachedCrossSectionStorage.setCapacity(
+      cell_state.size() * numEnergyGroups,
+      MemoryControl::AllocationPolicy::ARENA_MEM);
 
   for (unsigned ii = 0; ii < cell_state.size(); ++ii) {
     cell_state[ii]._volume = cellVolume(mesh._cellConnectivity[ii], mesh._node);
@@ -345,6 +349,7 @@ MC_Domain::MC_Domain(const MeshPartition &meshPartition,
     //  set this density to 1.0 so that the totalCrossSection will be
     //  as requested by the user.
     cell_state[ii]._cellNumberDensity = 1.0;
+    invalidateCrossSections(ii);
 
     MC_Vector cellCenter =
         findCellCenter(mesh._cellConnectivity[ii], mesh._node);
@@ -29,6 +29,7 @@ public:
   qs_vector<MC_Facet_Adjacency_Cell> _cellConnectivity;
 
   qs_vector<MC_Facet_Geometry_Cell> _cellGeometry;
+  qs_vector<MC_Facet_Planes_Cell> _cellFacetPlanes;
 
   BulkStorage<MC_Facet_Adjacency> _connectivityFacetStorage;
   BulkStorage<int> _connectivityPointStorage;
@@ -65,6 +66,12 @@ public:
             const MaterialDatabase &materialDatabase, int numEnergyGroups);
 
   void clearCrossSectionCache(int numEnergyGroups);
+
+  // Marks the cached cross sections of a cell stale.  Call after changing
+  // the material or number density of the cell.
+  void invalidateCrossSections(int cellIndex) {
+    cell_state[cellIndex]._crossSectionEpoch = 0;
+  }
 };
 
 #endif
@@ -64,8 +64,8 @@ MC_Tally_Event::Enum MC_Facet_Crossing_Event(MC_Particle &mc_particle,
     processingVault->putParticle(mc_particle, particle_index);
 
     // Push neighbor rank and mc_particle onto the send queue
-    monteCarlo->_particleVaultContainer->getSendQueue()->push(neighbor_rank,
-                                                              particle_index);
+    monteCarlo->_particleVaultContainer->getSendQueue()->push(
+        neighbor_rank, particle_index, mc_particle.task);
   }
 
   return mc_particle.last_event;
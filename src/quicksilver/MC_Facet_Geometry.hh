@@ -44,4 +44,57 @@ public:
   int _size;
 };
 
+// The 24 triangular facets of a cell laid out for the nearest facet search:
+// struct of arrays indexed by facet, so that the distances to all facets
+// are computed by one vectorized loop.  Besides the plane, each facet keeps
+// its corners projected onto the coordinate plane the in-triangle test
+// uses, (x,y), (z,x) or (y,z) depending on the largest normal component,
+// and the axes (0 = x, 1 = y, 2 = z) of that projection.
+#define MC_FACETS_PER_CELL 24
+
+class MC_Facet_Planes_Cell {
+public:
+  double A[MC_FACETS_PER_CELL];
+  double B[MC_FACETS_PER_CELL];
+  double C[MC_FACETS_PER_CELL];
+  double D[MC_FACETS_PER_CELL];
+  double u0[MC_FACETS_PER_CELL], v0[MC_FACETS_PER_CELL];
+  double u1[MC_FACETS_PER_CELL], v1[MC_FACETS_PER_CELL];
+  double u2[MC_FACETS_PER_CELL], v2[MC_FACETS_PER_CELL];
+  int uAxis[MC_FACETS_PER_CELL];
+  int vAxis[MC_FACETS_PER_CELL];
+
+  void setFacet(int facet, const MC_General_Plane &plane, const MC_Vector &r0,
+                const MC_Vector &r1, const MC_Vector &r2) {
+    A[facet] = plane.A;
+    B[facet] = plane.B;
+    C[facet] = plane.C;
+    D[facet] = plane.D;
+
+    // A^2 + B^2 + C^2 = 1, so max(|A|,|B|,|C|) >= 1/sqrt(3) = 0.577
+    if (plane.C < -0.5 || plane.C > 0.5) {
+      uAxis[facet] = 0;
+      vAxis[facet] = 1;
+    } else if (plane.B < -0.5 || plane.B > 0.5) {
+      uAxis[facet] = 2;
+      vAxis[facet] = 0;
+    } else {
+      uAxis[facet] = 1;
+      vAxis[facet] = 2;
+    }
+
+    u0[facet] = component(r0, uAxis[facet]);
+    v0[facet] = component(r0, vAxis[facet]);
+    u1[facet] = component(r1, uAxis[facet]);
+    v1[facet] = component(r1, vAxis[facet]);
+    u2[facet] = component(r2, uAxis[facet]);
+    v2[facet] = component(r2, vAxis[facet]);
+  }
+
+private:
+  static double component(const MC_Vector &r, int axis) {
+    return axis == 0 ? r.x : (axis == 1 ? r.y : r.z);
+  }
+};
+
 #endif
@@ -3,16 +3,19 @@
 #include "MC_Processor_Info.hh"
 #include "MonteCarlo.hh"
 #include "portability.hh"
+#include <algorithm>
 #include <vector>
 
 const char *mc_fast_timer_names[MC_Fast_Timer::Num_Timers] = {
     "main",
     "cycleInit",
+    "cycleInit_VaultSort",
     "cycleTracking",
     "cycleTracking_Kernel",
     "cycleTracking_MPI",
     "cycleTracking_Test_Done",
-    "cycleFinalize"};
+    "cycleFinalize",
+    "cycleFinalize_Tallies"};
 
 static double mc_std_dev(uint64_t const data[], int const nelm);
 
@@ -29,6 +32,13 @@ static double mc_std_dev(uint64_t const data[], int const nelm) {
   return sqrt((double)sum_deviation / nelm);
 }
 
+// The vault sort timer only runs with --vaultSort, so its row is left out of
+// the reports when it was never started.
+static bool mc_skip_timer_row(const MC_Fast_Timer timers[], int timer_index) {
+  return timer_index == MC_Fast_Timer::cycleInit_VaultSort &&
+         timers[timer_index].numCalls == 0;
+}
+
 void MC_Fast_Timer_Container::Print_Last_Cycle_Heading(int mpi_rank) {
 #ifdef DISABLE_TIMERS
   return;
@@ -97,7 +107,7 @@ void MC_Fast_Timer_Container::Cumulative_Report(int mpi_rank, int num_ranks,
               1, MPI_UINT64_T, 0, comm_world);
 
     uint64_t ave_clock = sum_clock[timer_index] / num_ranks;
-    if (mpi_rank == 0) {
+    if (mpi_rank == 0 && !mc_skip_timer_row(this->timers, timer_index)) {
       fprintf(stdout, "%-25s %12lu %12.3e %12.3e %12.3e %12.3e %12.2f\n",
               mc_fast_timer_names[timer_index],
               (unsigned long)this->timers[timer_index].numCalls,
@@ -107,12 +117,12 @@ void MC_Fast_Timer_Container::Cumulative_Report(int mpi_rank, int num_ranks,
               (100.0 * ave_clock) / (max_clock[timer_index] + 1.0e-80));
     }
   }
+  double figureOfMerit = Figure_Of_Merit(comm_world, numSegments);
   if (mpi_rank == 0) {
-    int cycleTracking_Index = 2;
-    fprintf(stdout, "%-25s %12.3e %-25s\n", "Figure Of Merit",
-            (numSegments / (max_clock[cycleTracking_Index] * 1e-6)),
+    fprintf(stdout, "%-25s %12.3e %-25s\n", "Figure Of Merit", figureOfMerit,
             "[Num Segments / Cycle Tracking Time]");
   }
+  Thread_Load_Report(cumulativeLoad, mpi_rank, comm_world);
 }
 
 void MC_Fast_Timer_Container::Last_Cycle_Report(int report_time, int mpi_rank,
@@ -153,7 +163,7 @@ void MC_Fast_Timer_Container::Last_Cycle_Report(int report_time, int mpi_rank,
                 1, MPI_UINT64_T, 0, comm_world);
 
       uint64_t ave_clock = sum_clock[timer_index] / num_ranks;
-      if (mpi_rank == 0) {
+      if (mpi_rank == 0 && !mc_skip_timer_row(this->timers, timer_index)) {
         fprintf(stdout, "%-25s %12lu %12.3e %12.3e %12.3e %12.3e %12.2f\n",
                 mc_fast_timer_names[timer_index],
                 (unsigned long)this->timers[timer_index].numCalls,
@@ -163,13 +173,81 @@ void MC_Fast_Timer_Container::Last_Cycle_Report(int report_time, int mpi_rank,
                 (100.0 * ave_clock) / (max_clock[timer_index] + 1.0e-80));
       }
     }
+    Thread_Load_Report(threadLoad, mpi_rank, comm_world);
   }
+  Accumulate_Thread_Load();
   Clear_Last_Cycle_Timers();
 }
 
+// Reports the load imbalance of the tracking threads in load: the busy
+// time of the slowest thread over the average busy time of all threads on
+// all ranks (1.0 is perfect balance).  Printed on its own line after the
+// timer tables.
+void MC_Fast_Timer_Container::Thread_Load_Report(const MC_Thread_Load &load,
+                                                 int mpi_rank,
+                                                 MPI_Comm comm_world) {
+  int numThreads = load.busyClock.size();
+  if (numThreads == 0)
+    return;
+
+  uint64_t local[5] = {0, 0, (uint64_t)numThreads, load.numChunks,
+                       load.numSteals};
+  uint64_t min_busy = load.busyClock[0];
+  for (int thread = 0; thread < numThreads; thread++) {
+    local[0] = std::max(local[0], load.busyClock[thread]);
+    local[1] += load.busyClock[thread];
+    min_busy = std::min(min_busy, load.busyClock[thread]);
+  }
+
+  uint64_t max_busy = 0, global_min_busy = 0;
+  uint64_t sum[5];
+  mpiReduce(&local[0], &max_busy, 1, MPI_UINT64_T, MPI_MAX, 0, comm_world);
+  mpiReduce(&min_busy, &global_min_busy, 1, MPI_UINT64_T, MPI_MIN, 0,
+            comm_world);
+  mpiReduce(local, sum, 5, MPI_UINT64_T, MPI_SUM, 0, comm_world);
+
+  if (mpi_rank == 0) {
+    double ave_busy = (double)sum[1] / sum[2];
+    fprintf(stdout,
+            "%-25s threads %lu  busy microSecs min %.3e avg %.3e max %.3e  "
+            "imbalance %.3f  chunks %lu  steals %lu\n",
+            "cycleTracking_Load", (unsigned long)sum[2],
+            (double)global_min_busy, ave_busy, (double)max_busy,
+            max_busy / (ave_busy + 1.0e-80), (unsigned long)sum[3],
+            (unsigned long)sum[4]);
+  }
+}
+
+// Adds the load of the last cycle to the cumulative load and clears it.
+void MC_Fast_Timer_Container::Accumulate_Thread_Load() {
+  std::vector<uint64_t> &busy = cumulativeLoad.busyClock;
+  if (busy.size() < threadLoad.busyClock.size())
+    busy.resize(threadLoad.busyClock.size(), 0);
+  for (size_t thread = 0; thread < threadLoad.busyClock.size(); thread++)
+    busy[thread] += threadLoad.busyClock[thread];
+  cumulativeLoad.numChunks += threadLoad.numChunks;
+  cumulativeLoad.numSteals += threadLoad.numSteals;
+
+  threadLoad = MC_Thread_Load();
+}
+
 void MC_Fast_Timer_Container::Clear_Last_Cycle_Timers() {
   for (int timer_index = 0; timer_index < MC_Fast_Timer::Num_Timers;
        timer_index++) {
     this->timers[timer_index].lastCycleClock = 0;
   }
 }
+
+// Segments per second of cycle tracking time on the slowest rank, the same
+// figure of merit printed at the end of the Cumulative_Report.
+double MC_Fast_Timer_Container::Figure_Of_Merit(MPI_Comm comm_world,
+                                                uint64_t numSegments) {
+  uint64_t trackingClock =
+      this->timers[MC_Fast_Timer::cycleTracking].cumulativeClock;
+  uint64_t max_clock = 0;
+
+  mpiAllreduce(&trackingClock, &max_clock, 1, MPI_UINT64_T, MPI_MAX,
+               comm_world);
+
+  return numSegments / (max_clock * 1e-6);
+}
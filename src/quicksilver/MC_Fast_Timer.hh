@@ -8,6 +8,7 @@
 
 #include "portability.hh" // needed for uint64_t in this file
 #include "utilsMpi.hh"    // needed for MPI_Comm type in this file
+#include <vector>
 
 class MC_Fast_Timer {
 public:
@@ -31,15 +32,29 @@ public:
   enum Enum {
     main = 0,
     cycleInit,
+    cycleInit_VaultSort,
     cycleTracking,
     cycleTracking_Kernel,
     cycleTracking_MPI,
     cycleTracking_Test_Done,
     cycleFinalize,
+    cycleFinalize_Tallies,
     Num_Timers
   };
 };
 
+// How evenly the tracking work of the last cycle was spread over the
+// threads of this rank.  Only filled in when the work stealing scheduler
+// tracks the particles.
+class MC_Thread_Load {
+public:
+  std::vector<uint64_t> busyClock; // microseconds per thread
+  uint64_t numChunks;
+  uint64_t numSteals;
+
+  MC_Thread_Load() : busyClock(), numChunks(0), numSteals(0) {}
+};
+
 class MC_Fast_Timer_Container {
 public:
   MC_Fast_Timer_Container(){}; // constructor
@@ -48,10 +63,17 @@ public:
   void Last_Cycle_Report(int report_time, int mpi_rank, int num_ranks,
                          MPI_Comm comm_world);
   void Clear_Last_Cycle_Timers();
+  double Figure_Of_Merit(MPI_Comm comm_world, uint64_t numSegments);
   MC_Fast_Timer
       timers[MC_Fast_Timer::Num_Timers]; // timers for various routines
+  MC_Thread_Load threadLoad;              // load balance of the last cycle
 
 private:
+  MC_Thread_Load cumulativeLoad; // load balance of all cycles so far
+
+  void Thread_Load_Report(const MC_Thread_Load &load, int mpi_rank,
+                          MPI_Comm comm_world);
+  void Accumulate_Thread_Load();
   void Print_Cumulative_Heading(int mpi_rank);
   void Print_Last_Cycle_Heading(int mpi_rank);
 };
@@ -6,18 +6,21 @@
 #include "MC_Processor_Info.hh"
 #include "MonteCarlo.hh"
 #include "NVTX_Range.hh"
+#include "ParticleVault.hh"
 #include "ParticleVaultContainer.hh"
 #include "SendQueue.hh"
 #include "Tallies.hh"
 #include "macros.hh"
 #include "utilsMpi.hh"
+#include <algorithm>
+#include <cstring>
 #include <time.h>
 
 static const int MC_Tag_Particle_Buffer = 2300;
 
 // Static declarations
-static std::map<int, int> send_count;
-static std::map<int, int> recv_count;
+static thread_local std::map<int, int> send_count;
+static thread_local std::map<int, int> recv_count;
 
 //----------------------------------------------------------------------------------------------------------------------
 //  Cancels and frees a pending request.
@@ -68,8 +71,9 @@ void particle_buffer_base_type::Allocate(int buffer_size) {
   this->length = length_int_data + length_float_data + length_char_data;
 
   // single, contiguous allocation for all 3 int, float, char data buffers
-  char *p = NULL;
-  MC_MALLOC(p, this->length, char);
+  // The buffers only live until the end of the cycle.
+  char *p = MemoryControl::allocate<char>(
+      this->length, MemoryControl::AllocationPolicy::ARENA_CYCLE_MEM);
 
   if (length_int_data % sizeof(double) != 0) {
     MC_Fatal_Jump("\nThe particle buffer for floating point data is not 8-byte "
@@ -126,13 +130,36 @@ void particle_buffer_base_type::Reset_Offsets() {
   this->char_data = p + length_int_data + length_float_data;
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+//  Move the float and char data down to the offsets Reset_Offsets computes
+//  from num_particles, so a buffer that was allocated for more particles than
+//  it holds can be sent and unpacked like an exactly sized one.
+//----------------------------------------------------------------------------------------------------------------------
+void particle_buffer_base_type::Compact() {
+  double *old_float_data = this->float_data;
+  char *old_char_data = this->char_data;
+
+  this->Reset_Offsets();
+
+  if (this->float_data != old_float_data) {
+    memmove(this->float_data, old_float_data,
+            this->float_index * sizeof(double));
+    memmove(this->char_data, old_char_data, this->char_index * sizeof(char));
+  }
+
+  this->length = (char *)(this->char_data + this->char_index) -
+                 (char *)this->int_data;
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 //  Free the memory for this particle buffer.
 //----------------------------------------------------------------------------------------------------------------------
 void particle_buffer_base_type::Free_Memory() {
   mpiWait(&this->request_list, MPI_STATUS_IGNORE);
 
-  MC_FREE(this->int_data);
+  MemoryControl::deallocate((char *)this->int_data, this->length,
+                            MemoryControl::AllocationPolicy::ARENA_CYCLE_MEM);
+  this->int_data = NULL;
   this->float_data = NULL;
   this->char_data = NULL;
 }
@@ -222,6 +249,21 @@ void MC_Particle_Buffer::Instantiate() {
     this->task[0].send_buffer[buffer].processor = processor;
     this->task[0].recv_buffer[buffer].processor = processor;
   }
+
+  this->use_particle_queues = ThreadRanks::active();
+  if (this->use_particle_queues) {
+    int rank = mcco->processor_info->rank;
+    this->send_queue.resize(this->num_buffers);
+    this->recv_queue.resize(this->num_buffers);
+    this->queue_overflow.resize(this->num_buffers);
+    for (int buffer = 0; buffer < this->num_buffers; buffer++) {
+      int processor = this->task[0].send_buffer[buffer].processor;
+      this->send_queue[buffer] =
+          ThreadRanks::particleQueue(rank, processor, this->buffer_size);
+      this->recv_queue[buffer] =
+          ThreadRanks::particleQueue(processor, rank, this->buffer_size);
+    }
+  }
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -290,6 +332,7 @@ void MC_Particle_Buffer::Unpack_Particle_Buffer(int buffer_index,
     mcco->_particleVaultContainer->addProcessingParticle(base_particle,
                                                          fill_vault);
   }
+  this->num_particles_received += recv_buffer.num_particles;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -329,6 +372,30 @@ void MC_Particle_Buffer::Delete_Completed_Extra_Send_Buffers() {
   }
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+//  Push a particle into the queue to the neighbor rank of the buffer.  Keeps
+//  the order of the particles when the queue is full.
+//----------------------------------------------------------------------------------------------------------------------
+void MC_Particle_Buffer::Queue_Particle(MC_Base_Particle &particle,
+                                        int buffer) {
+  if (this->queue_overflow[buffer].empty() &&
+      this->send_queue[buffer]->push(particle))
+    return;
+  this->queue_overflow[buffer].push_back(particle);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//  Move as many waiting particles as fit into the queue to the neighbor rank.
+//----------------------------------------------------------------------------------------------------------------------
+void MC_Particle_Buffer::Flush_Queue_Overflow(int buffer) {
+  std::vector<MC_Base_Particle> &overflow = this->queue_overflow[buffer];
+  size_t num_sent = 0;
+  while (num_sent < overflow.size() &&
+         this->send_queue[buffer]->push(overflow[num_sent]))
+    num_sent++;
+  overflow.erase(overflow.begin(), overflow.begin() + num_sent);
+}
+
 //
 // MC_Particle_Buffer :: PUBLIC Functions
 //
@@ -349,7 +416,11 @@ MC_Particle_Buffer::MC_Particle_Buffer(MonteCarlo *mcco_, size_t bufferSize_) {
   this->num_buffers = 0;
   this->task = NULL;
   this->buffer_size = bufferSize_;
+  this->send_chunk_size = 0;
+  this->num_particles_sent = 0;
+  this->num_particles_received = 0;
   this->processor_buffer_map.clear();
+  this->use_particle_queues = false;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -360,6 +431,13 @@ MC_Particle_Buffer::MC_Particle_Buffer(MonteCarlo *mcco_, size_t bufferSize_) {
 void MC_Particle_Buffer::Initialize() {
   NVTX_Range range("MC_Particle_Buffer::Initialize");
 
+  // A send chunk never holds more particles than a vault, which is what the
+  // receive buffers are sized for.
+  this->send_chunk_size =
+      std::min(mcco->_params.simulationParams.sendChunkSize, buffer_size);
+  this->num_particles_sent = 0;
+  this->num_particles_received = 0;
+
   if (mcco->processor_info->num_processors > 1) {
     this->Instantiate();
 
@@ -413,6 +491,13 @@ void MC_Particle_Buffer::Buffer_Particle(MC_Particle *particle, int buffer) {
 //----------------------------------------------------------------------------------------------------------------------
 void MC_Particle_Buffer::Buffer_Particle(MC_Base_Particle &particle,
                                          int buffer) {
+  this->num_particles_sent++;
+
+  if (this->use_particle_queues) {
+    this->Queue_Particle(particle, buffer);
+    return;
+  }
+
   particle_buffer_base_type &send_buffer = this->task[0].send_buffer[buffer];
 
   if (mcco->_params.simulationParams.debugThreads >= 3) {
@@ -425,9 +510,15 @@ void MC_Particle_Buffer::Buffer_Particle(MC_Base_Particle &particle,
   }
 
   if (send_buffer.int_data == NULL) {
-    fprintf(stderr,
-            "Should not reach here. This should be already preallocated\n");
-    send_buffer.Allocate(this->buffer_size);
+    // Pipelined sends allocate a chunk sized buffer whenever the previous
+    // one has been handed to MPI.
+    if (this->send_chunk_size > 0) {
+      send_buffer.Allocate(this->send_chunk_size);
+    } else {
+      fprintf(stderr,
+              "Should not reach here. This should be already preallocated\n");
+      send_buffer.Allocate(this->buffer_size);
+    }
   }
 
   // Put the particle into the buffer.
@@ -443,6 +534,9 @@ void MC_Particle_Buffer::Buffer_Particle(MC_Base_Particle &particle,
 //  Allocate Send Buffers given sendQueue neighbor size
 //----------------------------------------------------------------------------------------------------------------------
 void MC_Particle_Buffer::Allocate_Send_Buffer(SendQueue &sendQueue) {
+  if (this->use_particle_queues)
+    return;
+
   for (int buffer = 0; buffer < this->num_buffers; buffer++) {
     particle_buffer_base_type &send_buffer = this->task[0].send_buffer[buffer];
     int send_size = sendQueue.neighbor_size(send_buffer.processor);
@@ -451,6 +545,43 @@ void MC_Particle_Buffer::Allocate_Send_Buffer(SendQueue &sendQueue) {
   }
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+//  Pipelined sends: move the send queue entries from first_unsent on into the
+//  send buffers and post a send for every buffer that reaches send_chunk_size
+//  particles.  Called between chunks of the tracking loop, so the sends of
+//  the particles that have already left the domain are in flight while the
+//  rest of the vault is tracked.  Partly filled buffers are sent by
+//  Send_Particle_Buffers once the vault is done.
+//----------------------------------------------------------------------------------------------------------------------
+void MC_Particle_Buffer::Stream_Send_Queue(SendQueue &sendQueue,
+                                           ParticleVault *processingVault,
+                                           int &first_unsent) {
+  int queue_size = sendQueue.size();
+  if (this->num_buffers == 0) {
+    first_unsent = queue_size;
+    return;
+  }
+
+  for (int index = first_unsent; index < queue_size; index++) {
+    sendQueueTuple &sendQueueT = sendQueue.getTuple(index);
+    MC_Base_Particle mcb_particle;
+
+    processingVault->getBaseParticleComm(mcb_particle,
+                                         sendQueueT._particleIndex);
+
+    int buffer = this->Choose_Buffer(sendQueueT._neighbor);
+    this->Buffer_Particle(mcb_particle, buffer);
+
+    if (this->task[0].send_buffer[buffer].num_particles ==
+        this->send_chunk_size)
+      this->Send_Particle_Buffer(buffer);
+  }
+  first_unsent = queue_size;
+
+  // Let the earlier sends progress.
+  this->Delete_Completed_Extra_Send_Buffers();
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 // Wrapper to send all of the particle buffers
 //----------------------------------------------------------------------------------------------------------------------
@@ -464,12 +595,18 @@ void MC_Particle_Buffer::Send_Particle_Buffers() {
 //  Sends a particle buffer to the appropriate processor.
 //----------------------------------------------------------------------------------------------------------------------
 void MC_Particle_Buffer::Send_Particle_Buffer(int buffer) {
+  if (this->use_particle_queues) {
+    this->Flush_Queue_Overflow(buffer);
+    return;
+  }
+
   particle_buffer_base_type &send_buffer = this->task[0].send_buffer[buffer];
 
   if (send_buffer.num_particles > 0) {
     // Fill in the number of particles being sent.
     send_buffer.int_data[0] = send_buffer.num_particles;
     send_buffer.int_data[1] = 0; // Padding
+    send_buffer.Compact();
 
     if (mcco->_params.simulationParams.debugThreads >= 2) {
       fprintf(stderr,
@@ -495,6 +632,9 @@ void MC_Particle_Buffer::Send_Particle_Buffer(int buffer) {
 //  Receive the size of the next message you are expecting
 //----------------------------------------------------------------------------------------------------------------------
 void MC_Particle_Buffer::Post_Receive_Particle_Buffer(size_t bufferSize_) {
+  if (this->use_particle_queues)
+    return;
+
   for (int buffer_index = 0; buffer_index < this->num_buffers; buffer_index++) {
     particle_buffer_base_type &recv_buffer =
         this->task[0].recv_buffer[buffer_index];
@@ -513,6 +653,21 @@ void MC_Particle_Buffer::Post_Receive_Particle_Buffer(size_t bufferSize_) {
 //  to be processed.
 //----------------------------------------------------------------------------------------------------------------------
 void MC_Particle_Buffer::Receive_Particle_Buffers(uint64_t &fill_vault) {
+  if (this->use_particle_queues) {
+    MC_Base_Particle base_particle;
+    for (int buffer_index = 0; buffer_index < this->num_buffers;
+         buffer_index++) {
+      this->Flush_Queue_Overflow(buffer_index);
+      while (this->recv_queue[buffer_index]->pop(base_particle)) {
+        base_particle.last_event = MC_Tally_Event::Facet_Crossing_Communication;
+        mcco->_particleVaultContainer->addProcessingParticle(base_particle,
+                                                             fill_vault);
+        this->num_particles_received++;
+      }
+    }
+    return;
+  }
+
   for (int buffer_index = 0; buffer_index < this->num_buffers; buffer_index++) {
     particle_buffer_base_type &recv_buffer =
         this->task[0].recv_buffer[buffer_index];
@@ -674,6 +829,10 @@ void MC_Particle_Buffer::Free_Memory() {
 
   this->num_buffers = 0; // buffers are now freed
 
+  this->send_queue.clear();
+  this->recv_queue.clear();
+  this->queue_overflow.clear();
+
   MC_DELETE_ARRAY(task);
   this->processor_buffer_map.clear();
   this->test_done.Free_Memory();
@@ -3,13 +3,16 @@
 
 #include "MC_Base_Particle.hh"
 #include "MC_Processor_Info.hh"
+#include "ThreadRanks.hh"
 #include "utilsMpi.hh"
 #include <list>
 #include <map>
+#include <vector>
 
 // forward declarations
 class MC_Particle;
 class MonteCarlo;
+class ParticleVault;
 class SendQueue;
 
 //
@@ -36,6 +39,7 @@ struct particle_buffer_base_type {
   void Allocate(int buffer_size);
   void Initialize_Buffer();
   void Reset_Offsets();
+  void Compact();
   void Free_Memory();
 };
 
@@ -85,11 +89,21 @@ private:
       processor_buffer_map; // Map processors to buffers. buffer_index =
                             // processor_buffer_map[processor]
 
+  // With ThreadRanks the particles are not serialized into the buffers but
+  // pushed straight into a queue shared with the neighbor rank.  Particles
+  // that find the queue full wait in queue_overflow.  All indexed by buffer.
+  bool use_particle_queues;
+  std::vector<ParticleQueue *> send_queue;
+  std::vector<ParticleQueue *> recv_queue;
+  std::vector<std::vector<MC_Base_Particle>> queue_overflow;
+
   void Instantiate();
   void Initialize_Map();
   void Unpack_Particle_Buffer(int buffer_index, uint64_t &fill_vault);
   bool Trivially_Done();
   void Delete_Completed_Extra_Send_Buffers();
+  void Queue_Particle(MC_Base_Particle &particle, int buffer);
+  void Flush_Queue_Overflow(int buffer);
 
 public:
   // non-master threads place full buffers here for master thread to send
@@ -98,6 +112,9 @@ public:
   MC_New_Test_Done_Method::Enum new_test_done_method; // which algorithm to use
   int num_buffers; // Number of particle buffers
   int buffer_size; // Buffer size to be sent.
+  int send_chunk_size; // Particles per pipelined send (0 = one send per vault)
+  uint64_t num_particles_sent;     // Particles sent this cycle
+  uint64_t num_particles_received; // Particles received this cycle
 
   MC_Particle_Buffer(MonteCarlo *mcco_, size_t bufferSize_); // constructor
   void Initialize();
@@ -106,6 +123,8 @@ public:
   void Buffer_Particle(MC_Particle *particle_to_buffer, int buffer);
   void Buffer_Particle(MC_Base_Particle &particle_to_buffer, int buffer);
   void Allocate_Send_Buffer(SendQueue &sendQueue);
+  void Stream_Send_Queue(SendQueue &sendQueue, ParticleVault *processingVault,
+                         int &first_unsent);
   void Send_Particle_Buffers();
   void Send_Particle_Buffer(int buffer);
   void Post_Receive_Particle_Buffer(size_t batchSize_);
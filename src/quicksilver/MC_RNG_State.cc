@@ -1,5 +1,22 @@
 #include "MC_RNG_State.hh"
 #include "DeclareMacro.hh"
+#include "cudaFunctions.hh"
+#include "cudaUtils.hh"
+
+#if defined(HAVE_CUDA)
+__managed__ int rng_type = RNG_Type::LCG;
+#else
+HOST_DEVICE
+int rng_type = RNG_Type::LCG;
+HOST_DEVICE_END
+#endif
+
+void rngSetType(int type) {
+  rng_type = type;
+#if defined(HAVE_OPENMP_TARGET)
+#pragma omp target update to(rng_type)
+#endif
+}
 
 //---------------------------------------------------------------------------//
 
@@ -98,10 +115,86 @@ HOST_DEVICE_END
 
 HOST_DEVICE
 uint64_t rngSpawn_Random_Number_Seed(uint64_t *parent_seed) {
-  uint64_t spawned_seed = hash_state(*parent_seed);
+  // Philox hashes the parent counter with a key other than the sample key,
+  // so the child stream starts at an unrelated counter.
+  uint64_t spawned_seed = rng_type == RNG_Type::Philox
+                              ? rngPhilox2x32(*parent_seed, 0x299F31D0U)
+                              : hash_state(*parent_seed);
   // Bump the parent seed as that is what is expected from the interface.
   rngSample(parent_seed);
   return spawned_seed;
 }
 
 HOST_DEVICE_END
+
+//----------------------------------------------------------------------------------------------------------------------
+//  Batch generation.
+//----------------------------------------------------------------------------------------------------------------------
+
+void rngSampleBatch(uint64_t *seed, int numSamples, double *sample) {
+  if (rng_type != RNG_Type::Philox) {
+    for (int ii = 0; ii < numSamples; ii++)
+      sample[ii] = rngSampleLCG(seed);
+    return;
+  }
+
+  // Blocks of lanes that run the rounds side by side, the same operations
+  // as rngPhilox2x32 laid out so that the compiler vectorizes over lanes.
+  const int numLanes = 64;
+  uint64_t counter = *seed;
+  int ii = 0;
+  for (; ii + numLanes <= numSamples; ii += numLanes) {
+    uint32_t x0[numLanes], x1[numLanes];
+    for (int lane = 0; lane < numLanes; lane++) {
+      x0[lane] = (uint32_t)(counter + lane);
+      x1[lane] = (uint32_t)((counter + lane) >> 32);
+    }
+
+    uint32_t key = RNG_PHILOX_SAMPLE_KEY;
+    for (int round = 0; round < 10; round++) {
+#ifdef HAVE_OPENMP
+#pragma omp simd
+#endif
+      for (int lane = 0; lane < numLanes; lane++) {
+        uint64_t product = 0xD256D344ULL * x0[lane];
+        uint32_t hi = (uint32_t)(product >> 32) ^ key ^ x1[lane];
+        x1[lane] = (uint32_t)product;
+        x0[lane] = hi;
+      }
+      key += 0x9E3779B9U;
+    }
+
+#ifdef HAVE_OPENMP
+#pragma omp simd
+#endif
+    for (int lane = 0; lane < numLanes; lane++) {
+      uint64_t bits = ((uint64_t)x1[lane] << 32) | x0[lane];
+      sample[ii + lane] = ((bits >> 11) + 0.5) * 1.1102230246251565e-16;
+    }
+    counter += numLanes;
+  }
+  for (; ii < numSamples; ii++)
+    sample[ii] = rngSamplePhilox(&counter);
+  *seed = counter;
+}
+
+#if defined(HAVE_CUDA)
+namespace {
+__global__ void RngSampleBatchKernel(uint64_t seed, int numSamples,
+                                     double *sample) {
+  int global_index = getGlobalThreadID();
+  if (global_index < numSamples)
+    sample[global_index] = rngSampleAt(seed, global_index);
+}
+} // namespace
+
+void rngSampleBatchDevice(uint64_t *seed, int numSamples, double *sample) {
+  dim3 grid(1, 1, 1);
+  dim3 block(1, 1, 1);
+  if (ThreadBlockLayout(grid, block, numSamples)) {
+    RngSampleBatchKernel<<<grid, block>>>(*seed, numSamples, sample);
+    cudaDeviceSynchronize();
+  }
+  rngSkipAhead(seed, numSamples);
+}
+#endif
@@ -5,23 +5,70 @@
 #include "portability.hh"
 
 //----------------------------------------------------------------------------------------------------------------------
-//  A random number generator that implements a 64 bit linear congruential
-//  generator (lcg).
+//  The random number generators.  Every particle carries its own 64 bit
+//  random_number_seed, so the numbers a particle draws do not depend on the
+//  thread or vault it is tracked in.
 //
-//  This implementation is based on the rng class from Nick Gentile.
+//  LCG:    a 64 bit linear congruential generator (lcg), based on the rng
+//          class from Nick Gentile.  The seed is the lcg state.
+//
+//  Philox: the counter based Philox-2x32-10 generator of Salmon et al.,
+//          "Parallel random numbers: as easy as 1, 2, 3" (SC11).  The seed
+//          is a counter: the number drawn is a keyed bijective hash of it
+//          and the seed is then incremented.  A particle's stream starts at
+//          the (hashed) seed it was spawned with, so sample n of a particle
+//          is a pure function of (particle seed, n).  There is no loop
+//          carried dependence between samples, so batches vectorize and
+//          skipping ahead is O(1).
+//
+//  The generator is selected with the rngType parameter (RNG_Type).
 //----------------------------------------------------------------------------------------------------------------------
 
+struct RNG_Type {
+  enum Enum { LCG = 0, Philox = 1 };
+};
+
+// The generator used by rngSample and rngSpawn_Random_Number_Seed.  Set by
+// rngSetType before any particle exists.
+#if defined(HAVE_CUDA)
+extern __managed__ int rng_type;
+#else
+HOST_DEVICE
+extern int rng_type;
+HOST_DEVICE_END
+#endif
+
+void rngSetType(int type);
+
 // Generate a new random number seed
 HOST_DEVICE
 uint64_t rngSpawn_Random_Number_Seed(uint64_t *parent_seed);
 HOST_DEVICE_END
 
 //----------------------------------------------------------------------------------------------------------------------
-//  Sample returns the pseudo-random number produced by a call to a random
-//  number generator.
+//  Philox-2x32-10 of a 64 bit counter with a 32 bit key.
 //----------------------------------------------------------------------------------------------------------------------
 HOST_DEVICE
-inline double rngSample(uint64_t *seed) {
+inline uint64_t rngPhilox2x32(uint64_t counter, uint32_t key) {
+  uint32_t x0 = (uint32_t)counter;
+  uint32_t x1 = (uint32_t)(counter >> 32);
+
+  for (int round = 0; round < 10; round++) {
+    uint64_t product = 0xD256D344ULL * x0;
+    x0 = (uint32_t)(product >> 32) ^ key ^ x1;
+    x1 = (uint32_t)product;
+    key += 0x9E3779B9U;
+  }
+
+  return ((uint64_t)x1 << 32) | x0;
+}
+HOST_DEVICE_END
+
+// Philox key of the samples; rngSpawn_Random_Number_Seed uses another one.
+#define RNG_PHILOX_SAMPLE_KEY 0xA4093822U
+
+HOST_DEVICE
+inline double rngSampleLCG(uint64_t *seed) {
   // Reset the state from the previous value.
   *seed = 2862933555777941757ULL * (*seed) + 3037000493ULL;
 
@@ -32,4 +79,75 @@ inline double rngSample(uint64_t *seed) {
 }
 HOST_DEVICE_END
 
+HOST_DEVICE
+inline double rngSamplePhilox(uint64_t *seed) {
+  uint64_t bits = rngPhilox2x32((*seed)++, RNG_PHILOX_SAMPLE_KEY);
+
+  // The top 53 bits, centered in their interval of width 2**-53 so the
+  // result is in (0,1).
+  return ((bits >> 11) + 0.5) * 1.1102230246251565e-16;
+}
+HOST_DEVICE_END
+
+//----------------------------------------------------------------------------------------------------------------------
+//  Sample returns the pseudo-random number produced by a call to a random
+//  number generator.
+//----------------------------------------------------------------------------------------------------------------------
+HOST_DEVICE
+inline double rngSample(uint64_t *seed) {
+  if (rng_type == RNG_Type::Philox)
+    return rngSamplePhilox(seed);
+  return rngSampleLCG(seed);
+}
+HOST_DEVICE_END
+
+//----------------------------------------------------------------------------------------------------------------------
+//  Advances the seed as numSamples calls of rngSample would.  O(1) for
+//  Philox, O(log numSamples) for the lcg.
+//----------------------------------------------------------------------------------------------------------------------
+HOST_DEVICE
+inline void rngSkipAhead(uint64_t *seed, uint64_t numSamples) {
+  if (rng_type == RNG_Type::Philox) {
+    *seed += numSamples;
+    return;
+  }
+
+  // Compose the lcg step x -> a*x + c with itself by repeated squaring.
+  uint64_t mult = 1, add = 0;
+  uint64_t stepMult = 2862933555777941757ULL, stepAdd = 3037000493ULL;
+  while (numSamples > 0) {
+    if (numSamples & 1) {
+      mult *= stepMult;
+      add = add * stepMult + stepAdd;
+    }
+    stepAdd = (stepMult + 1) * stepAdd;
+    stepMult *= stepMult;
+    numSamples >>= 1;
+  }
+  *seed = mult * (*seed) + add;
+}
+HOST_DEVICE_END
+
+//----------------------------------------------------------------------------------------------------------------------
+//  The number the (index+1)-th call of rngSample from seed would return.
+//----------------------------------------------------------------------------------------------------------------------
+HOST_DEVICE
+inline double rngSampleAt(uint64_t seed, uint64_t index) {
+  rngSkipAhead(&seed, index);
+  return rngSample(&seed);
+}
+HOST_DEVICE_END
+
+//----------------------------------------------------------------------------------------------------------------------
+//  Fills sample[0, numSamples) with the numbers numSamples calls of
+//  rngSample would return and advances the seed past them.  The Philox
+//  loop is vectorized.  rngSampleBatchDevice does the same into device
+//  memory with one GPU thread per sample.
+//----------------------------------------------------------------------------------------------------------------------
+void rngSampleBatch(uint64_t *seed, int numSamples, double *sample);
+
+#if defined(HAVE_CUDA)
+void rngSampleBatchDevice(uint64_t *seed, int numSamples, double *sample);
+#endif
+
 #endif
@@ -4,13 +4,15 @@
 class MC_Time_Info {
 public:
   int cycle;
+  int start_cycle; // first cycle of this run, > 0 after a restart
   double initial_time;
   double final_time;
   double time;
   double time_step;
 
   MC_Time_Info()
-      : cycle(0), initial_time(0.0), final_time(), time(0.0), time_step(1.0) {}
+      : cycle(0), start_cycle(0), initial_time(0.0), final_time(), time(0.0),
+        time_step(1.0) {}
 };
 
 #endif
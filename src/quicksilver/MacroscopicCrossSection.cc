@@ -4,6 +4,72 @@
 #include "MaterialDatabase.hh"
 #include "MonteCarlo.hh"
 #include "NuclearData.hh"
+#include "Tallies.hh"
+#include <algorithm>
+
+//----------------------------------------------------------------------------------------------------------------------
+//  Fill the flattened material tables.  Entries are computed exactly like
+//  macroscopicCrossSection does for a cell number density of one.
+//----------------------------------------------------------------------------------------------------------------------
+void MacroscopicCrossSectionTable::build(
+    const MaterialDatabase &materialDatabase, NuclearData &nuclearData) {
+  int numMaterials = materialDatabase._mat.size();
+  _numGroups = nuclearData._numEnergyGroups;
+
+  _rowLength = 0;
+  _numIsoReactions.resize(numMaterials, 0, VAR_MEM);
+  for (int matIndex = 0; matIndex < numMaterials; matIndex++) {
+    const Material &material = materialDatabase._mat[matIndex];
+    for (int isoIndex = 0; isoIndex < material._iso.size(); isoIndex++)
+      _numIsoReactions[matIndex] +=
+          nuclearData.getNumberReactions(material._iso[isoIndex]._gid);
+    _rowLength = std::max(_rowLength, _numIsoReactions[matIndex]);
+  }
+
+  _isotope.resize(numMaterials * _rowLength, -1, VAR_MEM);
+  _reactIndex.resize(numMaterials * _rowLength, -1, VAR_MEM);
+  _total.resize(numMaterials * _numGroups, 0., VAR_MEM);
+  _reaction.resize(numMaterials * _numGroups * _rowLength, 0., VAR_MEM);
+
+  for (int matIndex = 0; matIndex < numMaterials; matIndex++) {
+    const Material &material = materialDatabase._mat[matIndex];
+    int nIsotopes = material._iso.size();
+
+    int ii = 0;
+    for (int isoIndex = 0; isoIndex < nIsotopes; isoIndex++) {
+      int numReacts =
+          nuclearData.getNumberReactions(material._iso[isoIndex]._gid);
+      for (int reactIndex = 0; reactIndex < numReacts; reactIndex++, ii++) {
+        _isotope[matIndex * _rowLength + ii] = isoIndex;
+        _reactIndex[matIndex * _rowLength + ii] = reactIndex;
+      }
+    }
+
+    for (int group = 0; group < _numGroups; group++) {
+      double sum = 0.0;
+      double *row = &_reaction[(matIndex * _numGroups + group) * _rowLength];
+      ii = 0;
+      for (int isoIndex = 0; isoIndex < nIsotopes; isoIndex++) {
+        int isotopeGid = material._iso[isoIndex]._gid;
+        double atomFraction = material._iso[isoIndex]._atomFraction;
+        int numReacts = nuclearData.getNumberReactions(isotopeGid);
+        if (atomFraction == 0.0) {
+          sum += 1e-20;
+          for (int reactIndex = 0; reactIndex < numReacts; reactIndex++)
+            row[ii++] = 1e-20;
+          continue;
+        }
+        sum += atomFraction *
+               nuclearData.getTotalCrossSection(isotopeGid, group);
+        for (int reactIndex = 0; reactIndex < numReacts; reactIndex++)
+          row[ii++] =
+              atomFraction * nuclearData.getReactionCrossSection(
+                                 reactIndex, isotopeGid, group);
+      }
+      _total[matIndex * _numGroups + group] = sum;
+    }
+  }
+}
 
 //----------------------------------------------------------------------------------------------------------------------
 //  Routine MacroscopicCrossSection calculates the number-density-weighted
@@ -52,14 +118,40 @@ double macroscopicCrossSection(MonteCarlo *monteCarlo, int reactionIndex,
 HOST_DEVICE_END
 
 //----------------------------------------------------------------------------------------------------------------------
-//  Routine weightedMacroscopicCrossSection calculates the
-//  number-density-weighted macroscopic cross section of the collection of
-//  isotopes in a cell.
+//  Routine cellTotalCrossSection calculates the number-density-weighted
+//  macroscopic cross section of the collection of isotopes in a cell.
 // dfr Weighted is a bit of a misnomer here, since there is no weighting
 // applied by this routine.  In Mercury we would weight for multiple
 // materials in a cell.
 //----------------------------------------------------------------------------------------------------------------------
 HOST_DEVICE
+double cellTotalCrossSection(MonteCarlo *monteCarlo, int domainIndex,
+                             int cellIndex, int energyGroup) {
+  const MC_Cell_State &cell =
+      monteCarlo->domain[domainIndex].cell_state[cellIndex];
+  int globalMatIndex = cell._material;
+
+  // The material tables are built for unit number density.
+  if (cell._cellNumberDensity != 0.0)
+    return monteCarlo->_crossSectionTable->total(globalMatIndex, energyGroup) *
+           cell._cellNumberDensity;
+
+  double sum = 0.0;
+  int nIsotopes =
+      (int)monteCarlo->_materialDatabase->_mat[globalMatIndex]._iso.size();
+  for (int isoIndex = 0; isoIndex < nIsotopes; isoIndex++) {
+    sum += macroscopicCrossSection(monteCarlo, -1, domainIndex, cellIndex,
+                                   isoIndex, energyGroup);
+  }
+  return sum;
+}
+HOST_DEVICE_END
+
+//----------------------------------------------------------------------------------------------------------------------
+//  Routine weightedMacroscopicCrossSection returns the cached total cross
+//  section of a cell, computing and caching it on a miss.
+//----------------------------------------------------------------------------------------------------------------------
+HOST_DEVICE
 double weightedMacroscopicCrossSection(MonteCarlo *monteCarlo, int taskIndex,
                                        int domainIndex, int cellIndex,
                                        int energyGroup) {
@@ -70,16 +162,9 @@ double weightedMacroscopicCrossSection(MonteCarlo *monteCarlo, int taskIndex,
   if (*precomputedCrossSection > 0.0)
     return *precomputedCrossSection;
 
-  int globalMatIndex =
-      monteCarlo->domain[domainIndex].cell_state[cellIndex]._material;
-  int nIsotopes =
-      (int)monteCarlo->_materialDatabase->_mat[globalMatIndex]._iso.size();
-  double sum = 0.0;
-  for (int isoIndex = 0; isoIndex < nIsotopes; isoIndex++) {
-    sum += macroscopicCrossSection(monteCarlo, -1, domainIndex, cellIndex,
-                                   isoIndex, energyGroup);
-  }
-
+  ATOMIC_UPDATE(monteCarlo->_tallies->_balanceTask[taskIndex]._xsCacheMiss);
+  double sum =
+      cellTotalCrossSection(monteCarlo, domainIndex, cellIndex, energyGroup);
   ATOMIC_WRITE(*precomputedCrossSection, sum);
 
   return sum;
@@ -2,8 +2,53 @@
 #define MACROSCOPIC_CROSS_SECTION_HH
 
 #include "DeclareMacro.hh"
+#include "QS_Vector.hh"
 
 class MonteCarlo;
+class MaterialDatabase;
+class NuclearData;
+
+//---------------------------------------------------------------
+// MacroscopicCrossSectionTable holds the macroscopic cross
+// sections of every material at unit cell number density.  The
+// tables depend only on the MaterialDatabase and the NuclearData,
+// so they are built once at initialization and shared by every
+// domain.  All data for one [material][group] pair is contiguous:
+//
+//   _total[material * _numGroups + group]
+//   _reaction[(material * _numGroups + group) * _rowLength + ii]
+//
+// where ii walks the (isotope, reaction) pairs of the material in
+// the order CollisionEvent samples them.  _isotope and _reactIndex
+// map ii back to the material isotope index and the reaction
+// index of that isotope.
+//--------------------------------------------------------------
+
+class MacroscopicCrossSectionTable {
+public:
+  MacroscopicCrossSectionTable() : _numGroups(0), _rowLength(0) {}
+
+  void build(const MaterialDatabase &materialDatabase,
+             NuclearData &nuclearData);
+
+  HOST_DEVICE_CUDA
+  double total(int material, int group) const {
+    return _total[material * _numGroups + group];
+  }
+
+  HOST_DEVICE_CUDA
+  const double *reactions(int material, int group) const {
+    return &_reaction[(material * _numGroups + group) * _rowLength];
+  }
+
+  int _numGroups;
+  int _rowLength; //!< max number of (isotope, reaction) pairs of a material
+  qs_vector<int> _numIsoReactions; //!< [material]
+  qs_vector<int> _isotope;         //!< [material][ii]
+  qs_vector<int> _reactIndex;      //!< [material][ii]
+  qs_vector<double> _total;        //!< [material][group]
+  qs_vector<double> _reaction;     //!< [material][group][ii]
+};
 
 HOST_DEVICE
 double macroscopicCrossSection(MonteCarlo *monteCarlo, int reactionIndex,
@@ -11,6 +56,22 @@ double macroscopicCrossSection(MonteCarlo *monteCarlo, int reactionIndex,
                                int energyGroup);
 HOST_DEVICE_END
 
+// How the per cell cache of total cross sections (MC_Cell_State::_total)
+// is kept: cleared every cycle and filled on first use, kept until the
+// material or nuclear data change (see MonteCarlo::_crossSectionEpoch), or
+// filled in for every cell and group before the first cycle.
+struct CrossSectionCacheMode {
+  enum Enum { PerCycle = 0, Epoch = 1, Precomputed = 2 };
+};
+
+// The total macroscopic cross section of a cell, without the cache.
+HOST_DEVICE
+double cellTotalCrossSection(MonteCarlo *monteCarlo, int domainIndex,
+                             int cellIndex, int energyGroup);
+HOST_DEVICE_END
+
+// The total macroscopic cross section of a cell, from the cache of the
+// cell.  Misses are counted in Balance::_xsCacheMiss.
 HOST_DEVICE
 double weightedMacroscopicCrossSection(MonteCarlo *monteCarlo, int taskIndex,
                                        int domainIndex, int cellIndex,
@@ -0,0 +1,95 @@
+#include "MemoryArena.hh"
+#include "cudaUtils.hh"
+#include "qs_assert.hh"
+#include "utils.hh"
+#include <cstdlib>
+
+namespace {
+const size_t arenaAlignment = 64;
+
+size_t alignUp(size_t bytes) {
+  return (bytes + arenaAlignment - 1) & ~(arenaAlignment - 1);
+}
+} // namespace
+
+MemoryArena &MemoryArena::instance() {
+  // Every rank thread of ThreadRanks has its own arena.
+  static thread_local MemoryArena arena;
+  return arena;
+}
+
+void MemoryArena::reserve(size_t bytes) {
+  release();
+  bytes = alignUp(bytes);
+  if (bytes == 0)
+    return;
+
+#ifdef HAVE_UVM
+  void *ptr = 0;
+  cudaMallocManaged(&ptr, bytes, cudaMemAttachGlobal);
+  _base = (char *)ptr;
+#else
+  void *ptr = 0;
+  if (posix_memalign(&ptr, arenaAlignment, bytes) == 0)
+    _base = (char *)ptr;
+#endif
+  qs_assert(_base != 0);
+
+  _capacity = bytes;
+  _bottom = 0;
+  _top = bytes;
+  _peak = 0;
+  _numOverflow = 0;
+  _overflowBytes = 0;
+}
+
+void MemoryArena::release() {
+  if (_base == 0)
+    return;
+#ifdef HAVE_UVM
+  cudaFree(_base);
+#else
+  free(_base);
+#endif
+  _base = 0;
+  _capacity = _bottom = _top = 0;
+}
+
+void *MemoryArena::allocate(size_t bytes, bool cycle) {
+  void *ptr = 0;
+  bytes = alignUp(bytes);
+
+#ifdef HAVE_OPENMP
+#pragma omp critical(MemoryArena)
+#endif
+  {
+    if (_base != 0 && bytes <= _top - _bottom) {
+      if (cycle) {
+        _top -= bytes;
+        ptr = _base + _top;
+      } else {
+        ptr = _base + _bottom;
+        _bottom += bytes;
+      }
+      if (currentBytes() > _peak)
+        _peak = currentBytes();
+    } else if (_base != 0) {
+      _numOverflow++;
+      _overflowBytes += bytes;
+    }
+  }
+
+  return ptr;
+}
+
+void MemoryArena::resetCycle() { _top = _capacity; }
+
+void MemoryArena::printUsage() const {
+  if (_base == 0)
+    return;
+  const double MiB = 1024. * 1024.;
+  Print0("Memory arena: %.1f MiB reserved, %.1f MiB in use, %.1f MiB peak, "
+         "%zu allocations (%.1f MiB) from the heap\n",
+         _capacity / MiB, currentBytes() / MiB, _peak / MiB, _numOverflow,
+         _overflowBytes / MiB);
+}
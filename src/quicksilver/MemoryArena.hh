@@ -0,0 +1,60 @@
+#ifndef MEMORY_ARENA_HH
+#define MEMORY_ARENA_HH
+
+#include <cstddef>
+
+//---------------------------------------------------------------
+// MemoryArena is one large region reserved when the problem is
+// set up, from which MemoryControl hands out 64 byte aligned
+// blocks for the ARENA_MEM and ARENA_CYCLE_MEM policies.
+//
+// Long lived blocks (vaults, tallies, cross section caches) are
+// carved from the bottom of the region and live until the arena
+// is released.  Cycle blocks (particle communication buffers) are
+// carved from the top of the region and are all returned at once
+// by resetCycle() at the end of each cycle.  Individual blocks are
+// never returned, so freeing an arena block only runs destructors.
+//
+// When the region is exhausted (or was never reserved) allocate
+// returns NULL and MemoryControl falls back to the regular heap.
+//--------------------------------------------------------------
+
+class MemoryArena {
+public:
+  static MemoryArena &instance();
+
+  // Reserve (or, with zero bytes, disable) the region.
+  void reserve(size_t bytes);
+  void release();
+
+  bool enabled() const { return _base != 0; }
+  bool owns(const void *ptr) const {
+    return (const char *)ptr >= _base && (const char *)ptr < _base + _capacity;
+  }
+
+  void *allocate(size_t bytes, bool cycle);
+  void resetCycle();
+
+  size_t capacity() const { return _capacity; }
+  size_t currentBytes() const { return _bottom + (_capacity - _top); }
+  size_t peakBytes() const { return _peak; }
+
+  void printUsage() const;
+
+private:
+  MemoryArena()
+      : _base(0), _capacity(0), _bottom(0), _top(0), _peak(0),
+        _numOverflow(0), _overflowBytes(0) {}
+  MemoryArena(const MemoryArena &);
+  MemoryArena &operator=(const MemoryArena &);
+
+  char *_base;
+  size_t _capacity;
+  size_t _bottom; //!< end of the long lived blocks
+  size_t _top;    //!< start of the cycle blocks
+  size_t _peak;
+  size_t _numOverflow;   //!< allocations that did not fit
+  size_t _overflowBytes; //!< bytes of those allocations
+};
+
+#endif
@@ -1,12 +1,22 @@
 #ifndef MEMORY_CONTROL_HH
 #define MEMORY_CONTROL_HH
 
+#include "MemoryArena.hh"
 #include "cudaUtils.hh"
 
 #include "qs_assert.hh"
+#include <new>
 
 namespace MemoryControl {
-enum AllocationPolicy { HOST_MEM, UVM_MEM, UNDEFINED_POLICY };
+// ARENA_MEM and ARENA_CYCLE_MEM take long lived and per cycle blocks
+// from the MemoryArena, falling back to VAR_MEM when it is full.
+enum AllocationPolicy {
+  HOST_MEM,
+  UVM_MEM,
+  ARENA_MEM,
+  ARENA_CYCLE_MEM,
+  UNDEFINED_POLICY
+};
 
 template <typename T>
 T *allocate(const int size, const AllocationPolicy policy) {
@@ -26,6 +36,15 @@ T *allocate(const int size, const AllocationPolicy policy) {
     tmp = new (ptr) T[size];
     break;
 #endif
+  case AllocationPolicy::ARENA_MEM:
+  case AllocationPolicy::ARENA_CYCLE_MEM:
+    tmp = static_cast<T *>(MemoryArena::instance().allocate(
+        size * sizeof(T), policy == AllocationPolicy::ARENA_CYCLE_MEM));
+    if (tmp == NULL)
+      return allocate<T>(size, VAR_MEM);
+    for (int i = 0; i < size; ++i)
+      new (tmp + i) T;
+    break;
   default:
     qs_assert(false);
     break;
@@ -46,6 +65,15 @@ void deallocate(T *data, const int size, const AllocationPolicy policy) {
     cudaFree(data);
     break;
 #endif
+  case ARENA_MEM:
+  case ARENA_CYCLE_MEM:
+    if (!MemoryArena::instance().owns(data)) {
+      deallocate(data, size, VAR_MEM);
+      break;
+    }
+    for (int i = 0; i < size; ++i)
+      data[i].~T();
+    break;
   default:
     qs_assert(false);
     break;
@@ -1,6 +1,6 @@
 #include "MeshPartition.hh"
 
-#include <queue>
+#include <map>
 #include <set>
 #include <utility>
 
@@ -12,11 +12,53 @@
 
 using std::make_pair;
 using std::map;
-using std::queue;
 using std::set;
 using std::vector;
 
 namespace {
+// Open addressing hash set of cell gids for the flood fill.
+class GidSet {
+public:
+  GidSet() : _numKeys(0) { _slot.assign(1024, emptySlot); }
+
+  // Returns false if gid was already in the set.
+  bool insert(Long64 gid) {
+    if (2 * (_numKeys + 1) > _slot.size())
+      grow();
+    return insertSlot(_slot, gid);
+  }
+
+private:
+  static const Long64 emptySlot = ~(Long64)0;
+
+  bool insertSlot(vector<Long64> &slot, Long64 gid) {
+    size_t mask = slot.size() - 1;
+    size_t ii = (gid * 0x9E3779B97F4A7C15ULL >> 20) & mask;
+    while (slot[ii] != emptySlot) {
+      if (slot[ii] == gid)
+        return false;
+      ii = (ii + 1) & mask;
+    }
+    slot[ii] = gid;
+    _numKeys++;
+    return true;
+  }
+
+  void grow() {
+    vector<Long64> slot(2 * _slot.size(), emptySlot);
+    _numKeys = 0;
+    for (size_t ii = 0; ii < _slot.size(); ++ii)
+      if (_slot[ii] != emptySlot)
+        insertSlot(slot, _slot[ii]);
+    _slot.swap(slot);
+  }
+
+  vector<Long64> _slot;
+  size_t _numKeys;
+};
+
+const Long64 GidSet::emptySlot;
+
 void assignCellsToDomain(MeshPartition::MapType &domainMap,
                          vector<int> &nbrDomains, int myDomainGid,
                          const vector<MC_Vector> &domainCenter,
@@ -28,7 +70,7 @@ void buildCellIndexMap(MeshPartition::MapType &cellIndexMap, int myDomainGid,
                        CommObject *comm);
 
 void addNbrsToFlood(Long64 iCell, const GlobalFccGrid &grid,
-                    queue<Long64> &floodQueue, set<Long64> &wetCells);
+                    vector<Long64> &floodQueue, GidSet &wetCells);
 
 } // namespace
 
@@ -58,8 +100,17 @@ MeshPartition::MeshPartition(int domainGid, int domainIndex, int foreman)
 void MeshPartition::buildMeshPartition(const GlobalFccGrid &grid,
                                        const vector<MC_Vector> centers,
                                        CommObject *comm) {
+  assignCells(grid, centers);
+  exchangeCells(grid, comm);
+}
+
+void MeshPartition::assignCells(const GlobalFccGrid &grid,
+                                const vector<MC_Vector> &centers) {
   assignCellsToDomain(_cellInfoMap, _nbrDomains, _domainGid, centers, grid);
+}
 
+void MeshPartition::exchangeCells(const GlobalFccGrid &grid,
+                                  CommObject *comm) {
   buildCellIndexMap(_cellInfoMap, _domainGid, _foreman, _domainIndex,
                     _nbrDomains, grid, comm);
 }
@@ -70,32 +121,34 @@ void assignCellsToDomain(MeshPartition::MapType &assignedDomainMap,
                          const vector<MC_Vector> &domainCenter,
                          const GlobalFccGrid &grid) {
   GridAssignmentObject assigner(domainCenter);
-  queue<Long64> floodQueue;
-  set<Long64> wetCells;
+  // Every cell enters the queue once, so the queue ends up holding all
+  // flooded cells.
+  vector<Long64> floodQueue;
+  GidSet wetCells;
   set<int> remoteDomainSet;
+  vector<MeshPartition::MapType::value_type> assigned;
 
   Long64 root = grid.whichCell(domainCenter[myDomainGid]);
-  Tuple tmp = grid.cellIndexToTuple(root);
 
-  floodQueue.push(root);
+  floodQueue.push_back(root);
   wetCells.insert(root);
   addNbrsToFlood(root, grid, floodQueue, wetCells);
 
-  while (floodQueue.size() > 0) {
-    Long64 iCell = floodQueue.front();
-    floodQueue.pop();
+  for (size_t head = 0; head < floodQueue.size(); ++head) {
+    Long64 iCell = floodQueue[head];
     MC_Vector rr = grid.cellCenter(iCell);
     int domain = assigner.nearestCenter(rr);
-    auto here = assignedDomainMap.insert(
+    assigned.push_back(
         make_pair(iCell, CellInfo(domain, -2, -2, -myDomainGid)));
-    if (here.second == false) // must have been added by nbr
-      qs_assert(here.first->second._domainGid == domain);
     if (domain == myDomainGid)
       addNbrsToFlood(iCell, grid, floodQueue, wetCells);
     else
       remoteDomainSet.insert(domain);
   }
 
+  // Cells already in the map were added by a nbr and are kept.
+  assignedDomainMap.insert(assigned);
+
   int ind = 0;
   nbrDomains.resize(remoteDomainSet.size());
   for (auto iter = remoteDomainSet.begin(); iter != remoteDomainSet.end();
@@ -155,7 +208,7 @@ void buildCellIndexMap(MeshPartition::MapType &cellInfoMap, int myDomainGid,
 
 namespace {
 void addNbrsToFlood(Long64 iCell, const GlobalFccGrid &grid,
-                    queue<Long64> &floodQueue, set<Long64> &wetCells) {
+                    vector<Long64> &floodQueue, GidSet &wetCells) {
   Tuple tt = grid.cellIndexToTuple(iCell);
   for (int ii = -1; ii < 2; ++ii)
     for (int jj = -1; jj < 2; ++jj)
@@ -165,10 +218,8 @@ void addNbrsToFlood(Long64 iCell, const GlobalFccGrid &grid,
         Tuple nbrTuple = tt + Tuple(ii, jj, kk);
         grid.snapTuple(nbrTuple);
         Long64 nbrIndex = grid.cellTupleToIndex(nbrTuple);
-        if (wetCells.find(nbrIndex) == wetCells.end()) {
-          floodQueue.push(nbrIndex);
-          wetCells.insert(nbrIndex);
-        }
+        if (wetCells.insert(nbrIndex))
+          floodQueue.push_back(nbrIndex);
       }
 }
 } // namespace
@@ -2,7 +2,9 @@
 #define MESH_PARTITION_HH
 
 #include "Long64.hh"
-#include <map>
+#include "qs_assert.hh"
+#include <algorithm>
+#include <utility>
 #include <vector>
 
 class MC_Vector;
@@ -21,9 +23,83 @@ struct CellInfo {
   int _cellIndex;
 };
 
+// Map from cell gid to CellInfo, kept as one contiguous array sorted by
+// gid.  Iteration visits the cells in gid order (as std::map did, the local
+// cell indices depend on it), lookups are binary searches.  Inserting a new
+// gid with operator[] shifts the tail of the array, so the bulk of the cells
+// are added at once with insert().
+class CellInfoMap {
+public:
+  typedef std::pair<Long64, CellInfo> value_type;
+  typedef std::vector<value_type>::iterator iterator;
+  typedef std::vector<value_type>::const_iterator const_iterator;
+
+  iterator begin() { return _cell.begin(); }
+  iterator end() { return _cell.end(); }
+  const_iterator begin() const { return _cell.begin(); }
+  const_iterator end() const { return _cell.end(); }
+  size_t size() const { return _cell.size(); }
+
+  iterator find(Long64 cellGid) {
+    iterator here = lowerBound(cellGid);
+    return (here != end() && here->first == cellGid) ? here : end();
+  }
+  const_iterator find(Long64 cellGid) const {
+    return const_cast<CellInfoMap *>(this)->find(cellGid);
+  }
+
+  // Inserts a default CellInfo if cellGid is not in the map.
+  CellInfo &operator[](Long64 cellGid) {
+    iterator here = lowerBound(cellGid);
+    if (here == end() || here->first != cellGid)
+      here = _cell.insert(here, value_type(cellGid, CellInfo()));
+    return here->second;
+  }
+
+  // Adds the cells whose gids are not in the map yet, like std::map::insert
+  // of each of them.  cell must not hold a gid twice; it is used up.
+  void insert(std::vector<value_type> &cell) {
+    std::sort(cell.begin(), cell.end(), lessGid);
+    if (_cell.empty()) {
+      _cell.swap(cell);
+      return;
+    }
+
+    std::vector<value_type> merged;
+    merged.reserve(_cell.size() + cell.size());
+    size_t ii = 0, jj = 0;
+    while (ii < _cell.size() || jj < cell.size()) {
+      if (jj == cell.size() ||
+          (ii < _cell.size() && _cell[ii].first < cell[jj].first)) {
+        merged.push_back(_cell[ii++]);
+      } else if (ii == _cell.size() || cell[jj].first < _cell[ii].first) {
+        merged.push_back(cell[jj++]);
+      } else {
+        qs_assert(_cell[ii].second._domainGid == cell[jj].second._domainGid);
+        merged.push_back(_cell[ii++]);
+        jj++;
+      }
+    }
+    _cell.swap(merged);
+  }
+
+private:
+  static bool lessGid(const value_type &aa, const value_type &bb) {
+    return aa.first < bb.first;
+  }
+  static bool lessThanGid(const value_type &aa, Long64 cellGid) {
+    return aa.first < cellGid;
+  }
+  iterator lowerBound(Long64 cellGid) {
+    return std::lower_bound(_cell.begin(), _cell.end(), cellGid, lessThanGid);
+  }
+
+  std::vector<value_type> _cell;
+};
+
 class MeshPartition {
 public:
-  typedef std::map<Long64, CellInfo> MapType;
+  typedef CellInfoMap MapType;
 
   MeshPartition(){};
   MeshPartition(int domainGid, int domainIndex, int foreman);
@@ -54,6 +130,15 @@ public:
                           const std::vector<MC_Vector> centers,
                           CommObject *comm);
 
+  // The two steps of buildMeshPartition.  assignCells floods the cells of
+  // this domain and only touches this partition, so the partitions of a
+  // rank can be assigned in parallel.  The exchange of exchangeCells
+  // writes into the partitions of the neighbors, so it has to run after
+  // all of them are assigned, one partition at a time.
+  void assignCells(const GlobalFccGrid &grid,
+                   const std::vector<MC_Vector> &centers);
+  void exchangeCells(const GlobalFccGrid &grid, CommObject *comm);
+
 private:
   int _domainGid;   //!< gid of this domain
   int _domainIndex; //!< local index of this domain
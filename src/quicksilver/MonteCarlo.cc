@@ -4,11 +4,14 @@
 #include "MC_Processor_Info.hh"
 #include "MC_RNG_State.hh"
 #include "MC_Time_Info.hh"
+#include "MacroscopicCrossSection.hh"
 #include "MaterialDatabase.hh"
 #include "NuclearData.hh"
 #include "ParticleVaultContainer.hh"
+#include "PersistentTracking.hh"
 #include "Tallies.hh"
 #include <cmath>
+#include <new>
 
 #include "cudaUtils.hh"
 #include "macros.hh" // current location of openMP wrappers.
@@ -22,6 +25,7 @@ MonteCarlo::MonteCarlo(const Parameters &params)
     : _params(params), _nuclearData(NULL) {
   _nuclearData = 0;
   _materialDatabase = 0;
+  _crossSectionTable = 0;
 
 #if defined(HAVE_UVM)
   void *ptr1, *ptr2, *ptr3, *ptr4;
@@ -51,6 +55,7 @@ MonteCarlo::MonteCarlo(const Parameters &params)
 #endif
 
   source_particle_weight = 0.0;
+  _crossSectionEpoch = 1;
 
   size_t num_processors = processor_info->num_processors;
   size_t num_particles = params.simulationParams.nParticles;
@@ -95,17 +100,32 @@ MonteCarlo::MonteCarlo(const Parameters &params)
   // Previous definition was not enough extra space for some reason? need to
   // determine why still
 
+  // A persistent tracking launch tracks several vaults before the extra
+  // vaults and the send queue are emptied.
+  int vaults_per_launch = 1;
+  if (params.simulationParams.trackingKernel == TrackingKernel::Persistent)
+    vaults_per_launch = params.simulationParams.persistentVaults;
+  num_extra_vaults *= vaults_per_launch;
+
+  ParticleVaultLayout::Enum vault_layout = ParticleVaultLayout::AoS;
+  if (params.simulationParams.vaultLayout == 1)
+    vault_layout = ParticleVaultLayout::SoA;
+  else if (params.simulationParams.vaultLayout == 2)
+    vault_layout = ParticleVaultLayout::Compact;
+
 #if defined(HAVE_UVM)
   void *ptr5, *ptr6;
   cudaMallocManaged(&ptr5, sizeof(MC_Particle_Buffer));
   cudaMallocManaged(&ptr6, sizeof(ParticleVaultContainer), cudaMemAttachHost);
   particle_buffer = new (ptr5) MC_Particle_Buffer(this, batch_size);
-  _particleVaultContainer = new (ptr6)
-      ParticleVaultContainer(batch_size, num_batches, num_extra_vaults);
+  _particleVaultContainer = new (ptr6) ParticleVaultContainer(
+      batch_size, num_batches, num_extra_vaults, vault_layout,
+      vaults_per_launch);
 #else
   particle_buffer = new MC_Particle_Buffer(this, batch_size);
-  _particleVaultContainer =
-      new ParticleVaultContainer(batch_size, num_batches, num_extra_vaults);
+  _particleVaultContainer = new ParticleVaultContainer(
+      batch_size, num_batches, num_extra_vaults, vault_layout,
+      vaults_per_launch);
 #endif
 }
 
@@ -118,6 +138,7 @@ MonteCarlo::~MonteCarlo() {
   _nuclearData->~NuclearData();
   _particleVaultContainer->~ParticleVaultContainer();
   _materialDatabase->~MaterialDatabase();
+  _crossSectionTable->~MacroscopicCrossSectionTable();
   _tallies->~Tallies();
   processor_info->~MC_Processor_Info();
   time_info->~MC_Time_Info();
@@ -127,6 +148,7 @@ MonteCarlo::~MonteCarlo() {
   cudaFree(_nuclearData);
   cudaFree(_particleVaultContainer);
   cudaFree(_materialDatabase);
+  cudaFree(_crossSectionTable);
   cudaFree(_tallies);
   cudaFree(processor_info);
   cudaFree(time_info);
@@ -137,6 +159,7 @@ MonteCarlo::~MonteCarlo() {
   delete _nuclearData;
   delete _particleVaultContainer;
   delete _materialDatabase;
+  delete _crossSectionTable;
   delete _tallies;
   delete processor_info;
   delete time_info;
@@ -145,8 +168,46 @@ MonteCarlo::~MonteCarlo() {
 #endif
 }
 
-void MonteCarlo::clearCrossSectionCache() {
+//----------------------------------------------------------------------------------------------------------------------
+// With the PerCycle cache every entry is cleared and recomputed on first use
+// in every cycle.  Otherwise only the cells that are stale (their epoch is
+// not the current one) are touched: the Epoch cache clears them for lazy
+// recomputation, the Precomputed cache fills in all of their groups now.
+//----------------------------------------------------------------------------------------------------------------------
+void MonteCarlo::updateCrossSectionCache() {
   int numEnergyGroups = _nuclearData->_numEnergyGroups;
-  for (unsigned ii = 0; ii < domain.size(); ++ii)
-    domain[ii].clearCrossSectionCache(numEnergyGroups);
+  int mode = _params.simulationParams.crossSectionCache;
+
+  if (mode == CrossSectionCacheMode::PerCycle) {
+    for (unsigned ii = 0; ii < domain.size(); ++ii)
+      domain[ii].clearCrossSectionCache(numEnergyGroups);
+    return;
+  }
+
+  for (int domainIndex = 0; domainIndex < domain.size(); domainIndex++) {
+    qs_vector<MC_Cell_State> &cell_state = domain[domainIndex].cell_state;
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int cellIndex = 0; cellIndex < cell_state.size(); cellIndex++) {
+      MC_Cell_State &cell = cell_state[cellIndex];
+      if (cell._crossSectionEpoch == _crossSectionEpoch)
+        continue;
+
+      for (int group = 0; group < numEnergyGroups; group++)
+        cell._total[group] =
+            (mode == CrossSectionCacheMode::Precomputed)
+                ? cellTotalCrossSection(this, domainIndex, cellIndex, group)
+                : 0.;
+      cell._crossSectionEpoch = _crossSectionEpoch;
+    }
+  }
+}
+
+void MonteCarlo::crossSectionDataChanged() {
+  _crossSectionTable->~MacroscopicCrossSectionTable();
+  new (_crossSectionTable) MacroscopicCrossSectionTable();
+  _crossSectionTable->build(*_materialDatabase, *_nuclearData);
+
+  _crossSectionEpoch++;
 }
@@ -8,6 +8,7 @@
 class MC_RNG_State;
 class NuclearData;
 class MaterialDatabase;
+class MacroscopicCrossSectionTable;
 class ParticleVaultContainer;
 class Tallies;
 class MC_Processor_Info;
@@ -21,7 +22,13 @@ public:
   ~MonteCarlo();
 
 public:
-  void clearCrossSectionCache();
+  // Gets the cached cross sections of the cells ready for the next cycle,
+  // as selected by the crossSectionCache parameter.
+  void updateCrossSectionCache();
+
+  // Call after changing the material database or the nuclear data.
+  // Rebuilds the material tables and makes the cache of every cell stale.
+  void crossSectionDataChanged();
 
   qs_vector<MC_Domain> domain;
 
@@ -29,6 +36,7 @@ public:
   NuclearData *_nuclearData;
   ParticleVaultContainer *_particleVaultContainer;
   MaterialDatabase *_materialDatabase;
+  MacroscopicCrossSectionTable *_crossSectionTable;
   Tallies *_tallies;
   MC_Time_Info *time_info;
   MC_Fast_Timer_Container *fast_timer;
@@ -37,6 +45,10 @@ public:
 
   double source_particle_weight;
 
+  // Incremented whenever the material or nuclear data change.  The cache
+  // of a cell is valid when its _crossSectionEpoch equals this.
+  uint64_t _crossSectionEpoch;
+
 private:
   // Disable copy constructor and assignment operator
   MonteCarlo(const MonteCarlo &);
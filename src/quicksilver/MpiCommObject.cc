@@ -133,27 +133,23 @@ void MpiCommObject::exchange(vector<FacetPair> sendBuf,
 }
 
 namespace {
+MPI_Datatype contiguousIntMpiType(int count) {
+  MPI_Datatype datatype;
+  mpiType_contiguous(count, MPI_INT, &datatype);
+  mpiType_commit(&datatype);
+  return datatype;
+}
+
+// Initialized once, also when several thread ranks get here at the same time.
 MPI_Datatype cellInfoMpiType() {
-  static MPI_Datatype datatype;
-  static bool inititalized = false;
-  if (!inititalized) {
-    mpiType_contiguous(4, MPI_INT, &datatype);
-    mpiType_commit(&datatype);
-    inititalized = true;
-  }
+  static MPI_Datatype datatype = contiguousIntMpiType(4);
   return datatype;
 }
 } // namespace
 
 namespace {
 MPI_Datatype facetPairMpiType() {
-  static MPI_Datatype datatype;
-  static bool inititalized = false;
-  if (!inititalized) {
-    mpiType_contiguous(8, MPI_INT, &datatype);
-    mpiType_commit(&datatype);
-    inititalized = true;
-  }
+  static MPI_Datatype datatype = contiguousIntMpiType(8);
   return datatype;
 }
 } // namespace
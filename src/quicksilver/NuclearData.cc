@@ -111,6 +111,33 @@ NuclearData::NuclearData(int numGroups, double energyLow, double energyHigh)
     double logValue = logLow + delta * energyIndex;
     _energies[energyIndex] = exp(logValue);
   }
+  initEnergyGroupLookup();
+}
+
+// Build the log bucket table used by getEnergyGroup.  This must be
+// called again if _energies is changed.
+void NuclearData::initEnergyGroupLookup() {
+  // Grids where one bucket spans more groups than this use the binary
+  // search.
+  const int maxGroupsPerBucket = 2;
+
+  int numEnergies = (int)_energies.size();
+  int numBuckets = 2 * (numEnergies - 1);
+  _lookupLogLow = log(_energies[0]);
+  _lookupScale = numBuckets / (log(_energies[numEnergies - 1]) - _lookupLogLow);
+
+  qs_vector<int> groupLookup(numBuckets + 1, VAR_MEM);
+  for (int bucket = 0; bucket <= numBuckets; bucket++)
+    groupLookup[bucket] =
+        searchEnergyGroup(exp(_lookupLogLow + bucket / _lookupScale));
+
+  int maxSpan = 0;
+  for (int bucket = 0; bucket < numBuckets; bucket++)
+    maxSpan = std::max(maxSpan, groupLookup[bucket + 1] - groupLookup[bucket]);
+
+  if (maxSpan > maxGroupsPerBucket)
+    groupLookup = qs_vector<int>();
+  _groupLookup.swap(groupLookup);
 }
 
 int NuclearData::addIsotope(int nReactions, const Polynomial &fissionFunction,
@@ -201,6 +228,46 @@ int NuclearData::getEnergyGroup(double energy) {
   if (energy > _energies[numEnergies - 1])
     return numEnergies - 1;
 
+  int numBuckets = _groupLookup.size() - 1;
+  if (numBuckets < 1)
+    return searchEnergyGroup(energy);
+
+  int bucket = (int)((log(energy) - _lookupLogLow) * _lookupScale);
+  bucket = (bucket < 0) ? 0 : (bucket >= numBuckets ? numBuckets - 1 : bucket);
+
+  int low = _groupLookup[bucket];
+  int high = _groupLookup[bucket + 1] + 1;
+  if (high > numEnergies - 1)
+    high = numEnergies - 1;
+
+  // Roundoff in the log can put the energy just outside the bucket.
+  if (energy < _energies[low])
+    low = 0;
+  if (energy >= _energies[high])
+    high = numEnergies - 1;
+
+  while (high != low + 1) {
+    int mid = (high + low) / 2;
+    if (energy < _energies[mid])
+      high = mid;
+    else
+      low = mid;
+  }
+
+  return low;
+}
+HOST_DEVICE_END
+
+// For this energy, return the group index by binary search of the whole
+// energy grid.
+HOST_DEVICE
+int NuclearData::searchEnergyGroup(double energy) {
+  int numEnergies = (int)_energies.size();
+  if (energy <= _energies[0])
+    return 0;
+  if (energy > _energies[numEnergies - 1])
+    return numEnergies - 1;
+
   int high = numEnergies - 1;
   int low = 0;
 
@@ -81,6 +81,9 @@ public:
   HOST_DEVICE_CUDA
   int getEnergyGroup(double energy);
   HOST_DEVICE_CUDA
+  int searchEnergyGroup(double energy);
+  void initEnergyGroupLookup();
+  HOST_DEVICE_CUDA
   int getNumberReactions(unsigned int isotopeIndex);
   HOST_DEVICE_CUDA
   double getTotalCrossSection(unsigned int isotopeIndex, unsigned int group);
@@ -95,6 +98,16 @@ public:
   // This is the overall energy layout. If we had more than just
   // neutrons, this array would be a vector of vectors.
   qs_vector<double> _energies;
+
+  // getEnergyGroup maps log(energy) to one of _groupLookup.size() - 1
+  // equal width buckets between _energies[0] and the last energy.
+  // _groupLookup[b] is the group that contains the low edge of bucket
+  // b, so only the few groups between _groupLookup[b] and
+  // _groupLookup[b+1] need to be searched.  _groupLookup is empty
+  // when the grid is too far from log-uniform for this to pay off.
+  double _lookupLogLow;
+  double _lookupScale; //!< buckets per unit of log(energy)
+  qs_vector<int> _groupLookup;
 };
 
 #endif
@@ -80,6 +80,13 @@ Parameters getParameters(int argc, char **argv) {
   const string &filename = params.simulationParams.inputFile;
   const string energyName = params.simulationParams.energySpectrum;
   const string xsecOut = params.simulationParams.crossSectionsOut;
+  const string metricsFile = params.simulationParams.metricsFile;
+  const string checkpointFile = params.simulationParams.checkpointFile;
+  const string restartFile = params.simulationParams.restartFile;
+  const string scalingThreads = params.simulationParams.scalingThreads;
+  const string scalingBatchSizes = params.simulationParams.scalingBatchSizes;
+  const string scalingCsv = params.simulationParams.scalingCsv;
+  const string scalingLabel = params.simulationParams.scalingLabel;
 
   if (!filename.empty())
     parseInputFile(filename, params);
@@ -87,6 +94,20 @@ Parameters getParameters(int argc, char **argv) {
     params.simulationParams.energySpectrum = energyName;
   if (xsecOut != "")
     params.simulationParams.crossSectionsOut = xsecOut;
+  if (metricsFile != "")
+    params.simulationParams.metricsFile = metricsFile;
+  if (checkpointFile != "")
+    params.simulationParams.checkpointFile = checkpointFile;
+  if (restartFile != "")
+    params.simulationParams.restartFile = restartFile;
+  if (scalingThreads != "")
+    params.simulationParams.scalingThreads = scalingThreads;
+  if (scalingBatchSizes != "")
+    params.simulationParams.scalingBatchSizes = scalingBatchSizes;
+  if (scalingCsv != "")
+    params.simulationParams.scalingCsv = scalingCsv;
+  if (scalingLabel != "")
+    params.simulationParams.scalingLabel = scalingLabel;
 
   supplyDefaults(params);
 
@@ -148,8 +169,42 @@ ostream &operator<<(ostream &out, const SimulationParameters &pp) {
   out << "   bTally: " << pp.balanceTallyReplications << "\n";
   out << "   fTally: " << pp.fluxTallyReplications << "\n";
   out << "   cTally: " << pp.cellTallyReplications << "\n";
+  out << "   tallyMode: " << pp.tallyMode << "\n";
+  out << "   arenaSize: " << pp.arenaSize << "\n";
   out << "   coralBenchmark: " << pp.coralBenchmark << "\n";
+  out << "   vaultLayout: " << pp.vaultLayout << "\n";
+  out << "   vaultBenchmark: " << pp.vaultBenchmark << "\n";
+  out << "   vaultSort: " << pp.vaultSort << "\n";
+  out << "   vaultSortBenchmark: " << pp.vaultSortBenchmark << "\n";
+  out << "   parallelPopulationControl: " << pp.parallelPopulationControl
+      << "\n";
+  out << "   crossSectionCache: " << pp.crossSectionCache << "\n";
+  out << "   trackingKernel: " << pp.trackingKernel << "\n";
+  out << "   persistentVaults: " << pp.persistentVaults << "\n";
+  out << "   trackingKernelBenchmark: " << pp.trackingKernelBenchmark << "\n";
+  out << "   trackingMode: " << pp.trackingMode << "\n";
+  out << "   trackingBenchmark: " << pp.trackingBenchmark << "\n";
+  out << "   trackingScheduler: " << pp.trackingScheduler << "\n";
+  out << "   trackingChunkSize: " << pp.trackingChunkSize << "\n";
+  out << "   sendChunkSize: " << pp.sendChunkSize << "\n";
+  out << "   threadRanks: " << pp.threadRanks << "\n";
+  out << "   rngType: " << pp.rngType << "\n";
+  out << "   rngBenchmark: " << pp.rngBenchmark << "\n";
+  out << "   energyGroupBenchmark: " << pp.energyGroupBenchmark << "\n";
+  out << "   meshBenchmark: " << pp.meshBenchmark << "\n";
+  out << "   scalingMode: " << pp.scalingMode << "\n";
+  out << "   scalingProblem: " << pp.scalingProblem << "\n";
+  out << "   scalingThreads: " << pp.scalingThreads << "\n";
+  out << "   scalingBatchSizes: " << pp.scalingBatchSizes << "\n";
+  out << "   scalingCsv: " << pp.scalingCsv << "\n";
+  out << "   scalingLabel: " << pp.scalingLabel << "\n";
+  out << "   compactComm: " << pp.compactComm << "\n";
+  out << "   compactAccuracy: " << pp.compactAccuracy << "\n";
   out << "   crossSectionsOut:" << pp.crossSectionsOut << "\n";
+  out << "   metricsFile: " << pp.metricsFile << "\n";
+  out << "   checkpointFile: " << pp.checkpointFile << "\n";
+  out << "   checkpointInterval: " << pp.checkpointInterval << "\n";
+  out << "   restartFile: " << pp.restartFile << "\n";
   out << endl;
   return out;
 }
@@ -223,6 +278,20 @@ void parseCommandLine(int argc, char **argv, Parameters &pp) {
   esName[0] = '\0';
   char xsec[1024];
   xsec[0] = '\0';
+  char metrics[1024];
+  metrics[0] = '\0';
+  char checkpoint[1024];
+  checkpoint[0] = '\0';
+  char restart[1024];
+  restart[0] = '\0';
+  char scalingThreads[1024];
+  scalingThreads[0] = '\0';
+  char scalingBatchSizes[1024];
+  scalingBatchSizes[0] = '\0';
+  char scalingCsv[1024];
+  scalingCsv[0] = '\0';
+  char scalingLabel[1024];
+  scalingLabel[0] = '\0';
 
   addArg("help", 'h', 0, 'i', &(help), 0, "print this message");
   addArg("dt", 'D', 1, 'd', &(sp.dt), 0, "time step (seconds)");
@@ -233,6 +302,14 @@ void parseCommandLine(int argc, char **argv, Parameters &pp) {
          "name of energy spectrum output file");
   addArg("crossSectionsOut", 'S', 1, 's', &(xsec), sizeof(xsec),
          "name of cross section output file");
+  addArg("metricsFile", 0, 1, 's', &(metrics), sizeof(metrics),
+         "name of per cycle metrics output file (.csv = CSV, else JSON lines)");
+  addArg("checkpointFile", 0, 1, 's', &(checkpoint), sizeof(checkpoint),
+         "name of binary checkpoint file to write");
+  addArg("checkpointInterval", 0, 1, 'i', &(sp.checkpointInterval), 0,
+         "cycles between checkpoints (0 = after the last cycle only)");
+  addArg("restartFile", 0, 1, 's', &(restart), sizeof(restart),
+         "name of checkpoint file to restart from");
   addArg("loadBalance", 'l', 0, 'i', &(sp.loadBalance), 0,
          "enable/disable load balancing");
   addArg("cycleTimers", 'c', 1, 'i', &(sp.cycleTimers), 0,
@@ -261,12 +338,89 @@ void parseCommandLine(int argc, char **argv, Parameters &pp) {
          "number of scalar flux tally replications");
   addArg("cTally", 'C', 1, 'i', &(sp.cellTallyReplications), 0,
          "number of scalar cell tally replications");
+  addArg("tallyMode", 0, 1, 'i', &(sp.tallyMode), 0,
+         "flux and cell tallies: 0 = shared replications (fTally, cTally), "
+         "1 = one private replication per thread");
+  addArg("arenaSize", 0, 1, 'i', &(sp.arenaSize), 0,
+         "MiB to reserve for vaults, tallies and particle buffers (0 = heap)");
+  addArg("vaultLayout", 0, 1, 'i', &(sp.vaultLayout), 0,
+         "particle vault layout: 0 = array of structs, 1 = struct of arrays, "
+         "2 = compact mixed precision structs");
+  addArg("vaultBenchmark", 0, 0, 'i', &(sp.vaultBenchmark), 0,
+         "compare segments/sec of the AoS, SoA and compact particle vaults");
+  addArg("compactComm", 0, 0, 'i', &(sp.compactComm), 0,
+         "send particles between ranks in the compact mixed precision form");
+  addArg("compactAccuracy", 0, 0, 'i', &(sp.compactAccuracy), 0,
+         "report the error of the compact particle form after the run");
+  addArg("vaultSort", 0, 1, 'i', &(sp.vaultSort), 0,
+         "sort the particles before tracking: 0 = off, 1 = by cell, "
+         "2 = by Morton code of the position");
+  addArg("vaultSortBenchmark", 0, 0, 'i', &(sp.vaultSortBenchmark), 0,
+         "compare the cost of each vault sort with its tracking speedup");
+  addArg("parallelPopulationControl", 0, 0, 'i',
+         &(sp.parallelPopulationControl), 0,
+         "split and roulette the particles in parallel between cycles");
+  addArg("crossSectionCache", 0, 1, 'i', &(sp.crossSectionCache), 0,
+         "cell cross section cache: 0 = cleared every cycle, 1 = kept until "
+         "the data change, 2 = precomputed");
+  addArg("trackingKernel", 0, 1, 'i', &(sp.trackingKernel), 0,
+         "history-based tracking: 0 = a launch per vault, 1 = persistent "
+         "kernel pulling particles from a work queue");
+  addArg("persistentVaults", 0, 1, 'i', &(sp.persistentVaults), 0,
+         "processing vaults tracked per launch of the persistent kernel");
+  addArg("trackingKernelBenchmark", 0, 0, 'i', &(sp.trackingKernelBenchmark),
+         0, "compare the per vault and persistent tracking kernels");
+  addArg("trackingMode", 0, 1, 'i', &(sp.trackingMode), 0,
+         "particle tracking: 0 = history-based, 1 = event-based");
+  addArg("trackingBenchmark", 0, 0, 'i', &(sp.trackingBenchmark), 0,
+         "compare segments/sec of history-based and event-based tracking");
+  addArg("trackingScheduler", 0, 1, 'i', &(sp.trackingScheduler), 0,
+         "history-based CPU tracking: 0 = static OpenMP loop, "
+         "1 = work stealing (not with tallyMode 1)");
+  addArg("trackingChunkSize", 0, 1, 'i', &(sp.trackingChunkSize), 0,
+         "particles per chunk for the work stealing scheduler and the "
+         "persistent kernel on the CPU");
+  addArg("sendChunkSize", 0, 1, 'i', &(sp.sendChunkSize), 0,
+         "send particles leaving the domain in chunks of this size while "
+         "tracking (0 = after each vault)");
+  addArg("threadRanks", 0, 1, 'i', &(sp.threadRanks), 0,
+         "run this many ranks, each with its own domain, as threads of one "
+         "process (build without MPI)");
+  addArg("rngType", 0, 1, 'i', &(sp.rngType), 0,
+         "random numbers: 0 = 64 bit LCG, 1 = counter based Philox");
+  addArg("rngBenchmark", 0, 0, 'i', &(sp.rngBenchmark), 0,
+         "compare samples/sec and segments/sec of the LCG and Philox");
+  addArg("energyGroupBenchmark", 0, 0, 'i', &(sp.energyGroupBenchmark), 0,
+         "measure energy group lookups/sec after the run");
+  addArg("meshBenchmark", 0, 1, 'i', &(sp.meshBenchmark), 0,
+         "time the mesh setup for 1e5 cells up to 10^this many cells");
+  addArg("scalingMode", 0, 1, 'i', &(sp.scalingMode), 0,
+         "QuicksilverScaling sweep: 0 = strong scaling, 1 = weak scaling");
+  addArg("scalingProblem", 0, 1, 'i', &(sp.scalingProblem), 0,
+         "QuicksilverScaling problem: 0 = the input, 1 = CORAL2 problem 1");
+  addArg("scalingThreads", 0, 1, 's', &(scalingThreads),
+         sizeof(scalingThreads),
+         "QuicksilverScaling thread counts, comma separated");
+  addArg("scalingBatchSizes", 0, 1, 's', &(scalingBatchSizes),
+         sizeof(scalingBatchSizes),
+         "QuicksilverScaling batch sizes, comma separated");
+  addArg("scalingCsv", 0, 1, 's', &(scalingCsv), sizeof(scalingCsv),
+         "QuicksilverScaling results file to append to (scaling.csv)");
+  addArg("scalingLabel", 0, 1, 's', &(scalingLabel), sizeof(scalingLabel),
+         "label of this build in the QuicksilverScaling results");
 
   processArgs(argc, argv);
 
   sp.inputFile = name;
   sp.energySpectrum = esName;
   sp.crossSectionsOut = xsec;
+  sp.metricsFile = metrics;
+  sp.checkpointFile = checkpoint;
+  sp.restartFile = restart;
+  sp.scalingThreads = scalingThreads;
+  sp.scalingBatchSizes = scalingBatchSizes;
+  sp.scalingCsv = scalingCsv;
+  sp.scalingLabel = scalingLabel;
 
   if (help) {
     int rank = -1;
@@ -379,6 +533,10 @@ void scanSimulationBlock(const InputBlock &input, Parameters &pp) {
   SimulationParameters &sp = pp.simulationParams;
   input.getValue<string>("energySpectrum", sp.energySpectrum);
   input.getValue<string>("crossSectionsOut", sp.crossSectionsOut);
+  input.getValue<string>("metricsFile", sp.metricsFile);
+  input.getValue<string>("checkpointFile", sp.checkpointFile);
+  input.getValue<int>("checkpointInterval", sp.checkpointInterval);
+  input.getValue<string>("restartFile", sp.restartFile);
   input.getValue<string>("boundaryCondition", sp.boundaryCondition);
   input.getValue<double>("dt", sp.dt);
   input.getValue<double>("fMax", sp.fMax);
@@ -406,7 +564,37 @@ void scanSimulationBlock(const InputBlock &input, Parameters &pp) {
   input.getValue<int>("bTally", sp.balanceTallyReplications);
   input.getValue<int>("fTally", sp.fluxTallyReplications);
   input.getValue<int>("cTally", sp.cellTallyReplications);
+  input.getValue<int>("tallyMode", sp.tallyMode);
+  input.getValue<int>("arenaSize", sp.arenaSize);
   input.getValue<int>("coralBenchmark", sp.coralBenchmark);
+  input.getValue<int>("vaultLayout", sp.vaultLayout);
+  input.getValue<int>("vaultBenchmark", sp.vaultBenchmark);
+  input.getValue<int>("vaultSort", sp.vaultSort);
+  input.getValue<int>("vaultSortBenchmark", sp.vaultSortBenchmark);
+  input.getValue<int>("parallelPopulationControl",
+                      sp.parallelPopulationControl);
+  input.getValue<int>("crossSectionCache", sp.crossSectionCache);
+  input.getValue<int>("trackingKernel", sp.trackingKernel);
+  input.getValue<int>("persistentVaults", sp.persistentVaults);
+  input.getValue<int>("trackingKernelBenchmark", sp.trackingKernelBenchmark);
+  input.getValue<int>("trackingMode", sp.trackingMode);
+  input.getValue<int>("trackingBenchmark", sp.trackingBenchmark);
+  input.getValue<int>("trackingScheduler", sp.trackingScheduler);
+  input.getValue<int>("trackingChunkSize", sp.trackingChunkSize);
+  input.getValue<int>("sendChunkSize", sp.sendChunkSize);
+  input.getValue<int>("threadRanks", sp.threadRanks);
+  input.getValue<int>("rngType", sp.rngType);
+  input.getValue<int>("rngBenchmark", sp.rngBenchmark);
+  input.getValue<int>("energyGroupBenchmark", sp.energyGroupBenchmark);
+  input.getValue<int>("meshBenchmark", sp.meshBenchmark);
+  input.getValue<int>("scalingMode", sp.scalingMode);
+  input.getValue<int>("scalingProblem", sp.scalingProblem);
+  input.getValue<string>("scalingThreads", sp.scalingThreads);
+  input.getValue<string>("scalingBatchSizes", sp.scalingBatchSizes);
+  input.getValue<string>("scalingCsv", sp.scalingCsv);
+  input.getValue<string>("scalingLabel", sp.scalingLabel);
+  input.getValue<int>("compactComm", sp.compactComm);
+  input.getValue<int>("compactAccuracy", sp.compactAccuracy);
 }
 } // namespace
 
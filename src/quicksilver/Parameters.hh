@@ -80,13 +80,30 @@ struct SimulationParameters {
         seed(1029384756), xDom(0), yDom(0), zDom(0), dt(1e-8), fMax(0.1),
         lx(100.0), ly(100.0), lz(100.0), eMin(1e-9), eMax(20), nGroups(230),
         lowWeightCutoff(0.001), balanceTallyReplications(1),
-        fluxTallyReplications(1), cellTallyReplications(1), coralBenchmark(0){};
+        fluxTallyReplications(1), cellTallyReplications(1), coralBenchmark(0),
+        vaultLayout(0), vaultBenchmark(0), trackingMode(0),
+        trackingBenchmark(0), energyGroupBenchmark(0), tallyMode(0),
+        arenaSize(0), trackingScheduler(0), trackingChunkSize(64),
+        sendChunkSize(0), threadRanks(0), rngType(0), rngBenchmark(0),
+        vaultSort(0), vaultSortBenchmark(0), checkpointInterval(0),
+        meshBenchmark(0), parallelPopulationControl(0),
+        crossSectionCache(1), trackingKernel(0), persistentVaults(16),
+        trackingKernelBenchmark(0), scalingMode(0), scalingProblem(1),
+        compactComm(0), compactAccuracy(0){};
 
   std::string inputFile;      //!< name of input file
   std::string energySpectrum; //!< enble computing and printing energy spectrum
                               //!< via of energy spectrum file
   std::string crossSectionsOut;  //!< enable or disable printing cross section
                                  //!< data to a file
+  std::string metricsFile; //!< per cycle metrics output file (CSV if the
+                           //!< name ends in .csv, else JSON lines)
+  std::string checkpointFile; //!< binary checkpoint written by the run
+  std::string restartFile;    //!< checkpoint the run starts from
+  std::string scalingThreads;    //!< thread counts of the scaling benchmark
+  std::string scalingBatchSizes; //!< batch sizes of the scaling benchmark
+  std::string scalingCsv;        //!< scaling benchmark results (CSV)
+  std::string scalingLabel;      //!< build label in the scaling results
   std::string boundaryCondition; //!< specifies boundary conditions
   int loadBalance;               //!< enable or disable load balancing
   int cycleTimers;               //!< enable or disable cycle timers
@@ -118,6 +135,51 @@ struct SimulationParameters {
   int cellTallyReplications;     //!< Number of replications for the scalar cell
                                  //!< tally
   int coralBenchmark; //!< enable correctness check for Coral2 benchmark
+  int vaultLayout;    //!< particle vault memory layout (0 = AoS, 1 = SoA,
+                      //!< 2 = compact mixed precision)
+  int vaultBenchmark; //!< run the problem with each vault layout and compare
+                      //!< the figure of merit
+  int trackingMode;   //!< particle tracking (0 = history-based, 1 =
+                      //!< event-based)
+  int trackingBenchmark; //!< run the problem with each tracking mode and
+                         //!< compare the figure of merit
+  int energyGroupBenchmark; //!< time the energy group lookup after the run
+  int tallyMode; //!< flux and cell tallies (0 = shared replications, 1 =
+                 //!< thread-private)
+  int arenaSize; //!< MiB reserved for the memory arena (0 = no arena)
+  int trackingScheduler; //!< CPU particle loop (0 = static OpenMP for, 1 =
+                         //!< work stealing)
+  int trackingChunkSize; //!< particles per work stealing chunk
+  int sendChunkSize; //!< particles per pipelined send (0 = send the particles
+                     //!< that left the domain after each vault)
+  int threadRanks; //!< ranks to run as threads of this process (0 = off)
+  int rngType;     //!< random number generator (0 = LCG, 1 = Philox)
+  int rngBenchmark; //!< time the random number generators and run the
+                    //!< problem with each of them
+  int vaultSort; //!< order of the processing vaults before tracking (0 =
+                 //!< unsorted, 1 = by cell, 2 = by Morton code of position)
+  int vaultSortBenchmark; //!< run the problem with each vault sort and
+                          //!< compare its cost with the tracking speedup
+  int checkpointInterval; //!< cycles between checkpoints (0 = after the
+                          //!< last cycle only)
+  int meshBenchmark; //!< time the mesh setup of 1e5 up to 10^meshBenchmark
+                     //!< cells (0 = off)
+  int parallelPopulationControl; //!< split and roulette the particles with
+                                 //!< all threads (0 = serial)
+  int crossSectionCache; //!< cell cross section cache (0 = cleared every
+                         //!< cycle, 1 = until the data change,
+                         //!< 2 = precomputed)
+  int trackingKernel; //!< history-based tracking launches (0 = one per
+                      //!< vault, 1 = persistent kernel)
+  int persistentVaults; //!< vaults tracked per persistent kernel launch
+  int trackingKernelBenchmark; //!< compare the per vault and persistent
+                               //!< tracking kernels
+  int scalingMode;    //!< scaling benchmark sweep (0 = strong, 1 = weak)
+  int scalingProblem; //!< problem of the scaling benchmark (0 = the input,
+                      //!< 1 = CORAL2 problem 1)
+  int compactComm; //!< send particles in the compact mixed precision form
+  int compactAccuracy; //!< report the error of the compact particle form
+                       //!< after the run
 };
 
 struct Parameters {
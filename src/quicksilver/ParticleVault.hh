@@ -3,37 +3,103 @@
 
 #include "DeclareMacro.hh"
 #include "MC_Base_Particle.hh"
+#include "MC_Compact_Particle.hh"
+#include "ParticleVaultSoA.hh"
 #include "QS_Vector.hh"
 
 #include <vector>
 
+// How a vault stores its particles in memory.  AoS keeps whole
+// MC_Base_Particles next to each other, SoA keeps each field in its own
+// array (see ParticleVaultSoA.hh), and Compact keeps mixed precision
+// MC_Compact_Particles next to each other.
+struct ParticleVaultLayout {
+  enum Enum { AoS = 0, SoA = 1, Compact = 2 };
+};
+
 class ParticleVault {
 public:
+  ParticleVault() : _layout(ParticleVaultLayout::AoS) {}
+
   // Is the vault empty.
-  bool empty() const { return _particles.empty(); }
+  bool empty() const {
+    if (_layout == ParticleVaultLayout::SoA)
+      return _soa.empty();
+    if (_layout == ParticleVaultLayout::Compact)
+      return _compact.empty();
+    return _particles.empty();
+  }
 
   // Get the size of the vault.
   HOST_DEVICE_CUDA
-  size_t size() const { return _particles.size(); }
+  size_t size() const {
+    if (_layout == ParticleVaultLayout::SoA)
+      return _soa.size();
+    if (_layout == ParticleVaultLayout::Compact)
+      return _compact.size();
+    return _particles.size();
+  }
+
+  // Get the memory layout of the vault.
+  ParticleVaultLayout::Enum layout() const { return _layout; }
 
   // Reserve the size for the container of particles.
-  void reserve(size_t n) { _particles.reserve(n, VAR_MEM); }
+  void reserve(size_t n,
+               ParticleVaultLayout::Enum layout = ParticleVaultLayout::AoS,
+               MemoryControl::AllocationPolicy memPolicy = VAR_MEM) {
+    _layout = layout;
+    if (_layout == ParticleVaultLayout::SoA)
+      _soa.reserve(n, memPolicy);
+    else if (_layout == ParticleVaultLayout::Compact)
+      _compact.reserve(n, memPolicy);
+    else
+      _particles.reserve(n, memPolicy);
+  }
 
   // Add all particles in a 2nd vault into this vault.
   void append(ParticleVault &vault2) {
-    _particles.appendList(vault2._particles.size(), &vault2._particles[0]);
+    qs_assert(_layout == vault2._layout);
+    if (_layout == ParticleVaultLayout::SoA)
+      _soa.appendList(vault2._soa);
+    else if (_layout == ParticleVaultLayout::Compact)
+      _compact.appendList(vault2._compact.size(), &vault2._compact[0]);
+    else
+      _particles.appendList(vault2._particles.size(), &vault2._particles[0]);
   }
 
   void collapse(size_t fill_size, ParticleVault *vault2);
 
   // Clear all particles from the vault
-  void clear() { _particles.clear(); }
+  void clear() {
+    if (_layout == ParticleVaultLayout::SoA)
+      _soa.clear();
+    else if (_layout == ParticleVaultLayout::Compact)
+      _compact.clear();
+    else
+      _particles.clear();
+  }
 
-  // Access particle at a given index.
-  MC_Base_Particle &operator[](size_t n) { return _particles[n]; }
+  // Set the number of particles in the vault, up to the reserved size.
+  // Added particles hold garbage until they are put.
+  void setSize(size_t n) {
+    if (_layout == ParticleVaultLayout::SoA) {
+      _soa.setSize(n);
+    } else if (_layout == ParticleVaultLayout::Compact) {
+      qs_assert(n <= (size_t)_compact.capacity());
+      _compact.eraseEnd(n);
+    } else {
+      qs_assert(n <= (size_t)_particles.capacity());
+      _particles.eraseEnd(n);
+    }
+  }
 
-  // Access a particle at a given index.
-  const MC_Base_Particle &operator[](size_t n) const { return _particles[n]; }
+  // Copy the base particle at a given index out of the vault.
+  HOST_DEVICE_CUDA
+  void getBaseParticle(MC_Base_Particle &base_particle, int index) const;
+
+  // Copy a base particle into the vault at a given index.
+  HOST_DEVICE_CUDA
+  void putBaseParticle(const MC_Base_Particle &base_particle, int index);
 
   // Put a particle into the vault, down casting its class.
   HOST_DEVICE_CUDA
@@ -73,23 +139,81 @@ public:
   void eraseSwapParticle(int index);
 
 private:
-  // The container of particles.
+  // Removes the last particle, copying it into base_particle.
+  void takeBackParticle(MC_Base_Particle &base_particle);
+
+  // The memory layout used by this vault.
+  ParticleVaultLayout::Enum _layout;
+
+  // The container of particles when the layout is AoS.
   qs_vector<MC_Base_Particle> _particles;
+
+  // The container of particles when the layout is SoA.
+  ParticleVaultSoA _soa;
+
+  // The container of particles when the layout is Compact.
+  qs_vector<MC_Compact_Particle> _compact;
 };
 
+// -----------------------------------------------------------------------
+HOST_DEVICE_CUDA
+inline void ParticleVault::getBaseParticle(MC_Base_Particle &base_particle,
+                                           int index) const {
+  if (_layout == ParticleVaultLayout::SoA)
+    _soa.load(index, base_particle);
+  else if (_layout == ParticleVaultLayout::Compact)
+    _compact[index].unpack(base_particle);
+  else
+    base_particle = _particles[index];
+}
+
+// -----------------------------------------------------------------------
+HOST_DEVICE_CUDA
+inline void
+ParticleVault::putBaseParticle(const MC_Base_Particle &base_particle,
+                               int index) {
+  if (_layout == ParticleVaultLayout::SoA)
+    _soa.store(index, base_particle);
+  else if (_layout == ParticleVaultLayout::Compact)
+    _compact[index].pack(base_particle);
+  else
+    _particles[index] = base_particle;
+}
+
+// -----------------------------------------------------------------------
+inline void ParticleVault::takeBackParticle(MC_Base_Particle &base_particle) {
+  if (_layout == ParticleVaultLayout::SoA) {
+    _soa.load(_soa.size() - 1, base_particle);
+    _soa.pop_back();
+  } else if (_layout == ParticleVaultLayout::Compact) {
+    _compact.back().unpack(base_particle);
+    _compact.pop_back();
+  } else {
+    base_particle = _particles.back();
+    _particles.pop_back();
+  }
+}
+
 // -----------------------------------------------------------------------
 HOST_DEVICE_CUDA
 inline void ParticleVault::pushParticle(MC_Particle &particle) {
   MC_Base_Particle base_particle(particle);
-  size_t indx = _particles.atomic_Index_Inc(1);
-  _particles[indx] = base_particle;
+  pushBaseParticle(base_particle);
 }
 
 // -----------------------------------------------------------------------
 HOST_DEVICE_CUDA
 inline void ParticleVault::pushBaseParticle(MC_Base_Particle &base_particle) {
-  int indx = _particles.atomic_Index_Inc(1);
-  _particles[indx] = base_particle;
+  if (_layout == ParticleVaultLayout::SoA) {
+    int indx = _soa.atomic_Index_Inc(1);
+    _soa.store(indx, base_particle);
+  } else if (_layout == ParticleVaultLayout::Compact) {
+    int indx = _compact.atomic_Index_Inc(1);
+    _compact[indx].pack(base_particle);
+  } else {
+    int indx = _particles.atomic_Index_Inc(1);
+    _particles[indx] = base_particle;
+  }
 }
 
 // -----------------------------------------------------------------------
@@ -99,8 +223,7 @@ inline bool ParticleVault::popBaseParticle(MC_Base_Particle &base_particle) {
 #include "mc_omp_critical.hh"
   {
     if (!empty()) {
-      base_particle = _particles.back();
-      _particles.pop_back();
+      takeBackParticle(base_particle);
       notEmpty = true;
     }
   }
@@ -114,8 +237,8 @@ inline bool ParticleVault::popParticle(MC_Particle &particle) {
 #include "mc_omp_critical.hh"
   {
     if (!empty()) {
-      MC_Base_Particle base_particle(_particles.back());
-      _particles.pop_back();
+      MC_Base_Particle base_particle;
+      takeBackParticle(base_particle);
       particle = MC_Particle(base_particle);
       notEmpty = true;
     }
@@ -126,9 +249,9 @@ inline bool ParticleVault::popParticle(MC_Particle &particle) {
 // -----------------------------------------------------------------------
 inline bool ParticleVault::getBaseParticleComm(MC_Base_Particle &particle,
                                                int index) {
-  if (size() > index) {
-    particle = _particles[index];
-    _particles[index].species = -1;
+  if ((int)size() > index) {
+    getBaseParticle(particle, index);
+    invalidateParticle(index);
     return true;
   } else {
     qs_assert(false);
@@ -139,9 +262,10 @@ inline bool ParticleVault::getBaseParticleComm(MC_Base_Particle &particle,
 // -----------------------------------------------------------------------
 HOST_DEVICE_CUDA
 inline bool ParticleVault::getParticle(MC_Particle &particle, int index) {
-  qs_assert(size() > index);
-  if (size() > index) {
-    MC_Base_Particle base_particle(_particles[index]);
+  qs_assert((int)size() > index);
+  if ((int)size() > index) {
+    MC_Base_Particle base_particle;
+    getBaseParticle(base_particle, index);
     particle = MC_Particle(base_particle);
     return true;
   }
@@ -150,10 +274,10 @@ inline bool ParticleVault::getParticle(MC_Particle &particle, int index) {
 
 // -----------------------------------------------------------------------
 inline bool ParticleVault::putParticle(MC_Particle particle, int index) {
-  qs_assert(size() > index);
-  if (size() > index) {
+  qs_assert((int)size() > index);
+  if ((int)size() > index) {
     MC_Base_Particle base_particle(particle);
-    _particles[index] = base_particle;
+    putBaseParticle(base_particle, index);
     return true;
   }
   return false;
@@ -162,16 +286,29 @@ inline bool ParticleVault::putParticle(MC_Particle particle, int index) {
 // -----------------------------------------------------------------------
 inline void ParticleVault::invalidateParticle(int index) {
   qs_assert(index >= 0);
-  qs_assert(index < _particles.size());
-  _particles[index].species = -1;
+  qs_assert(index < (int)size());
+  if (_layout == ParticleVaultLayout::SoA)
+    _soa.species(index) = -1;
+  else if (_layout == ParticleVaultLayout::Compact)
+    _compact[index].species = -1;
+  else
+    _particles[index].species = -1;
 }
 
 // -----------------------------------------------------------------------
 inline void ParticleVault::eraseSwapParticle(int index) {
 #include "mc_omp_critical.hh"
   {
-    _particles[index] = _particles.back();
-    _particles.pop_back();
+    if (_layout == ParticleVaultLayout::SoA) {
+      _soa.copy(index, _soa.size() - 1);
+      _soa.pop_back();
+    } else if (_layout == ParticleVaultLayout::Compact) {
+      _compact[index] = _compact.back();
+      _compact.pop_back();
+    } else {
+      _particles[index] = _particles.back();
+      _particles.pop_back();
+    }
   }
 }
 
@@ -3,6 +3,7 @@
 #include "ParticleVault.hh"
 #include "SendQueue.hh"
 #include "qs_assert.hh"
+#include <algorithm>
 
 //--------------------------------------------------------------
 //------------ParticleVaultContainer Constructor----------------
@@ -12,32 +13,36 @@
 
 ParticleVaultContainer::ParticleVaultContainer(uint64_t vault_size,
                                                uint64_t num_vaults,
-                                               uint64_t num_extra_vaults)
+                                               uint64_t num_extra_vaults,
+                                               ParticleVaultLayout::Enum layout,
+                                               uint64_t vaults_per_launch)
     : _vaultSize(vault_size), _numExtraVaults(num_extra_vaults),
-      _extraVaultIndex(0), _processingVault(num_vaults),
+      _vaultLayout(layout), _extraVaultIndex(0), _processingVault(num_vaults),
       _processedVault(num_vaults), _extraVault(num_extra_vaults, VAR_MEM) {
 
   // Allocate and reserve space for particles for each vault
   for (uint64_t vault = 0; vault < num_vaults; vault++) {
     // Allocate Processing Vault
     _processingVault[vault] =
-        MemoryControl::allocate<ParticleVault>(1, VAR_MEM);
-    _processingVault[vault]->reserve(vault_size);
+        MemoryControl::allocate<ParticleVault>(1, VAULT_MEM);
+    _processingVault[vault]->reserve(vault_size, _vaultLayout, VAULT_MEM);
 
     // Allocate Processed Vault
-    _processedVault[vault] = MemoryControl::allocate<ParticleVault>(1, VAR_MEM);
-    _processedVault[vault]->reserve(vault_size);
+    _processedVault[vault] =
+        MemoryControl::allocate<ParticleVault>(1, VAULT_MEM);
+    _processedVault[vault]->reserve(vault_size, _vaultLayout, VAULT_MEM);
   }
 
   // Allocate and reserve space for particles for each extra vault
   for (uint64_t e_vault = 0; e_vault < num_extra_vaults; e_vault++) {
     // Allocate Extra Vault
-    _extraVault[e_vault] = MemoryControl::allocate<ParticleVault>(1, VAR_MEM);
-    _extraVault[e_vault]->reserve(vault_size);
+    _extraVault[e_vault] =
+        MemoryControl::allocate<ParticleVault>(1, VAULT_MEM);
+    _extraVault[e_vault]->reserve(vault_size, _vaultLayout, VAULT_MEM);
   }
 
   _sendQueue = MemoryControl::allocate<SendQueue>(1, VAR_MEM);
-  _sendQueue->reserve(vault_size);
+  _sendQueue->reserve(vault_size * vaults_per_launch);
 }
 
 //--------------------------------------------------------------
@@ -47,13 +52,13 @@ ParticleVaultContainer::ParticleVaultContainer(uint64_t vault_size,
 
 ParticleVaultContainer::~ParticleVaultContainer() {
   for (int64_t ii = _processingVault.size() - 1; ii >= 0; ii--) {
-    MemoryControl::deallocate(_processingVault[ii], 1, VAR_MEM);
+    MemoryControl::deallocate(_processingVault[ii], 1, VAULT_MEM);
   }
   for (int64_t jj = _processedVault.size() - 1; jj >= 0; jj--) {
-    MemoryControl::deallocate(_processedVault[jj], 1, VAR_MEM);
+    MemoryControl::deallocate(_processedVault[jj], 1, VAULT_MEM);
   }
   for (int64_t ii = _extraVault.size() - 1; ii >= 0; ii--) {
-    MemoryControl::deallocate(_extraVault[ii], 1, VAR_MEM);
+    MemoryControl::deallocate(_extraVault[ii], 1, VAULT_MEM);
   }
   MemoryControl::deallocate(_sendQueue, 1, VAR_MEM);
 }
@@ -96,8 +101,9 @@ uint64_t ParticleVaultContainer::getFirstEmptyProcessedVault() {
   while (_processedVault[index]->size() != 0) {
     index++;
     if (index == _processedVault.size()) {
-      ParticleVault *vault = MemoryControl::allocate<ParticleVault>(1, VAR_MEM);
-      vault->reserve(_vaultSize);
+      ParticleVault *vault =
+          MemoryControl::allocate<ParticleVault>(1, VAULT_MEM);
+      vault->reserve(_vaultSize, _vaultLayout, VAULT_MEM);
       this->_processedVault.push_back(vault);
     }
   }
@@ -105,6 +111,26 @@ uint64_t ParticleVaultContainer::getFirstEmptyProcessedVault() {
   return index;
 }
 
+//--------------------------------------------------------------
+//------------getEmptyProcessedVaults---------------------------
+// Collapses the processed vaults, so that all vaults from the
+// first empty one on are empty, and makes sure there are count
+// of them
+//--------------------------------------------------------------
+
+uint64_t ParticleVaultContainer::getEmptyProcessedVaults(uint64_t count) {
+  this->collapseProcessed();
+  uint64_t index = getFirstEmptyProcessedVault();
+
+  while (_processedVault.size() < index + count) {
+    ParticleVault *vault = MemoryControl::allocate<ParticleVault>(1, VAULT_MEM);
+    vault->reserve(_vaultSize, _vaultLayout, VAULT_MEM);
+    this->_processedVault.push_back(vault);
+  }
+
+  return index;
+}
+
 //--------------------------------------------------------------
 //------------getSendQueue--------------------------------------
 // Returns a pointer to the Send Queue
@@ -183,6 +209,43 @@ void ParticleVaultContainer::collapseProcessing() {
   }
 }
 
+//--------------------------------------------------------------
+//------------setSizeProcessed----------------------------------
+// Sizes the processed vaults so that the first numParticles
+// flat indices (vault * vaultSize + index) are in use
+//--------------------------------------------------------------
+
+void ParticleVaultContainer::setSizeProcessed(uint64_t numParticles) {
+  uint64_t num_vaults =
+      (numParticles + this->_vaultSize - 1) / this->_vaultSize;
+
+  while (_processedVault.size() < num_vaults) {
+    ParticleVault *vault = MemoryControl::allocate<ParticleVault>(1, VAULT_MEM);
+    vault->reserve(this->_vaultSize, _vaultLayout, VAULT_MEM);
+    _processedVault.push_back(vault);
+  }
+
+  for (uint64_t vault = 0; vault < _processedVault.size(); vault++) {
+    uint64_t first = vault * this->_vaultSize;
+    uint64_t size = 0;
+    if (first < numParticles)
+      size = std::min(this->_vaultSize, numParticles - first);
+    _processedVault[vault]->setSize(size);
+  }
+}
+
+//--------------------------------------------------------------
+//------------replaceProcessingWithProcessed--------------------
+// Swaps the lists of processing and processed vaults and clears
+// the vaults that end up in the processed list
+//--------------------------------------------------------------
+
+void ParticleVaultContainer::replaceProcessingWithProcessed() {
+  std::swap(this->_processingVault, this->_processedVault);
+  for (uint64_t vault = 0; vault < _processedVault.size(); vault++)
+    _processedVault[vault]->clear();
+}
+
 //--------------------------------------------------------------
 //------------collapseProcessed---------------------------------
 // Collapses the particles in the processed vault down to the
@@ -241,8 +304,9 @@ void ParticleVaultContainer::swapProcessingProcessedVaults() {
     processed_vault++;
 
     if (processed_vault == this->_processingVault.size()) {
-      ParticleVault *vault = MemoryControl::allocate<ParticleVault>(1, VAR_MEM);
-      vault->reserve(_vaultSize);
+      ParticleVault *vault =
+          MemoryControl::allocate<ParticleVault>(1, VAULT_MEM);
+      vault->reserve(_vaultSize, _vaultLayout, VAULT_MEM);
       this->_processingVault.push_back(vault);
     }
 
@@ -265,8 +329,9 @@ void ParticleVaultContainer::addProcessingParticle(MC_Base_Particle &particle,
   while (!space) {
     fill_vault_index++;
     if (!(fill_vault_index < _processingVault.size())) {
-      ParticleVault *vault = MemoryControl::allocate<ParticleVault>(1, VAR_MEM);
-      vault->reserve(this->_vaultSize);
+      ParticleVault *vault =
+          MemoryControl::allocate<ParticleVault>(1, VAULT_MEM);
+      vault->reserve(this->_vaultSize, _vaultLayout, VAULT_MEM);
       _processingVault.push_back(vault);
     }
     space = (_processingVault[fill_vault_index]->size() < this->_vaultSize);
@@ -274,6 +339,28 @@ void ParticleVaultContainer::addProcessingParticle(MC_Base_Particle &particle,
   _processingVault[fill_vault_index]->pushBaseParticle(particle);
 }
 
+//--------------------------------------------------------------
+//------------addProcessedParticle------------------------------
+// Adds a particle to the processed particle vault, where the
+// particles of a restart wait for the next cycleInit
+//--------------------------------------------------------------
+
+void ParticleVaultContainer::addProcessedParticle(MC_Base_Particle &particle,
+                                                  uint64_t &fill_vault_index) {
+  bool space = (_processedVault[fill_vault_index]->size() < this->_vaultSize);
+  while (!space) {
+    fill_vault_index++;
+    if (!(fill_vault_index < _processedVault.size())) {
+      ParticleVault *vault =
+          MemoryControl::allocate<ParticleVault>(1, VAULT_MEM);
+      vault->reserve(this->_vaultSize, _vaultLayout, VAULT_MEM);
+      _processedVault.push_back(vault);
+    }
+    space = (_processedVault[fill_vault_index]->size() < this->_vaultSize);
+  }
+  _processedVault[fill_vault_index]->pushBaseParticle(particle);
+}
+
 //--------------------------------------------------------------
 //------------addExtraParticle----------------------------------
 // adds a particle to the extra particle vaults (used in kernel)
@@ -309,8 +396,8 @@ void ParticleVaultContainer::cleanExtraVaults() {
       } else {
         if (processing_index == this->_processingVault.size()) {
           ParticleVault *vault =
-              MemoryControl::allocate<ParticleVault>(1, VAR_MEM);
-          vault->reserve(_vaultSize);
+              MemoryControl::allocate<ParticleVault>(1, VAULT_MEM);
+          vault->reserve(_vaultSize, _vaultLayout, VAULT_MEM);
           this->_processingVault.push_back(vault);
         } else {
           if (this->_processingVault[processing_index]->size() ==
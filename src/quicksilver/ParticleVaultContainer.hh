@@ -3,6 +3,7 @@
 
 #include "DeclareMacro.hh"
 
+#include "ParticleVault.hh"
 #include "QS_Vector.hh"
 #include "portability.hh"
 #include <vector>
@@ -20,16 +21,22 @@
 
 class MC_Base_Particle;
 class MC_Particle;
-class ParticleVault;
 class SendQueue;
 
+// Vaults are long lived, so they come from the memory arena when one is
+// reserved.
+#define VAULT_MEM MemoryControl::AllocationPolicy::ARENA_MEM
+
 typedef unsigned long long int uint64_cu;
 
 class ParticleVaultContainer {
 public:
-  // Constructor
-  ParticleVaultContainer(uint64_t vault_size, uint64_t num_vaults,
-                         uint64_t num_extra_vaults);
+  // Constructor.  The send queue holds the particles leaving the
+  // domain from vaults_per_launch vaults.
+  ParticleVaultContainer(
+      uint64_t vault_size, uint64_t num_vaults, uint64_t num_extra_vaults,
+      ParticleVaultLayout::Enum layout = ParticleVaultLayout::AoS,
+      uint64_t vaults_per_launch = 1);
 
   // Destructor
   ~ParticleVaultContainer();
@@ -37,6 +44,7 @@ public:
   // Basic Getters
   uint64_t getVaultSize() { return _vaultSize; }
   uint64_t getNumExtraVaults() { return _numExtraVaults; }
+  ParticleVaultLayout::Enum getVaultLayout() { return _vaultLayout; }
 
   uint64_t processingSize() { return _processingVault.size(); }
   uint64_t processedSize() { return _processedVault.size(); }
@@ -49,6 +57,10 @@ public:
   // Returns the index to the first empty Processed Vault
   uint64_t getFirstEmptyProcessedVault();
 
+  // Returns the index of the first of count empty Processed Vaults
+  // in a row, adding vaults as needed
+  uint64_t getEmptyProcessedVaults(uint64_t count);
+
   // Returns a pointer to the Send Queue
   HOST_DEVICE
   SendQueue *getSendQueue();
@@ -65,6 +77,15 @@ public:
   void collapseProcessing();
   void collapseProcessed();
 
+  // Sizes the processed vaults to hold numParticles particles,
+  // filling the vaults in order and adding vaults as needed.  The
+  // particles are then put at their flat index by the caller.
+  void setSizeProcessed(uint64_t numParticles);
+
+  // Makes the processed vaults the processing vaults and empties
+  // the old processing vaults, which become the processed ones
+  void replaceProcessingWithProcessed();
+
   // Swaps the particles in Processed for the empty vaults in
   // Processing
   void swapProcessingProcessedVaults();
@@ -72,6 +93,9 @@ public:
   // Adds a particle to the processing particle vault
   void addProcessingParticle(MC_Base_Particle &particle,
                              uint64_t &fill_vault_index);
+  // Adds a particle to the processed particle vault (restart)
+  void addProcessedParticle(MC_Base_Particle &particle,
+                            uint64_t &fill_vault_index);
   // Adds a particle to the extra particle vault
   HOST_DEVICE
   void addExtraParticle(MC_Particle &particle);
@@ -90,6 +114,10 @@ private:
   //(fixed at runtime for each run)
   uint64_t _numExtraVaults;
 
+  // The memory layout of every ParticleVault in the container
+  //(fixed at runtime for each run)
+  ParticleVaultLayout::Enum _vaultLayout;
+
   // A running index for the number of particles int the extra
   // particle vaults
   uint64_cu _extraVaultIndex;
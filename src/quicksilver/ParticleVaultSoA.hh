@@ -0,0 +1,246 @@
+#ifndef PARTICLEVAULTSOA_HH
+#define PARTICLEVAULTSOA_HH
+
+#include "AtomicMacro.hh"
+#include "DeclareMacro.hh"
+#include "MC_Base_Particle.hh"
+#include "MemoryControl.hh"
+#include "qs_assert.hh"
+
+//---------------------------------------------------------------
+// ParticleVaultSoA holds the persistent state of a vault's
+// particles as a structure of arrays.  Every field of
+// MC_Base_Particle lives in its own contiguous array, so that
+// consecutive threads (or SIMD lanes) working on consecutive
+// particles read and write consecutive addresses.
+//
+// The arrays are carved out of three field-major slabs (one for
+// doubles, one for 64-bit integers and one for ints) that are
+// allocated with the same policy as the owning vault.
+//--------------------------------------------------------------
+
+class ParticleVaultSoA {
+public:
+  // Index of each double precision field in the real slab.
+  enum RealField {
+    CoordinateX = 0,
+    CoordinateY,
+    CoordinateZ,
+    VelocityX,
+    VelocityY,
+    VelocityZ,
+    KineticEnergy,
+    Weight,
+    TimeToCensus,
+    Age,
+    NumMeanFreePaths,
+    NumSegments,
+    NumRealFields
+  };
+
+  // Index of each 64-bit integer field in the uint64 slab.
+  enum Uint64Field { RandomNumberSeed = 0, Identifier, NumUint64Fields };
+
+  // Index of each int field in the int slab.
+  enum IntField {
+    LastEvent = 0,
+    NumCollisions,
+    Breed,
+    Species,
+    Domain,
+    Cell,
+    NumIntFields
+  };
+
+  ParticleVaultSoA()
+      : _real(0), _uint64(0), _int(0), _capacity(0), _size(0),
+        _memPolicy(MemoryControl::AllocationPolicy::HOST_MEM) {}
+
+  ~ParticleVaultSoA() {
+    MemoryControl::deallocate(_real, _capacity * NumRealFields, _memPolicy);
+    MemoryControl::deallocate(_uint64, _capacity * NumUint64Fields,
+                              _memPolicy);
+    MemoryControl::deallocate(_int, _capacity * NumIntFields, _memPolicy);
+  }
+
+  void reserve(int capacity, MemoryControl::AllocationPolicy memPolicy =
+                                 MemoryControl::AllocationPolicy::HOST_MEM) {
+    qs_assert(_capacity == 0);
+    _capacity = capacity;
+    _memPolicy = memPolicy;
+    _real = MemoryControl::allocate<double>(capacity * NumRealFields, memPolicy);
+    _uint64 = MemoryControl::allocate<uint64_t>(capacity * NumUint64Fields,
+                                                memPolicy);
+    _int = MemoryControl::allocate<int>(capacity * NumIntFields, memPolicy);
+  }
+
+  HOST_DEVICE_CUDA
+  int size() const { return _size; }
+
+  HOST_DEVICE_CUDA
+  int capacity() const { return _capacity; }
+
+  bool empty() const { return (_size == 0); }
+
+  void clear() { _size = 0; }
+
+  void pop_back() { _size--; }
+
+  // Set the number of particles, up to the capacity.
+  void setSize(int size) {
+    qs_assert(size <= _capacity);
+    _size = size;
+  }
+
+  // Atomically retrieve an available index then increment that index some
+  // amount
+  HOST_DEVICE_CUDA
+  int atomic_Index_Inc(int inc) {
+    int pos;
+
+    ATOMIC_CAPTURE(_size, inc, pos);
+
+    return pos;
+  }
+
+  // Pointers to the start of a single field array.
+  HOST_DEVICE_CUDA
+  double *real(RealField field) { return _real + field * _capacity; }
+  HOST_DEVICE_CUDA
+  uint64_t *uint64(Uint64Field field) { return _uint64 + field * _capacity; }
+  HOST_DEVICE_CUDA
+  int *integer(IntField field) { return _int + field * _capacity; }
+
+  HOST_DEVICE_CUDA
+  int &species(int index) { return _int[Species * _capacity + index]; }
+
+  // Gather the particle at index into a base particle.
+  HOST_DEVICE_CUDA
+  void load(int index, MC_Base_Particle &particle) const;
+
+  // Scatter a base particle into the arrays at index.
+  HOST_DEVICE_CUDA
+  void store(int index, const MC_Base_Particle &particle);
+
+  // Copy the particle at index from to index to.
+  void copy(int to, int from);
+
+  // Add all particles of a second SoA store to the end of this one.
+  void appendList(const ParticleVaultSoA &other);
+
+private:
+  // Disable copy constructor and assignment operator
+  ParticleVaultSoA(const ParticleVaultSoA &);
+  ParticleVaultSoA &operator=(const ParticleVaultSoA &);
+
+  double *_real;
+  uint64_t *_uint64;
+  int *_int;
+  int _capacity;
+  int _size;
+  MemoryControl::AllocationPolicy _memPolicy;
+};
+
+// -----------------------------------------------------------------------
+HOST_DEVICE_CUDA
+inline void ParticleVaultSoA::load(int index,
+                                   MC_Base_Particle &particle) const {
+  const double *real = _real + index;
+  const uint64_t *u64 = _uint64 + index;
+  const int *ints = _int + index;
+  const int stride = _capacity;
+
+  particle.coordinate.x = real[CoordinateX * stride];
+  particle.coordinate.y = real[CoordinateY * stride];
+  particle.coordinate.z = real[CoordinateZ * stride];
+  particle.velocity.x = real[VelocityX * stride];
+  particle.velocity.y = real[VelocityY * stride];
+  particle.velocity.z = real[VelocityZ * stride];
+  particle.kinetic_energy = real[KineticEnergy * stride];
+  particle.weight = real[Weight * stride];
+  particle.time_to_census = real[TimeToCensus * stride];
+  particle.age = real[Age * stride];
+  particle.num_mean_free_paths = real[NumMeanFreePaths * stride];
+  particle.num_segments = real[NumSegments * stride];
+
+  particle.random_number_seed = u64[RandomNumberSeed * stride];
+  particle.identifier = u64[Identifier * stride];
+
+  particle.last_event = (MC_Tally_Event::Enum)ints[LastEvent * stride];
+  particle.num_collisions = ints[NumCollisions * stride];
+  particle.breed = ints[Breed * stride];
+  particle.species = ints[Species * stride];
+  particle.domain = ints[Domain * stride];
+  particle.cell = ints[Cell * stride];
+}
+
+// -----------------------------------------------------------------------
+HOST_DEVICE_CUDA
+inline void ParticleVaultSoA::store(int index,
+                                    const MC_Base_Particle &particle) {
+  double *real = _real + index;
+  uint64_t *u64 = _uint64 + index;
+  int *ints = _int + index;
+  const int stride = _capacity;
+
+  real[CoordinateX * stride] = particle.coordinate.x;
+  real[CoordinateY * stride] = particle.coordinate.y;
+  real[CoordinateZ * stride] = particle.coordinate.z;
+  real[VelocityX * stride] = particle.velocity.x;
+  real[VelocityY * stride] = particle.velocity.y;
+  real[VelocityZ * stride] = particle.velocity.z;
+  real[KineticEnergy * stride] = particle.kinetic_energy;
+  real[Weight * stride] = particle.weight;
+  real[TimeToCensus * stride] = particle.time_to_census;
+  real[Age * stride] = particle.age;
+  real[NumMeanFreePaths * stride] = particle.num_mean_free_paths;
+  real[NumSegments * stride] = particle.num_segments;
+
+  u64[RandomNumberSeed * stride] = particle.random_number_seed;
+  u64[Identifier * stride] = particle.identifier;
+
+  ints[LastEvent * stride] = (int)particle.last_event;
+  ints[NumCollisions * stride] = particle.num_collisions;
+  ints[Breed * stride] = particle.breed;
+  ints[Species * stride] = particle.species;
+  ints[Domain * stride] = particle.domain;
+  ints[Cell * stride] = particle.cell;
+}
+
+// -----------------------------------------------------------------------
+inline void ParticleVaultSoA::copy(int to, int from) {
+  for (int field = 0; field < NumRealFields; field++)
+    _real[field * _capacity + to] = _real[field * _capacity + from];
+  for (int field = 0; field < NumUint64Fields; field++)
+    _uint64[field * _capacity + to] = _uint64[field * _capacity + from];
+  for (int field = 0; field < NumIntFields; field++)
+    _int[field * _capacity + to] = _int[field * _capacity + from];
+}
+
+// -----------------------------------------------------------------------
+inline void ParticleVaultSoA::appendList(const ParticleVaultSoA &other) {
+  qs_assert(_size + other._size < _capacity);
+
+  // Field by field so that each inner loop is a unit stride copy.
+  for (int field = 0; field < NumRealFields; field++) {
+    double *to = _real + field * _capacity + _size;
+    const double *from = other._real + field * other._capacity;
+    for (int ii = 0; ii < other._size; ii++)
+      to[ii] = from[ii];
+  }
+  for (int field = 0; field < NumUint64Fields; field++) {
+    uint64_t *to = _uint64 + field * _capacity + _size;
+    const uint64_t *from = other._uint64 + field * other._capacity;
+    for (int ii = 0; ii < other._size; ii++)
+      to[ii] = from[ii];
+  }
+  for (int field = 0; field < NumIntFields; field++) {
+    int *to = _int + field * _capacity + _size;
+    const int *from = other._int + field * other._capacity;
+    for (int ii = 0; ii < other._size; ii++)
+      to[ii] = from[ii];
+  }
+  _size += other._size;
+}
+
+#endif
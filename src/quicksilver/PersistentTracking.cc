@@ -0,0 +1,129 @@
+#include "PersistentTracking.hh"
+#include "CycleTracking.hh"
+#include "MonteCarlo.hh"
+#include "ParticleVault.hh"
+#include "cudaFunctions.hh"
+#include "macros.hh"
+#include "qs_assert.hh"
+#include <algorithm>
+
+namespace {
+// Workgroup size of the persistent kernel, and the number of workgroups
+// started per multiprocessor.
+const int persistentThreadsPerBlock = 128;
+const int persistentBlocksPerSM = 4;
+} // namespace
+
+// -----------------------------------------------------------------------
+void TrackingWorkQueue::reserve(int maxVaults) {
+  _processingVault.resize(maxVaults, VAR_MEM);
+  _processedVault.resize(maxVaults, VAR_MEM);
+  _firstChunk.resize(maxVaults + 1, 0, VAR_MEM);
+}
+
+// -----------------------------------------------------------------------
+void TrackingWorkQueue::addVault(ParticleVault *processingVault,
+                                 ParticleVault *processedVault) {
+  qs_assert(_numVaults < _processingVault.size());
+  _processingVault[_numVaults] = processingVault;
+  _processedVault[_numVaults] = processedVault;
+  _numVaults++;
+}
+
+// -----------------------------------------------------------------------
+void TrackingWorkQueue::start(int chunkSize) {
+  _chunkSize = std::max(chunkSize, 1);
+  _firstChunk[0] = 0;
+  for (int vault = 0; vault < _numVaults; vault++) {
+    int numParticles = _processingVault[vault]->size();
+    _firstChunk[vault + 1] =
+        _firstChunk[vault] + (numParticles + _chunkSize - 1) / _chunkSize;
+  }
+  _numChunks = _firstChunk[_numVaults];
+  _nextChunk = 0;
+}
+
+// -----------------------------------------------------------------------
+HOST_DEVICE_CUDA
+void TrackingWorkQueue::trackChunk(MonteCarlo *monteCarlo, int chunk,
+                                   int first, int stride) {
+  // A batch has a few vaults, a linear search is fine.
+  int vault = 0;
+  while (_firstChunk[vault + 1] <= chunk)
+    vault++;
+
+  ParticleVault *processingVault = _processingVault[vault];
+  int begin = (chunk - _firstChunk[vault]) * _chunkSize;
+  int end = begin + _chunkSize;
+  if (end > (int)processingVault->size())
+    end = processingVault->size();
+
+  for (int particle_index = begin + first; particle_index < end;
+       particle_index += stride)
+    CycleTrackingGuts(monteCarlo, particle_index, processingVault,
+                      _processedVault[vault], vault);
+}
+
+#if defined(HAVE_CUDA)
+// Every workgroup claims chunks of blockDim.x particles, one per thread,
+// until the queue is drained.
+__global__ void PersistentTrackingKernel(MonteCarlo *monteCarlo,
+                                         TrackingWorkQueue *queue) {
+  __shared__ int chunk;
+
+  while (true) {
+    if (threadIdx.x == 0)
+      chunk = queue->pop();
+    __syncthreads();
+    int myChunk = chunk;
+    __syncthreads();
+
+    if (myChunk >= queue->numChunks())
+      return;
+    queue->trackChunk(monteCarlo, myChunk, threadIdx.x, blockDim.x);
+  }
+}
+#endif
+
+// -----------------------------------------------------------------------
+void PersistentTracking(MonteCarlo *monteCarlo, ExecutionPolicy execPolicy,
+                        TrackingWorkQueue *queue) {
+  switch (execPolicy) {
+  case gpuWithCUDA: {
+#if defined(HAVE_CUDA)
+    queue->start(persistentThreadsPerBlock);
+    if (queue->numChunks() == 0)
+      break;
+
+    int device = 0;
+    int numSM = 1;
+    cudaGetDevice(&device);
+    cudaDeviceGetAttribute(&numSM, cudaDevAttrMultiProcessorCount, device);
+    int numBlocks = std::min(numSM * persistentBlocksPerSM, queue->numChunks());
+
+    PersistentTrackingKernel<<<numBlocks, persistentThreadsPerBlock>>>(
+        monteCarlo, queue);
+
+    // The host sends the particles of the batch next.
+    cudaPeekAtLastError();
+    cudaDeviceSynchronize();
+#endif
+  } break;
+
+  case cpu: {
+    queue->start(monteCarlo->_params.simulationParams.trackingChunkSize);
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel
+#endif
+    {
+      int chunk;
+      while ((chunk = queue->pop()) < queue->numChunks())
+        queue->trackChunk(monteCarlo, chunk, 0, 1);
+    }
+  } break;
+
+  default:
+    qs_assert(false);
+  }
+}
@@ -0,0 +1,90 @@
+#ifndef PERSISTENT_TRACKING_HH
+#define PERSISTENT_TRACKING_HH
+
+#include "AtomicMacro.hh"
+#include "DeclareMacro.hh"
+#include "QS_Vector.hh"
+#include "cudaUtils.hh"
+
+class MonteCarlo;
+class ParticleVault;
+
+typedef unsigned long long int uint64_cu;
+
+//---------------------------------------------------------------
+// Persistent tracking kernel.
+//
+// The default history-based tracking launches one kernel per
+// processing vault and synchronizes after each, so with small
+// vaults the GPU sits idle between many short launches.  With
+// trackingKernel = 1, one launch tracks a batch of up to
+// persistentVaults processing vaults: only as many workgroups
+// as the device keeps resident are started, and each of them
+// pulls chunks of particles from the atomic counter of a
+// TrackingWorkQueue in managed memory until the batch is done.
+//
+// Secondaries still go to the extra vaults and particles that
+// leave the domain to the send queue, which records the vault of
+// the batch they came from.  Both are sized for a whole batch, so
+// the host only takes over between batches, to send and receive
+// particles and to move the secondaries into processing vaults.
+//
+// On the CPU the OpenMP threads stand in for the workgroups and
+// pull chunks of trackingChunkSize particles.
+//--------------------------------------------------------------
+
+struct TrackingKernel {
+  enum Enum { PerVault = 0, Persistent = 1 };
+};
+
+class TrackingWorkQueue {
+public:
+  TrackingWorkQueue()
+      : _numVaults(0), _chunkSize(1), _numChunks(0), _nextChunk(0) {}
+
+  // Allocates room for batches of up to maxVaults vaults.
+  void reserve(int maxVaults);
+
+  // Empties the batch.
+  void clear() { _numVaults = 0; }
+
+  // Adds a processing vault to the batch, with the empty processed vault
+  // its census particles go to.
+  void addVault(ParticleVault *processingVault, ParticleVault *processedVault);
+
+  // Splits the particles of the batch into chunks of chunkSize particles
+  // (no chunk spans two vaults) and rewinds the queue.
+  void start(int chunkSize);
+
+  // Claims the next chunk.  The queue is drained once this returns
+  // numChunks() or more.
+  HOST_DEVICE_CUDA
+  int pop() {
+    uint64_cu chunk;
+    ATOMIC_CAPTURE(_nextChunk, 1, chunk);
+    return (int)chunk;
+  }
+
+  HOST_DEVICE_CUDA
+  int numChunks() const { return _numChunks; }
+
+  // Tracks the particles first, first + stride, ... of a chunk.
+  HOST_DEVICE_CUDA
+  void trackChunk(MonteCarlo *monteCarlo, int chunk, int first, int stride);
+
+private:
+  qs_vector<ParticleVault *> _processingVault; // [vault]
+  qs_vector<ParticleVault *> _processedVault;  // [vault]
+  qs_vector<int> _firstChunk;                  // [vault + 1]
+  int _numVaults;
+  int _chunkSize;
+  int _numChunks;
+  uint64_cu _nextChunk;
+};
+
+// Tracks all particles of the batch of the queue, with the persistent kernel
+// on the GPU or with the OpenMP threads on the CPU.
+void PersistentTracking(MonteCarlo *monteCarlo, ExecutionPolicy execPolicy,
+                        TrackingWorkQueue *queue);
+
+#endif
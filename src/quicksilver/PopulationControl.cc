@@ -6,6 +6,7 @@
 #include "NVTX_Range.hh"
 #include "ParticleVault.hh"
 #include "ParticleVaultContainer.hh"
+#include "macros.hh"
 #include "utilsMpi.hh"
 #include <vector>
 
@@ -14,8 +15,175 @@ void PopulationControlGuts(const double splitRRFactor,
                            uint64_t currentNumParticles,
                            ParticleVaultContainer *my_particle_vault,
                            Balance &taskBalance);
+
+// Scratch space of the parallel population control, kept from cycle to
+// cycle like that of the vault sort.
+thread_local std::vector<uint64_t> offsetScratch;
+
+// Exclusive prefix sum of value[0, n) in place, in parallel with one
+// contiguous block per thread.  Returns the total.
+uint64_t exclusiveScan(uint64_t *value, uint64_t n) {
+  std::vector<uint64_t> blockStart(omp_get_max_threads() + 1, 0);
+  int numThreads = 1;
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel
+#endif
+  {
+    // The blocks are split over the threads the region actually got, which
+    // can be fewer than asked for with dynamic threads or nesting.
+#ifdef HAVE_OPENMP
+#pragma omp single
+#endif
+    numThreads = omp_get_num_threads();
+
+    const int thread = omp_get_thread_num();
+    const uint64_t begin = n * thread / numThreads;
+    const uint64_t end = n * (thread + 1) / numThreads;
+
+    uint64_t sum = 0;
+    for (uint64_t ii = begin; ii < end; ii++)
+      sum += value[ii];
+    blockStart[thread + 1] = sum;
+
+#ifdef HAVE_OPENMP
+#pragma omp barrier
+#pragma omp single
+#endif
+    for (int tt = 0; tt < numThreads; tt++)
+      blockStart[tt + 1] += blockStart[tt];
+
+    sum = blockStart[thread];
+    for (uint64_t ii = begin; ii < end; ii++) {
+      uint64_t num = value[ii];
+      value[ii] = sum;
+      sum += num;
+    }
+  }
+
+  return blockStart[numThreads];
+}
+
+// Rebuilds the processing vaults in parallel.  decide(particle) may change
+// the particle and returns the number of copies to keep: 0 kills the
+// particle, 1 keeps it and more splits it, with the seeds of the extra
+// copies spawned from the seed of the particle.  It only depends on the
+// particle, so it is called once to count the copies and again, on the
+// same particle, to make them.  The survivors are written to the (empty)
+// processed vaults in particle order, each followed by its copies, at the
+// offsets given by a prefix sum of the copy counts, and the two lists of
+// vaults are then swapped.  The vaults come out the same for any number
+// of threads.
+template <typename Decide>
+void rebuildProcessingVaults(ParticleVaultContainer &container,
+                             Balance &taskBalance, const Decide &decide) {
+  const uint64_t vaultSize = container.getVaultSize();
+  const uint64_t numVaults = container.processingSize();
+
+  std::vector<uint64_t> vaultStart(numVaults + 1, 0);
+  for (uint64_t vault = 0; vault < numVaults; vault++)
+    vaultStart[vault + 1] =
+        vaultStart[vault] + container.getTaskProcessingVault(vault)->size();
+  const uint64_t numParticles = vaultStart[numVaults];
+  if (numParticles == 0)
+    return;
+
+  if (offsetScratch.size() < numParticles + 1)
+    offsetScratch.resize(numParticles + 1);
+  uint64_t *offset = &offsetScratch[0];
+
+  uint64_t numKilled = 0;
+  uint64_t numSplit = 0;
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static) reduction(+ : numKilled, numSplit)
+#endif
+  for (int64_t vault = 0; vault < (int64_t)numVaults; vault++) {
+    const ParticleVault &processingVault =
+        *container.getTaskProcessingVault(vault);
+    for (uint64_t ii = vaultStart[vault]; ii < vaultStart[vault + 1]; ii++) {
+      MC_Base_Particle particle;
+      processingVault.getBaseParticle(particle, ii - vaultStart[vault]);
+      int copies = decide(particle);
+      offset[ii] = copies;
+      if (copies == 0)
+        numKilled++;
+      else
+        numSplit += copies - 1;
+    }
+  }
+  taskBalance._rr += numKilled;
+  taskBalance._split += numSplit;
+
+  offset[numParticles] = exclusiveScan(offset, numParticles);
+  container.setSizeProcessed(offset[numParticles]);
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for (int64_t vault = 0; vault < (int64_t)numVaults; vault++) {
+    const ParticleVault &processingVault =
+        *container.getTaskProcessingVault(vault);
+    for (uint64_t ii = vaultStart[vault]; ii < vaultStart[vault + 1]; ii++) {
+      if (offset[ii] == offset[ii + 1])
+        continue;
+
+      MC_Base_Particle parent;
+      processingVault.getBaseParticle(parent, ii - vaultStart[vault]);
+      decide(parent);
+      for (uint64_t dest = offset[ii] + 1; dest < offset[ii + 1]; dest++) {
+        MC_Base_Particle child = parent;
+        child.random_number_seed =
+            rngSpawn_Random_Number_Seed(&parent.random_number_seed);
+        child.identifier = child.random_number_seed;
+        container.getTaskProcessedVault(dest / vaultSize)
+            ->putBaseParticle(child, dest % vaultSize);
+      }
+      container.getTaskProcessedVault(offset[ii] / vaultSize)
+          ->putBaseParticle(parent, offset[ii] % vaultSize);
+    }
+  }
+
+  container.replaceProcessingWithProcessed();
 }
 
+// The population control decision of PopulationControlGuts.
+struct SplitRoulette {
+  double splitRRFactor;
+
+  int operator()(MC_Base_Particle &particle) const {
+    double randomNumber = rngSample(&particle.random_number_seed);
+    if (splitRRFactor < 1) {
+      if (randomNumber > splitRRFactor)
+        return 0;
+      particle.weight /= splitRRFactor;
+      return 1;
+    }
+
+    int splitFactor = (int)floor(splitRRFactor);
+    if (randomNumber > (splitRRFactor - splitFactor))
+      splitFactor--;
+    particle.weight /= splitRRFactor;
+    return 1 + splitFactor;
+  }
+};
+
+// The low weight roulette decision of RouletteLowWeightParticles.
+struct LowWeightRoulette {
+  double lowWeightCutoff;
+  double weightCutoff;
+
+  int operator()(MC_Base_Particle &particle) const {
+    if (particle.weight > weightCutoff)
+      return 1;
+    double randomNumber = rngSample(&particle.random_number_seed);
+    if (randomNumber > lowWeightCutoff)
+      return 0;
+    particle.weight /= lowWeightCutoff;
+    return 1;
+  }
+};
+} // namespace
+
 void PopulationControl(MonteCarlo *monteCarlo, bool loadBalance) {
   NVTX_Range range("PopulationControl");
 
@@ -57,8 +225,16 @@ void PopulationControl(MonteCarlo *monteCarlo, bool loadBalance) {
 
   if (splitRRFactor !=
       1.0) // no need to split if population is already correct.
-    PopulationControlGuts(splitRRFactor, localNumParticles,
-                          monteCarlo->_particleVaultContainer, taskBalance);
+  {
+    if (monteCarlo->_params.simulationParams.parallelPopulationControl) {
+      SplitRoulette decide = {splitRRFactor};
+      rebuildProcessingVaults(*monteCarlo->_particleVaultContainer,
+                              taskBalance, decide);
+    } else {
+      PopulationControlGuts(splitRRFactor, localNumParticles,
+                            monteCarlo->_particleVaultContainer, taskBalance);
+    }
+  }
 
   monteCarlo->_particleVaultContainer->collapseProcessing();
 
@@ -84,7 +260,8 @@ void PopulationControlGuts(const double splitRRFactor,
 
     uint64_t taskParticleIndex = particleIndex % vault_size;
 
-    MC_Base_Particle &currentParticle = taskProcessingVault[taskParticleIndex];
+    MC_Base_Particle currentParticle;
+    taskProcessingVault.getBaseParticle(currentParticle, taskParticleIndex);
     double randomNumber = rngSample(&currentParticle.random_number_seed);
     if (splitRRFactor < 1) {
       if (randomNumber > splitRRFactor) {
@@ -116,6 +293,10 @@ void PopulationControlGuts(const double splitRRFactor,
                                                  fill_vault_index);
       }
     }
+
+    // Write back the advanced seed and new weight of a surviving particle.
+    if (!(splitRRFactor < 1 && randomNumber > splitRRFactor))
+      taskProcessingVault.putBaseParticle(currentParticle, taskParticleIndex);
   }
 }
 } // anonymous namespace
@@ -140,6 +321,13 @@ void RouletteLowWeightParticles(MonteCarlo *monteCarlo) {
     const double source_particle_weight = monteCarlo->source_particle_weight;
     const double weightCutoff = lowWeightCutoff * source_particle_weight;
 
+    if (monteCarlo->_params.simulationParams.parallelPopulationControl) {
+      LowWeightRoulette decide = {lowWeightCutoff, weightCutoff};
+      rebuildProcessingVaults(*monteCarlo->_particleVaultContainer,
+                              taskBalance, decide);
+      return;
+    }
+
     for (int64_t particleIndex = currentNumParticles - 1; particleIndex >= 0;
          particleIndex--) {
       uint64_t vault_index = particleIndex / vault_size;
@@ -148,14 +336,16 @@ void RouletteLowWeightParticles(MonteCarlo *monteCarlo) {
           *(monteCarlo->_particleVaultContainer->getTaskProcessingVault(
               vault_index));
       uint64_t taskParticleIndex = particleIndex % vault_size;
-      MC_Base_Particle &currentParticle =
-          taskProcessingVault[taskParticleIndex];
+      MC_Base_Particle currentParticle;
+      taskProcessingVault.getBaseParticle(currentParticle, taskParticleIndex);
 
       if (currentParticle.weight <= weightCutoff) {
         double randomNumber = rngSample(&currentParticle.random_number_seed);
         if (randomNumber <= lowWeightCutoff) {
           // The particle history continues with an increased weight.
           currentParticle.weight /= lowWeightCutoff;
+          taskProcessingVault.putBaseParticle(currentParticle,
+                                              taskParticleIndex);
         } else {
           // Kill
           taskProcessingVault.eraseSwapParticle(taskParticleIndex);
@@ -3,6 +3,13 @@
 
 class MonteCarlo;
 
+// Both split and roulette the particles of the processing vaults serially,
+// or in parallel when parallelPopulationControl is set.  The parallel
+// version keeps the surviving particles in order with each split copy
+// right after its parent, so its vaults do not depend on the number of
+// threads; they differ from the serial order, which swaps killed particles
+// with the last one and appends the split copies.
+
 void PopulationControl(MonteCarlo *monteCarlo, bool loadBalance);
 
 void RouletteLowWeightParticles(MonteCarlo *monteCarlo);
@@ -0,0 +1,62 @@
+#ifndef SPSC_QUEUE_HH
+#define SPSC_QUEUE_HH
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+//---------------------------------------------------------------
+// Bounded lock-free queue for exactly one producer thread and one
+// consumer thread.  The capacity is rounded up to a power of two.
+// push and pop never block; they return false when the queue is
+// full or empty.
+//
+// _head is only written by the consumer and _tail only by the
+// producer, each on its own cache line.  The release store of one
+// index and the acquire load of it on the other side order the
+// copies of the items.
+//--------------------------------------------------------------
+
+template <class T> class SPSCQueue {
+public:
+  explicit SPSCQueue(size_t capacity) : _head(0), _tail(0) {
+    size_t size = 1;
+    while (size < capacity)
+      size *= 2;
+    _item.resize(size);
+    _mask = size - 1;
+  }
+
+  // Producer only.
+  bool push(const T &item) {
+    size_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail - _head.load(std::memory_order_acquire) > _mask)
+      return false;
+    _item[tail & _mask] = item;
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer only.
+  bool pop(T &item) {
+    size_t head = _head.load(std::memory_order_relaxed);
+    if (head == _tail.load(std::memory_order_acquire))
+      return false;
+    item = _item[head & _mask];
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t capacity() const { return _mask + 1; }
+
+private:
+  SPSCQueue(const SPSCQueue &);
+  SPSCQueue &operator=(const SPSCQueue &);
+
+  std::vector<T> _item;
+  size_t _mask;
+  alignas(64) std::atomic<size_t> _head; // next item to pop
+  alignas(64) std::atomic<size_t> _tail; // next slot to push
+};
+
+#endif
@@ -0,0 +1,259 @@
+#include "ScalingBenchmark.hh"
+#include "Parameters.hh"
+#include "macros.hh"
+#include "qs_assert.hh"
+#include "utils.hh"
+#include "utilsMpi.hh"
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <sys/resource.h>
+#include <vector>
+
+namespace {
+// Parses a comma separated list of integers such as "1,2,4".
+std::vector<uint64_t> parseList(const std::string &list) {
+  std::vector<uint64_t> values;
+  size_t begin = 0;
+  while (begin < list.size()) {
+    size_t end = list.find(',', begin);
+    if (end == std::string::npos)
+      end = list.size();
+    if (end > begin)
+      values.push_back(
+          strtoull(list.substr(begin, end - begin).c_str(), NULL, 10));
+    begin = end + 1;
+  }
+  return values;
+}
+
+// Grows the mesh by factor, with cells of the same size.  Every prime
+// factor multiplies the axis with the fewest cells, so that the mesh stays
+// close to a cube.
+void growMesh(SimulationParameters &sp, uint64_t factor) {
+  for (uint64_t prime = 2; factor > 1; prime++) {
+    while (factor % prime == 0) {
+      factor /= prime;
+      int *nn = &sp.nx;
+      double *ll = &sp.lx;
+      if (sp.ny < *nn) {
+        nn = &sp.ny;
+        ll = &sp.ly;
+      }
+      if (sp.nz < *nn) {
+        nn = &sp.nz;
+        ll = &sp.lz;
+      }
+      *nn *= prime;
+      *ll *= prime;
+    }
+  }
+}
+
+// Resets the peak resident memory of the process (Linux 4.0 and later).
+void resetPeakMemory() {
+  FILE *file = fopen("/proc/self/clear_refs", "w");
+  if (file == NULL)
+    return;
+  fputs("5", file);
+  fclose(file);
+}
+
+// Peak resident memory of the process in MiB.
+double peakMemoryMB() {
+  FILE *file = fopen("/proc/self/status", "r");
+  if (file != NULL) {
+    char line[256];
+    unsigned long kB;
+    while (fgets(line, sizeof(line), file) != NULL) {
+      if (sscanf(line, "VmHWM: %lu kB", &kB) == 1) {
+        fclose(file);
+        return kB / 1024.0;
+      }
+    }
+    fclose(file);
+  }
+
+  // kB on Linux.
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss / 1024.0;
+}
+
+// Opens the CSV file for appending and writes the header row if the file
+// is new.
+FILE *openCsv(const std::string &fileName) {
+  FILE *file = fopen(fileName.c_str(), "a");
+  if (file == NULL) {
+    fprintf(stderr, "Unable to open scaling file %s\n", fileName.c_str());
+    return NULL;
+  }
+  fseek(file, 0, SEEK_END);
+  if (ftell(file) == 0) {
+    fprintf(file, "label,problem,mode,ranks,threads,batch_size,vault_size,"
+                  "particles,cells,cycles,segments,segments_per_sec,"
+                  "efficiency,peak_rss_mb,init_s");
+    for (int timer_index = 0; timer_index < MC_Fast_Timer::Num_Timers;
+         timer_index++)
+      fprintf(file, ",%s_us_avg,%s_us_max", mc_fast_timer_names[timer_index],
+              mc_fast_timer_names[timer_index]);
+    fprintf(file, "\n");
+  }
+  return file;
+}
+} // namespace
+
+// -----------------------------------------------------------------------
+void coralProblem(Parameters &params, int problem) {
+  // Only the homogeneous problem 1 so far, after Coral2_P1.inp.
+  qs_assert(problem == 1);
+  SimulationParameters &sp = params.simulationParams;
+
+  // The CORAL2 runs use cells of 1 cm, which balance the facet crossings
+  // with the collisions.
+  sp.lx = sp.nx;
+  sp.ly = sp.ny;
+  sp.lz = sp.nz;
+
+  params.geometryParams.clear();
+  params.materialParams.clear();
+  params.crossSectionParams.clear();
+
+  CrossSectionParameters flatCrossSection;
+  flatCrossSection.name = "flat";
+  flatCrossSection.nuBar = 1.6;
+  params.crossSectionParams[flatCrossSection.name] = flatCrossSection;
+
+  MaterialParameters sourceMaterial;
+  sourceMaterial.name = "sourceMaterial";
+  sourceMaterial.nIsotopes = 20;
+  sourceMaterial.nReactions = 9;
+  sourceMaterial.sourceRate = 1e10;
+  sourceMaterial.totalCrossSection = 1.5;
+  sourceMaterial.scatteringCrossSection = "flat";
+  sourceMaterial.absorptionCrossSection = "flat";
+  sourceMaterial.fissionCrossSection = "flat";
+  sourceMaterial.scatteringCrossSectionRatio = 1.0;
+  sourceMaterial.absorptionCrossSectionRatio = 0.04;
+  sourceMaterial.fissionCrossSectionRatio = 0.05;
+  params.materialParams[sourceMaterial.name] = sourceMaterial;
+
+  GeometryParameters sourceGeometry;
+  sourceGeometry.materialName = sourceMaterial.name;
+  sourceGeometry.shape = GeometryParameters::BRICK;
+  sourceGeometry.xMax = sp.lx;
+  sourceGeometry.yMax = sp.ly;
+  sourceGeometry.zMax = sp.lz;
+  params.geometryParams.push_back(sourceGeometry);
+
+  // Checks the reaction ratios above after each run.
+  sp.coralBenchmark = problem;
+}
+
+// -----------------------------------------------------------------------
+void scalingBenchmark(Parameters params) {
+  SimulationParameters &sp = params.simulationParams;
+  const SimulationParameters base = sp;
+  const int numTimers = MC_Fast_Timer::Num_Timers;
+
+  int rank = 0;
+  int numRanks = 1;
+  mpiComm_rank(MPI_COMM_WORLD, &rank);
+  mpiComm_size(MPI_COMM_WORLD, &numRanks);
+
+  std::vector<uint64_t> threadList = parseList(base.scalingThreads);
+  if (threadList.empty())
+    threadList.push_back(omp_get_max_threads());
+  std::vector<uint64_t> batchList = parseList(base.scalingBatchSizes);
+  if (batchList.empty())
+    batchList.push_back(base.batchSize);
+
+  const std::string label =
+      base.scalingLabel.empty() ? __DATE__ " " __TIME__ : base.scalingLabel;
+  const std::string fileName =
+      base.scalingCsv.empty() ? "scaling.csv" : base.scalingCsv;
+  const char *modeName = (base.scalingMode == 1) ? "weak" : "strong";
+
+  FILE *csv = (rank == 0) ? openCsv(fileName) : NULL;
+
+  Print0("\nScaling benchmark: %s scaling, %d ranks, appending to %s\n",
+         modeName, numRanks, fileName.c_str());
+  Print0("\n%8s %10s %10s %12s %10s %14s %10s %12s %12s\n", "threads",
+         "batchSize", "vaultSize", "particles", "cells", "segments/sec",
+         "efficiency", "peakRSS(MB)", "tracking(s)");
+
+  for (size_t bb = 0; bb < batchList.size(); bb++) {
+    // segments/sec per worker of the first thread count.
+    double referenceRate = 0.0;
+
+    for (size_t tt = 0; tt < threadList.size(); tt++) {
+      const int numThreads = (int)threadList[tt];
+#ifdef HAVE_OPENMP
+      omp_set_num_threads(numThreads);
+#else
+      if (numThreads != 1) {
+        Print0("%8d skipped, built without OpenMP\n", numThreads);
+        continue;
+      }
+#endif
+      const uint64_t numWorkers = (uint64_t)numRanks * numThreads;
+
+      sp = base;
+      sp.batchSize = batchList[bb];
+      // With the problem of the input the geometry does not follow the
+      // mesh, so only the particles grow.
+      if (base.scalingMode == 1) {
+        sp.nParticles *= numWorkers;
+        if (base.scalingProblem != 0)
+          growMesh(sp, numWorkers);
+      }
+      if (base.scalingProblem != 0)
+        coralProblem(params, base.scalingProblem);
+
+      resetPeakMemory();
+      ScalingSample sample;
+      runScalingSample(params, sample);
+
+      double local[2] = {peakMemoryMB(), sample.initSeconds};
+      double maxLocal[2];
+      mpiAllreduce(local, maxLocal, 2, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+      uint64_t sumClock[numTimers];
+      uint64_t maxClock[numTimers];
+      mpiAllreduce(sample.timerClock, sumClock, numTimers, MPI_UINT64_T,
+                   MPI_SUM, MPI_COMM_WORLD);
+      mpiAllreduce(sample.timerClock, maxClock, numTimers, MPI_UINT64_T,
+                   MPI_MAX, MPI_COMM_WORLD);
+
+      double rate = sample.segmentsPerSec / numWorkers;
+      if (referenceRate == 0.0)
+        referenceRate = rate;
+      double efficiency = rate / referenceRate;
+      uint64_t numCells = (uint64_t)sp.nx * sp.ny * sp.nz;
+
+      Print0("%8d %10" PRIu64 " %10" PRIu64 " %12" PRIu64 " %10" PRIu64
+             " %14.3e %10.3f %12.1f %12.3f\n",
+             numThreads, sp.batchSize, sample.vaultSize, sp.nParticles,
+             numCells, sample.segmentsPerSec, efficiency, maxLocal[0],
+             maxClock[MC_Fast_Timer::cycleTracking] * 1e-6);
+
+      if (csv == NULL)
+        continue;
+      fprintf(csv,
+              "\"%s\",%d,%s,%d,%d,%" PRIu64 ",%" PRIu64 ",%" PRIu64
+              ",%" PRIu64 ",%d,%" PRIu64 ",%.6e,%.4f,%.1f,%.4f",
+              label.c_str(), base.scalingProblem, modeName, numRanks,
+              numThreads, sp.batchSize, sample.vaultSize, sp.nParticles,
+              numCells, sp.nSteps, sample.numSegments, sample.segmentsPerSec,
+              efficiency, maxLocal[0], maxLocal[1]);
+      for (int timer_index = 0; timer_index < numTimers; timer_index++)
+        fprintf(csv, ",%" PRIu64 ",%" PRIu64, sumClock[timer_index] / numRanks,
+                maxClock[timer_index]);
+      fprintf(csv, "\n");
+      fflush(csv);
+    }
+  }
+
+  if (csv != NULL)
+    fclose(csv);
+}
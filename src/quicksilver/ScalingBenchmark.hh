@@ -0,0 +1,59 @@
+#ifndef SCALING_BENCHMARK_HH
+#define SCALING_BENCHMARK_HH
+
+#include "MC_Fast_Timer.hh"
+#include "portability.hh"
+
+struct Parameters;
+
+//---------------------------------------------------------------
+// Strong and weak scaling benchmark.  The QuicksilverScaling
+// target (main.cc built with QS_SCALING_BENCHMARK) runs it
+// instead of the problem.
+//
+// The problem is run once for every combination of the OpenMP
+// thread counts in scalingThreads and the vault sizes (batchSize)
+// in scalingBatchSizes, both comma separated lists.  With
+// scalingProblem = 1 the problem is CORAL2 problem 1, a
+// homogeneous brick of one material with flat cross sections,
+// generated on a mesh of nx * ny * nz cells of 1 cm like the
+// CORAL2 runs.  A strong scaling sweep (scalingMode = 0) runs
+// nParticles particles on that mesh every time.  A weak scaling
+// sweep (scalingMode = 1) multiplies the particles and the cells
+// by the number of workers (ranks * threads), so that the work
+// per worker is fixed.
+// With scalingProblem = 0 the problem of the input is run as it
+// is, and a weak scaling sweep only grows the particles.
+//
+// Every run appends a row to the CSV file scalingCsv (default
+// scaling.csv): the label of the build (scalingLabel, default
+// the build date), ranks, threads, vault size, problem size,
+// segments/sec, the parallel efficiency against the first thread
+// count of the sweep, the peak resident memory of the largest
+// rank, and the cumulative time of every MC_Fast_Timer (average
+// and maximum over the ranks).  Sweeps with other builds or rank
+// counts append to the same file, so that regressions show up.
+// The peak memory is reset before every run on Linux; elsewhere
+// it is the peak of the process so far.
+//--------------------------------------------------------------
+
+struct ScalingSample {
+  uint64_t numSegments;
+  double segmentsPerSec; // figure of merit
+  uint64_t vaultSize;
+  double initSeconds;                               // initMC of this rank
+  uint64_t timerClock[MC_Fast_Timer::Num_Timers]; // this rank, microseconds
+};
+
+// Replaces the geometries, materials and cross sections of params by those
+// of CORAL2 problem 1 (the only one so far), on the mesh of params with
+// cells of 1 cm.
+void coralProblem(Parameters &params, int problem);
+
+void scalingBenchmark(Parameters params);
+
+// Runs the problem once and fills in sample.  Defined in main.cc, next to
+// the other benchmark drivers.
+void runScalingSample(Parameters &params, ScalingSample &sample);
+
+#endif
@@ -20,11 +20,12 @@ size_t SendQueue::neighbor_size(int neighbor_) {
 
 // -----------------------------------------------------------------------
 HOST_DEVICE
-void SendQueue::push(int neighbor_, int vault_index_) {
+void SendQueue::push(int neighbor_, int vault_index_, int vault_) {
   size_t indx = _data.atomic_Index_Inc(1);
 
   _data[indx]._neighbor = neighbor_;
   _data[indx]._particleIndex = vault_index_;
+  _data[indx]._vault = vault_;
 }
 HOST_DEVICE_END
 
@@ -9,6 +9,8 @@
 struct sendQueueTuple {
   int _neighbor;
   int _particleIndex;
+  int _vault; // processing vault in the batch of a persistent tracking
+              // launch (0 otherwise)
 };
 
 class SendQueue {
@@ -28,7 +30,7 @@ public:
 
   // Add items to the send queue in a kernel
   HOST_DEVICE_CUDA
-  void push(int neighbor_, int vault_index_);
+  void push(int neighbor_, int vault_index_, int vault_ = 0);
 
   // Clear send queue before after use
   void clear();
@@ -21,12 +21,59 @@ void Tallies::SumTasks(void) {
   }
 }
 
+// Sum the flux and cell tally replications of a domain into replication 0
+// with a pairwise tree: at each level replication ii absorbs replication
+// ii + stride and is then zeroed.  The order of the additions depends only on
+// the number of replications and not on the thread schedule, so the reduced
+// tallies are bit-reproducible from run to run.  Cells are independent and
+// reduced in parallel.
+void Tallies::ReduceReplications(int domainIndex) {
+  qs_vector<ScalarFluxTask> &fluxTask = _scalarFluxDomain[domainIndex]._task;
+  int numCells = fluxTask[0]._cell.size();
+  int numGroups = (numCells > 0) ? fluxTask[0]._cell[0].size() : 0;
+
+#include "mc_omp_parallel_for_schedule_static.hh"
+  for (int cellIndex = 0; cellIndex < numCells; cellIndex++) {
+    for (int stride = 1; stride < _num_flux_replications; stride *= 2) {
+      for (int ii = 0; ii + stride < _num_flux_replications;
+           ii += 2 * stride) {
+        double *sum = fluxTask[ii]._cell[cellIndex]._group;
+        double *value = fluxTask[ii + stride]._cell[cellIndex]._group;
+        for (int groupIndex = 0; groupIndex < numGroups; groupIndex++) {
+          sum[groupIndex] += value[groupIndex];
+          value[groupIndex] = 0.0;
+        }
+      }
+    }
+  }
+
+  qs_vector<CellTallyTask> &cellTask = _cellTallyDomain[domainIndex]._task;
+  numCells = cellTask[0]._cell.size();
+
+#include "mc_omp_parallel_for_schedule_static.hh"
+  for (int cellIndex = 0; cellIndex < numCells; cellIndex++) {
+    for (int stride = 1; stride < _num_cellTally_replications; stride *= 2) {
+      for (int ii = 0; ii + stride < _num_cellTally_replications;
+           ii += 2 * stride) {
+        cellTask[ii]._cell[cellIndex] += cellTask[ii + stride]._cell[cellIndex];
+        cellTask[ii + stride]._cell[cellIndex] = 0.0;
+      }
+    }
+  }
+}
+
 void Tallies::CycleFinalize(MonteCarlo *monteCarlo) {
+  MC_FASTTIMER_START(MC_Fast_Timer::cycleFinalize_Tallies);
+
   SumTasks(); // sum the task level data down to index 0 at the end of each
               // cycle
 
+  for (int domainIndex = 0; domainIndex < _scalarFluxDomain.size();
+       domainIndex++)
+    ReduceReplications(domainIndex);
+
   vector<uint64_t> tal;
-  tal.reserve(13);
+  tal.reserve(15);
   tal.push_back(_balanceTask[0]._absorb);
   tal.push_back(_balanceTask[0]._census);
   tal.push_back(_balanceTask[0]._escape);
@@ -40,6 +87,8 @@ void Tallies::CycleFinalize(MonteCarlo *monteCarlo) {
   tal.push_back(_balanceTask[0]._rr);
   tal.push_back(_balanceTask[0]._split);
   tal.push_back(_balanceTask[0]._numSegments);
+  tal.push_back(_balanceTask[0]._facetCrossing);
+  tal.push_back(_balanceTask[0]._xsCacheMiss);
   vector<uint64_t> sum(tal.size());
 
   mpiAllreduce(&tal[0], &sum[0], tal.size(), MPI_UINT64_T, MPI_SUM,
@@ -59,10 +108,15 @@ void Tallies::CycleFinalize(MonteCarlo *monteCarlo) {
   _balanceTask[0]._rr = sum[index++];
   _balanceTask[0]._split = sum[index++];
   _balanceTask[0]._numSegments = sum[index++];
+  _balanceTask[0]._facetCrossing = sum[index++];
+  _balanceTask[0]._xsCacheMiss = sum[index++];
+
+  MC_FASTTIMER_STOP(MC_Fast_Timer::cycleFinalize_Tallies);
 
   PrintSummary(monteCarlo);
 
   _balanceCumulative.Add(_balanceTask[0]);
+  _balanceLastCycle = _balanceTask[0];
 
   uint64_t newStart = _balanceTask[0]._end;
 
@@ -73,22 +127,6 @@ void Tallies::CycleFinalize(MonteCarlo *monteCarlo) {
 
   for (int domainIndex = 0; domainIndex < _scalarFluxDomain.size();
        domainIndex++) {
-    // Sum Cell Tally Replications
-    for (int replication_index = 1; replication_index < _num_flux_replications;
-         replication_index++) {
-      _cellTallyDomain[domainIndex]._task[0].Add(
-          _cellTallyDomain[domainIndex]._task[replication_index]);
-      _cellTallyDomain[domainIndex]._task[replication_index].Reset();
-    }
-
-    // Sum Scalar Flux Tally Replications
-    for (int replication_index = 1; replication_index < _num_flux_replications;
-         replication_index++) {
-      _scalarFluxDomain[domainIndex]._task[0].Add(
-          _scalarFluxDomain[domainIndex]._task[replication_index]);
-      _scalarFluxDomain[domainIndex]._task[replication_index].Reset();
-    }
-
     if (monteCarlo->_params.simulationParams.coralBenchmark)
       _fluence.compute(domainIndex, _scalarFluxDomain[domainIndex]);
 
@@ -122,20 +160,25 @@ void Tallies::PrintSummary(MonteCarlo *monteCarlo) {
   MC_FASTTIMER_STOP(
       MC_Fast_Timer::cycleFinalize); // stop the finalize timer to get report
 
-  if (monteCarlo->time_info->cycle == 0) {
+  if (monteCarlo->time_info->cycle == monteCarlo->time_info->start_cycle) {
     Print0("%-8s ", "cycle");
     _balanceTask[0].PrintHeader();
-    Print0("%14s %14s %14s %14s\n", "scalar_flux", "cycleInit", "cycleTracking",
-           "cycleFinalize");
+    Print0("%14s %14s %14s %14s %12s %12s\n", "scalar_flux", "cycleInit",
+           "cycleTracking", "cycleFinalize", "xs_hits", "xs_misses");
   }
 
   Print0("%8i ", monteCarlo->time_info->cycle);
   _balanceTask[0].Print();
   double sum = ScalarFluxSum(monteCarlo);
-  Print0("%14e %14e %14e %14e\n", sum,
+  _scalarFluxLastCycle = sum;
+  // Every segment looks up the total cross section of its cell once.
+  uint64_t xsMisses = _balanceTask[0]._xsCacheMiss;
+  uint64_t xsHits = _balanceTask[0]._numSegments - xsMisses;
+  Print0("%14e %14e %14e %14e %12" PRIu64 " %12" PRIu64 "\n", sum,
          MC_FASTTIMER_GET_LASTCYCLE(MC_Fast_Timer::cycleInit),
          MC_FASTTIMER_GET_LASTCYCLE(MC_Fast_Timer::cycleTracking),
-         MC_FASTTIMER_GET_LASTCYCLE(MC_Fast_Timer::cycleFinalize));
+         MC_FASTTIMER_GET_LASTCYCLE(MC_Fast_Timer::cycleFinalize), xsHits,
+         xsMisses);
 
   MC_FASTTIMER_START(
       MC_Fast_Timer::cycleFinalize); // restart the finalize timer
@@ -176,13 +219,37 @@ double Tallies::ScalarFluxSum(MonteCarlo *monteCarlo) {
 void Tallies::InitializeTallies(MonteCarlo *monteCarlo,
                                 int balance_replications = 1,
                                 int flux_replications = 1,
-                                int cell_replications = 1) {
+                                int cell_replications = 1,
+                                int tally_mode = 0) {
 
   // Set num replications from input parameters
   _num_balance_replications = balance_replications;
   _num_flux_replications = flux_replications;
   _num_cellTally_replications = cell_replications;
 
+  // Thread-private flux and cell tallies need one replication per host
+  // thread, so they are only used when tracking on the CPU.
+  _threadPrivate = false;
+  if (tally_mode == 1) {
+    if (monteCarlo->processor_info->use_gpu) {
+      Print0("Thread-private tallies are not supported on the GPU, using "
+             "shared tallies\n");
+    } else {
+      _threadPrivate = true;
+      _num_flux_replications = omp_get_max_threads();
+      _num_cellTally_replications = omp_get_max_threads();
+
+      // A particle scores into the replication of the thread that tracks
+      // it.  Work stealing changes that from run to run, and with it the
+      // tallies, so the static loop is used instead.
+      if (monteCarlo->_params.simulationParams.trackingScheduler == 1) {
+        Print0("Thread-private tallies need the static tracking schedule, "
+               "disabling work stealing\n");
+        monteCarlo->_params.simulationParams.trackingScheduler = 0;
+      }
+    }
+  }
+
   // Initialize the balance tally replications
   if (_balanceTask.size() == 0) {
     if (_balanceTask.capacity() == 0) {
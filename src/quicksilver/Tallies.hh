@@ -17,6 +17,11 @@
 
 typedef unsigned long long int uint64_cu;
 
+// Number of doubles left unused after each flux and cell tally replication
+// so that replications written by different threads never share a cache
+// line.
+#define TALLY_PADDING (64 / sizeof(double))
+
 class Fluence;
 
 struct MC_Tally_Event {
@@ -46,11 +51,13 @@ public:
   uint64_cu _rr; // Number of particles Russian Rouletted in population control
   uint64_cu _split;       // Number of particles split in population control
   uint64_cu _numSegments; // Number of segements
+  uint64_cu _facetCrossing; // Number of facet crossings
+  uint64_cu _xsCacheMiss;   // Number of cell cross section cache misses
 
   Balance()
       : _absorb(0), _census(0), _escape(0), _collision(0), _end(0), _fission(0),
         _produce(0), _scatter(0), _start(0), _source(0), _rr(0), _split(0),
-        _numSegments(0) {}
+        _numSegments(0), _facetCrossing(0), _xsCacheMiss(0) {}
 
   ~Balance() {}
 
@@ -70,7 +77,8 @@ public:
 
   void Reset() {
     _absorb = _census = _escape = _collision = _end = _fission = _produce =
-        _scatter = _start = _source = _rr = _split = _numSegments = 0;
+        _scatter = _start = _source = _rr = _split = _numSegments =
+            _facetCrossing = _xsCacheMiss = 0;
   }
 
   void Add(Balance &bal) {
@@ -87,6 +95,8 @@ public:
     _rr += bal._rr;
     _split += bal._split;
     _numSegments += bal._numSegments;
+    _facetCrossing += bal._facetCrossing;
+    _xsCacheMiss += bal._xsCacheMiss;
   }
 };
 
@@ -116,7 +126,8 @@ public:
 
   CellTallyTask(MC_Domain *domain) {
     if (_cell.capacity() == 0) {
-      _cell.reserve(domain->cell_state.size(), VAR_MEM);
+      _cell.reserve(domain->cell_state.size() + TALLY_PADDING,
+                    MemoryControl::AllocationPolicy::ARENA_MEM);
     }
 
     _cell.Open();
@@ -152,8 +163,9 @@ public:
   ScalarFluxTask(MC_Domain *domain, int numGroups) {
     if (_cell.capacity() == 0) {
       _cell.reserve(domain->cell_state.size(), VAR_MEM);
-      _scalarFluxCellStorage.setCapacity(domain->cell_state.size() * numGroups,
-                                         VAR_MEM);
+      _scalarFluxCellStorage.setCapacity(
+          domain->cell_state.size() * numGroups + TALLY_PADDING,
+          MemoryControl::AllocationPolicy::ARENA_MEM);
     }
 
     _cell.Open();
@@ -260,6 +272,8 @@ public:
 class Tallies {
 public:
   Balance _balanceCumulative;
+  Balance _balanceLastCycle; // summed over all ranks
+  double _scalarFluxLastCycle; // summed over all ranks
   qs_vector<Balance> _balanceTask;
   qs_vector<ScalarFluxDomain> _scalarFluxDomain;
   qs_vector<CellTallyDomain> _cellTallyDomain;
@@ -268,10 +282,11 @@ public:
 
   Tallies(int balRep, int fluxRep, int cellRep, std::string spectrumName,
           int spectrumSize)
-      : _balanceCumulative(), _balanceTask(), _scalarFluxDomain(),
+      : _balanceCumulative(), _balanceLastCycle(), _scalarFluxLastCycle(0.0),
+        _balanceTask(), _scalarFluxDomain(),
+        _spectrum(spectrumName, spectrumSize),
         _num_balance_replications(balRep), _num_flux_replications(fluxRep),
-        _num_cellTally_replications(cellRep),
-        _spectrum(spectrumName, spectrumSize) {}
+        _num_cellTally_replications(cellRep), _threadPrivate(false) {}
 
   HOST_DEVICE_CUDA
   int GetNumBalanceReplications() { return _num_balance_replications; }
@@ -282,27 +297,60 @@ public:
   HOST_DEVICE_CUDA
   int GetNumCellTallyReplications() { return _num_cellTally_replications; }
 
+  // The flux and cell tally replication a particle scores into.  With
+  // thread-private tallies every OpenMP thread owns one replication,
+  // otherwise particles are spread over the shared replications by index.
+  HOST_DEVICE_CUDA
+  int GetFluxTallyIndex(int particle_index) {
+#ifndef __CUDA_ARCH__
+    if (_threadPrivate)
+      return omp_get_thread_num();
+#endif
+    return particle_index % _num_flux_replications;
+  }
+
+  HOST_DEVICE_CUDA
+  int GetCellTallyIndex(int particle_index) {
+#ifndef __CUDA_ARCH__
+    if (_threadPrivate)
+      return omp_get_thread_num();
+#endif
+    return particle_index % _num_cellTally_replications;
+  }
+
   ~Tallies() {}
 
   void InitializeTallies(MonteCarlo *monteCarlo, int balance_replications,
-                         int flux_replications, int cell_replications);
+                         int flux_replications, int cell_replications,
+                         int tally_mode);
 
   void CycleInitialize(MonteCarlo *monteCarlo);
 
   void SumTasks();
+  void ReduceReplications(int domainIndex);
   void CycleFinalize(MonteCarlo *mcco);
   void PrintSummary(MonteCarlo *mcco);
 
   HOST_DEVICE_CUDA
   void TallyScalarFlux(double value, int domain, int task, int cell,
                        int group) {
-    ATOMIC_ADD(_scalarFluxDomain[domain]._task[task]._cell[cell]._group[group],
-               value);
+    double &flux =
+        _scalarFluxDomain[domain]._task[task]._cell[cell]._group[group];
+    if (_threadPrivate) {
+      flux += value;
+    } else {
+      ATOMIC_ADD(flux, value);
+    }
   }
 
   HOST_DEVICE_CUDA
   void TallyCellValue(double value, int domain, int task, int cell) {
-    ATOMIC_ADD(_cellTallyDomain[domain]._task[task]._cell[cell], value);
+    double &tally = _cellTallyDomain[domain]._task[task]._cell[cell];
+    if (_threadPrivate) {
+      tally += value;
+    } else {
+      ATOMIC_ADD(tally, value);
+    }
   }
 
   double ScalarFluxSum(MonteCarlo *mcco);
@@ -311,6 +359,7 @@ private:
   int _num_balance_replications;
   int _num_flux_replications;
   int _num_cellTally_replications;
+  bool _threadPrivate; //!< one flux and cell replication per thread
 };
 
 #endif
@@ -0,0 +1,168 @@
+#include "ThreadRanks.hh"
+#include "macros.hh"
+#include "qs_assert.hh"
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <map>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+struct Message {
+  int source;
+  int tag;
+  std::vector<char> data;
+};
+
+struct Mailbox {
+  std::mutex mutex;
+  std::list<Message> messages;
+};
+
+struct ThreadRanksState {
+  int size;
+
+  // Barrier
+  std::mutex barrierMutex;
+  std::condition_variable barrierDone;
+  int arrived;
+  uint64_t generation;
+
+  // One slot per rank for exchangePointers
+  std::vector<const void *> slot;
+
+  std::vector<Mailbox> mailbox;
+
+  std::mutex queueMutex;
+  std::map<std::pair<int, int>, ParticleQueue *> queue;
+
+  ThreadRanksState()
+      : size(1), arrived(0), generation(0), slot(1), mailbox(1) {}
+};
+
+ThreadRanksState state;
+thread_local int threadRank = 0;
+} // namespace
+
+// -----------------------------------------------------------------------
+void ThreadRanks::run(int numRanks, const std::function<void()> &body) {
+  qs_assert(state.size == 1);
+
+  state.size = numRanks;
+  state.arrived = 0;
+  state.slot.assign(numRanks, (const void *)NULL);
+  std::vector<Mailbox>(numRanks).swap(state.mailbox);
+
+  std::vector<std::thread> thread;
+  for (int rank = 0; rank < numRanks; rank++) {
+    thread.push_back(std::thread([rank, &body]() {
+      threadRank = rank;
+      // The globals of a rank (mcco, the memory arena) are thread
+      // local, so all of its work has to stay on its own thread.
+#ifdef HAVE_OPENMP
+      omp_set_num_threads(1);
+#endif
+      body();
+    }));
+  }
+  for (int rank = 0; rank < numRanks; rank++)
+    thread[rank].join();
+
+  for (std::map<std::pair<int, int>, ParticleQueue *>::iterator it =
+           state.queue.begin();
+       it != state.queue.end(); ++it) {
+    it->second->~ParticleQueue();
+    free(it->second);
+  }
+  state.queue.clear();
+
+  state.size = 1;
+  state.slot.assign(1, (const void *)NULL);
+  std::vector<Mailbox>(1).swap(state.mailbox);
+}
+
+// -----------------------------------------------------------------------
+int ThreadRanks::rank() { return threadRank; }
+
+// -----------------------------------------------------------------------
+int ThreadRanks::size() { return state.size; }
+
+// -----------------------------------------------------------------------
+void ThreadRanks::barrier() {
+  if (state.size == 1)
+    return;
+
+  std::unique_lock<std::mutex> lock(state.barrierMutex);
+  uint64_t generation = state.generation;
+  if (++state.arrived == state.size) {
+    state.arrived = 0;
+    state.generation++;
+    state.barrierDone.notify_all();
+  } else {
+    while (state.generation == generation)
+      state.barrierDone.wait(lock);
+  }
+}
+
+// -----------------------------------------------------------------------
+const void *const *ThreadRanks::exchangePointers(const void *mine) {
+  state.slot[threadRank] = mine;
+  barrier();
+  return &state.slot[0];
+}
+
+// -----------------------------------------------------------------------
+void ThreadRanks::send(int dest, int tag, const void *buf, size_t bytes) {
+  qs_assert(dest >= 0 && dest < state.size);
+
+  std::vector<char> data(bytes);
+  if (bytes > 0)
+    memcpy(&data[0], buf, bytes);
+
+  Mailbox &mailbox = state.mailbox[dest];
+  std::lock_guard<std::mutex> lock(mailbox.mutex);
+  mailbox.messages.push_back(Message());
+  Message &message = mailbox.messages.back();
+  message.source = threadRank;
+  message.tag = tag;
+  message.data.swap(data);
+}
+
+// -----------------------------------------------------------------------
+bool ThreadRanks::tryReceive(int source, int tag, void *buf, size_t bytes) {
+  Mailbox &mailbox = state.mailbox[threadRank];
+  std::lock_guard<std::mutex> lock(mailbox.mutex);
+  for (std::list<Message>::iterator it = mailbox.messages.begin();
+       it != mailbox.messages.end(); ++it) {
+    if ((source < 0 || it->source == source) && it->tag == tag) {
+      qs_assert(it->data.size() <= bytes);
+      if (!it->data.empty())
+        memcpy(buf, &it->data[0], it->data.size());
+      mailbox.messages.erase(it);
+      return true;
+    }
+  }
+  return false;
+}
+
+// -----------------------------------------------------------------------
+ParticleQueue *ThreadRanks::particleQueue(int src, int dst, size_t capacity) {
+  std::lock_guard<std::mutex> lock(state.queueMutex);
+  ParticleQueue *&queue = state.queue[std::make_pair(src, dst)];
+  if (queue == NULL) {
+    // new does not honor the cache line alignment of the queue indices
+    // before C++17.
+    const size_t alignment = alignof(ParticleQueue);
+    void *ptr = NULL;
+    if (posix_memalign(&ptr, alignment, sizeof(ParticleQueue)) != 0)
+      ptr = NULL;
+    qs_assert(ptr != NULL);
+    queue = new (ptr) ParticleQueue(capacity);
+  }
+  return queue;
+}
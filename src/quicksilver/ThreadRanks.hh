@@ -0,0 +1,59 @@
+#ifndef THREAD_RANKS_HH
+#define THREAD_RANKS_HH
+
+#include "MC_Base_Particle.hh"
+#include "SPSCQueue.hh"
+#include <cstddef>
+#include <functional>
+
+typedef SPSCQueue<MC_Base_Particle> ParticleQueue;
+
+//---------------------------------------------------------------
+// ThreadRanks runs several ranks, each with its own domain and its
+// own MonteCarlo object, as threads of one process.  It is the
+// communication backend of the serial (non-MPI) build:
+//
+// * the mpi* wrappers in utilsMpi.cc implement barriers,
+//   reductions, gathers, broadcasts and point-to-point messages
+//   between the rank threads on top of this class, so the mesh
+//   setup, the tallies, the timers and the test for done run
+//   unchanged;
+//
+// * particles that cross into another domain do not go through
+//   the serialized MC_Particle_Buffer byte streams.  Every pair of
+//   neighbor ranks shares a lock-free single-producer /
+//   single-consumer queue of MC_Base_Particle instead.
+//
+// Outside of run() there is a single rank.
+//--------------------------------------------------------------
+
+class ThreadRanks {
+public:
+  // Runs body on numRanks threads, one per rank, and returns when
+  // all of them are done.  Each rank runs one OpenMP thread.
+  static void run(int numRanks, const std::function<void()> &body);
+
+  static int rank();
+  static int size();
+  static bool active() { return size() > 1; }
+
+  static void barrier();
+
+  // Publishes this rank's buffer and returns the buffers of all
+  // ranks, indexed by rank.  Every rank must call barrier() once it
+  // is done reading them.
+  static const void *const *exchangePointers(const void *mine);
+
+  // Buffered point-to-point messages.  send copies the data, so it
+  // completes immediately.  tryReceive copies the oldest message
+  // with a matching tag from source (any source if source < 0) and
+  // returns false if there is none yet.
+  static void send(int dest, int tag, const void *buf, size_t bytes);
+  static bool tryReceive(int source, int tag, void *buf, size_t bytes);
+
+  // The queue of particles going from rank src to rank dst.  It is
+  // created with the given capacity by the first caller.
+  static ParticleQueue *particleQueue(int src, int dst, size_t capacity);
+};
+
+#endif
@@ -0,0 +1,211 @@
+#include "VaultSort.hh"
+#include "MC_Base_Particle.hh"
+#include "MC_Domain.hh"
+#include "MonteCarlo.hh"
+#include "NVTX_Range.hh"
+#include "Parameters.hh"
+#include "ParticleVault.hh"
+#include "ParticleVaultContainer.hh"
+#include "macros.hh"
+#include "qs_assert.hh"
+#include <algorithm>
+#include <vector>
+
+namespace {
+// Bits of the key sorted per radix sort pass.
+const int radixBits = 8;
+const int numBuckets = 1 << radixBits;
+
+// Bits per axis of the Morton code.  1024 bins per axis is finer than
+// the meshes we run, so the code orders the particles within a cell too.
+const int mortonBits = 10;
+
+// Spreads the low 10 bits of x out to every third bit.
+uint64_t spreadBits(uint64_t x) {
+  x &= 0x3FF;
+  x = (x | (x << 16)) & 0x030000FF;
+  x = (x | (x << 8)) & 0x0300F00F;
+  x = (x | (x << 4)) & 0x030C30C3;
+  x = (x | (x << 2)) & 0x09249249;
+  return x;
+}
+
+// The Morton bin of coordinate x in a problem of length length.
+uint64_t mortonBin(double x, double length) {
+  double bin = x / length * (1 << mortonBits);
+  // Also catches NaN.
+  if (!(bin > 0.0))
+    return 0;
+  if (bin >= (1 << mortonBits) - 1)
+    return (1 << mortonBits) - 1;
+  return (uint64_t)bin;
+}
+
+// Scratch space of the sort, kept from cycle to cycle so that it is
+// allocated and first touched only when the population grows.  Every rank
+// thread of ThreadRanks has its own.
+struct SortScratch {
+  std::vector<MC_Base_Particle> particle;
+  std::vector<uint64_t> key;
+  std::vector<uint32_t> index;
+};
+
+thread_local SortScratch scratch;
+
+// Number of bits needed to hold the values [0, maxValue].
+int bitsFor(uint64_t maxValue) {
+  int bits = 0;
+  while (bits < 64 && (maxValue >> bits) != 0)
+    bits++;
+  return bits;
+}
+} // namespace
+
+// -----------------------------------------------------------------------
+void radixSortPairs(uint64_t *key, uint32_t *value, size_t n, int keyBits,
+                    uint64_t *keyTmp, uint32_t *valueTmp) {
+  uint64_t *const keyOut = key;
+  uint32_t *const valueOut = value;
+  std::vector<size_t> count(omp_get_max_threads() * numBuckets);
+
+  for (int shift = 0; shift < keyBits; shift += radixBits) {
+    bool skipPass = false;
+    int numThreads = 1;
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel
+#endif
+    {
+      // The blocks are split over the threads the region actually got,
+      // which can be fewer than asked for with dynamic threads or nesting.
+#ifdef HAVE_OPENMP
+#pragma omp single
+#endif
+      numThreads = omp_get_num_threads();
+
+      // Each thread histograms and later scatters its own contiguous
+      // block, which keeps the sort stable.
+      const int thread = omp_get_thread_num();
+      const size_t begin = n * thread / numThreads;
+      const size_t end = n * (thread + 1) / numThreads;
+      size_t *myCount = &count[thread * numBuckets];
+
+      std::fill(myCount, myCount + numBuckets, 0);
+      for (size_t ii = begin; ii < end; ii++)
+        myCount[(key[ii] >> shift) & (numBuckets - 1)]++;
+
+#ifdef HAVE_OPENMP
+#pragma omp barrier
+#pragma omp single
+#endif
+      {
+        // Turn the counts into the first output index of every (bucket,
+        // thread), bucket major.  A pass where all keys share the digit
+        // would not move anything.
+        size_t offset = 0;
+        for (int bucket = 0; bucket < numBuckets; bucket++) {
+          size_t bucketStart = offset;
+          for (int tt = 0; tt < numThreads; tt++) {
+            size_t num = count[tt * numBuckets + bucket];
+            count[tt * numBuckets + bucket] = offset;
+            offset += num;
+          }
+          if (offset - bucketStart == n)
+            skipPass = true;
+        }
+      }
+
+      if (!skipPass) {
+        for (size_t ii = begin; ii < end; ii++) {
+          size_t dest = myCount[(key[ii] >> shift) & (numBuckets - 1)]++;
+          keyTmp[dest] = key[ii];
+          valueTmp[dest] = value[ii];
+        }
+      }
+    }
+
+    if (!skipPass) {
+      std::swap(key, keyTmp);
+      std::swap(value, valueTmp);
+    }
+  }
+
+  // An odd number of passes leaves the result in the scratch arrays.
+  if (key != keyOut) {
+    std::copy(key, key + n, keyOut);
+    std::copy(value, value + n, valueOut);
+  }
+}
+
+// -----------------------------------------------------------------------
+void SortProcessingVaults(MonteCarlo *monteCarlo, int order) {
+  if (order == VaultSortOrder::None)
+    return;
+
+  NVTX_Range range("SortProcessingVaults");
+
+  ParticleVaultContainer &container = *monteCarlo->_particleVaultContainer;
+  const uint64_t numVaults = container.processingSize();
+
+  // Where the particles of every vault go in the flat arrays below.
+  std::vector<uint64_t> vaultStart(numVaults + 1, 0);
+  for (uint64_t vault = 0; vault < numVaults; vault++)
+    vaultStart[vault + 1] =
+        vaultStart[vault] + container.getTaskProcessingVault(vault)->size();
+  const uint64_t numParticles = vaultStart[numVaults];
+  if (numParticles < 2)
+    return;
+  qs_assert(numParticles <= UINT32_MAX);
+
+  // The cells of all domains of this rank, numbered domain by domain.
+  std::vector<uint64_t> firstCell(monteCarlo->domain.size() + 1, 0);
+  for (int domain = 0; domain < monteCarlo->domain.size(); domain++)
+    firstCell[domain + 1] =
+        firstCell[domain] + monteCarlo->domain[domain].cell_state.size();
+
+  const SimulationParameters &params = monteCarlo->_params.simulationParams;
+  const int keyBits = (order == VaultSortOrder::Morton)
+                          ? 3 * mortonBits
+                          : bitsFor(firstCell.back());
+
+  if (scratch.particle.size() < numParticles) {
+    scratch.particle.resize(numParticles);
+    scratch.key.resize(2 * numParticles);
+    scratch.index.resize(2 * numParticles);
+  }
+  MC_Base_Particle *particle = &scratch.particle[0];
+  uint64_t *key = &scratch.key[0];
+  uint32_t *index = &scratch.index[0];
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for (int64_t vault = 0; vault < (int64_t)numVaults; vault++) {
+    const ParticleVault &processingVault =
+        *container.getTaskProcessingVault(vault);
+    for (uint64_t ii = vaultStart[vault]; ii < vaultStart[vault + 1]; ii++) {
+      MC_Base_Particle &base = particle[ii];
+      processingVault.getBaseParticle(base, ii - vaultStart[vault]);
+      if (order == VaultSortOrder::Morton)
+        key[ii] = spreadBits(mortonBin(base.coordinate.x, params.lx)) |
+                  spreadBits(mortonBin(base.coordinate.y, params.ly)) << 1 |
+                  spreadBits(mortonBin(base.coordinate.z, params.lz)) << 2;
+      else
+        key[ii] = firstCell[base.domain] + base.cell;
+      index[ii] = ii;
+    }
+  }
+
+  radixSortPairs(key, index, numParticles, keyBits, key + numParticles,
+                 index + numParticles);
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for (int64_t vault = 0; vault < (int64_t)numVaults; vault++) {
+    ParticleVault &processingVault = *container.getTaskProcessingVault(vault);
+    for (uint64_t ii = vaultStart[vault]; ii < vaultStart[vault + 1]; ii++)
+      processingVault.putBaseParticle(particle[index[ii]],
+                                      ii - vaultStart[vault]);
+  }
+}
@@ -0,0 +1,43 @@
+#ifndef VAULT_SORT_HH
+#define VAULT_SORT_HH
+
+#include <cstddef>
+#include <cstdint>
+
+class MonteCarlo;
+
+//---------------------------------------------------------------
+// Sorting the processing vaults between cycles.
+//
+// The particles of a vault are tracked in vault order, and after
+// a few cycles of splitting, rouletting and sending that order
+// has nothing to do with where the particles are.  Sorting them
+// by cell (domain, then cell) or by the Morton code of their
+// position makes neighbouring particles of a vault touch the same
+// cell state, facet planes and tally entries, which helps the
+// caches of the tracking kernel and the coalescing of its memory
+// accesses on a GPU.
+//
+// The sort is a stable LSD radix sort, run in parallel with one
+// histogram per OpenMP thread.  It is stable and every particle
+// carries its own random number seed, so the particles and their
+// histories do not depend on the order.  The sort is timed by
+// the cycleInit_VaultSort timer, the vaultSortBenchmark compares
+// that time with what it saves in cycleTracking.
+//--------------------------------------------------------------
+
+struct VaultSortOrder {
+  enum Enum { None = 0, Cell = 1, Morton = 2 };
+};
+
+// Reorders the particles of the processing vaults of this rank.  The
+// number of particles in every vault is unchanged.
+void SortProcessingVaults(MonteCarlo *monteCarlo, int order);
+
+// Stable sort of the n (key, value) pairs by the low keyBits bits of the
+// keys.  key and value are the input and the result, keyTmp and valueTmp
+// hold n elements of scratch space.
+void radixSortPairs(uint64_t *key, uint32_t *value, size_t n, int keyBits,
+                    uint64_t *keyTmp, uint32_t *valueTmp);
+
+#endif
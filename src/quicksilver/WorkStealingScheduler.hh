@@ -0,0 +1,213 @@
+#ifndef WORK_STEALING_SCHEDULER_HH
+#define WORK_STEALING_SCHEDULER_HH
+
+#include "macros.hh"
+#include "portability.hh"
+#include "qs_assert.hh"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+//---------------------------------------------------------------
+// WorkStealingScheduler runs a loop over [0, numItems) on all
+// OpenMP threads.  The items are split into chunks and every
+// thread starts with an equal, contiguous range of chunks.  A
+// thread takes chunks from the front of its own range and, once
+// that is empty, steals single chunks from the back of the range
+// of the thread with the most chunks left.  Particle histories
+// vary a lot in cost, so this keeps all threads busy until the
+// last chunk is done instead of idling after their static share.
+// Thread-private tallies (tallyMode 1) are indexed by thread, so
+// they turn work stealing off and keep the static loop.
+//
+// A range is a (head, tail) pair of chunk indices packed into one
+// 64 bit atomic, so owners and thieves both claim a chunk with a
+// single compare-and-swap.  Every range has a cache line of its
+// own, so threads working on their own ranges do not share lines.
+//
+// The scheduler also accumulates, until resetStats(), how long
+// each thread was busy and how many chunks were run and stolen.
+//--------------------------------------------------------------
+
+class WorkStealingScheduler {
+public:
+  WorkStealingScheduler(int chunkSize)
+      : _chunkSize(std::max(chunkSize, 1)), _numThreads(0), _range(0),
+        _numChunks(0) {}
+
+  ~WorkStealingScheduler() { freeRanges(); }
+
+  template <class Body> void parallelFor(int numItems, Body &body);
+
+  int numThreads() const { return _numThreads; }
+  uint64_t numChunks() const { return _numChunks; }
+  uint64_t numSteals() const;
+  // Microseconds each thread spent running or looking for chunks.
+  void busyClocks(std::vector<uint64_t> &busy) const;
+
+  void resetStats();
+
+private:
+  struct alignas(64) Range {
+    std::atomic<uint64_t> headTail;
+    uint64_t busyClock;
+    uint64_t numSteals;
+  };
+
+  // new does not honor the alignment of Range before C++17.
+  void allocRanges(int numRanges);
+  void freeRanges();
+
+  static uint64_t pack(uint32_t head, uint32_t tail) {
+    return ((uint64_t)head << 32) | tail;
+  }
+
+  bool takeChunk(int thread, int &chunk);
+  bool stealChunk(int thread, int &chunk);
+
+  WorkStealingScheduler(const WorkStealingScheduler &);
+  WorkStealingScheduler &operator=(const WorkStealingScheduler &);
+
+  int _chunkSize;
+  int _numThreads;
+  Range *_range;
+  uint64_t _numChunks;
+};
+
+// -----------------------------------------------------------------------
+template <class Body>
+void WorkStealingScheduler::parallelFor(int numItems, Body &body) {
+  int numThreads = omp_get_max_threads();
+  if (numThreads != _numThreads) {
+    allocRanges(numThreads);
+    resetStats();
+  }
+
+  int numChunks = (numItems + _chunkSize - 1) / _chunkSize;
+  for (int thread = 0; thread < numThreads; thread++) {
+    uint32_t head = (uint64_t)numChunks * thread / numThreads;
+    uint32_t tail = (uint64_t)numChunks * (thread + 1) / numThreads;
+    _range[thread].headTail.store(pack(head, tail));
+  }
+  _numChunks += numChunks;
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel
+#endif
+  {
+    int thread = omp_get_thread_num();
+    std::chrono::high_resolution_clock::time_point start =
+        std::chrono::high_resolution_clock::now();
+
+    int chunk;
+    while (takeChunk(thread, chunk) || stealChunk(thread, chunk)) {
+      int end = std::min(numItems, (chunk + 1) * _chunkSize);
+      for (int item = chunk * _chunkSize; item < end; item++)
+        body(item);
+    }
+
+    _range[thread].busyClock +=
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - start)
+            .count();
+  }
+}
+
+// -----------------------------------------------------------------------
+inline bool WorkStealingScheduler::takeChunk(int thread, int &chunk) {
+  std::atomic<uint64_t> &headTail = _range[thread].headTail;
+  uint64_t old = headTail.load();
+  while (true) {
+    uint32_t head = old >> 32;
+    uint32_t tail = (uint32_t)old;
+    if (head >= tail)
+      return false;
+    if (headTail.compare_exchange_weak(old, pack(head + 1, tail))) {
+      chunk = head;
+      return true;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------
+inline bool WorkStealingScheduler::stealChunk(int thread, int &chunk) {
+  while (true) {
+    // Pick the thread with the most chunks left.
+    int victim = -1;
+    uint32_t mostLeft = 0;
+    for (int other = 0; other < _numThreads; other++) {
+      uint64_t value = _range[other].headTail.load();
+      uint32_t head = value >> 32;
+      uint32_t tail = (uint32_t)value;
+      if (head < tail && tail - head > mostLeft) {
+        mostLeft = tail - head;
+        victim = other;
+      }
+    }
+    if (victim < 0)
+      return false;
+
+    std::atomic<uint64_t> &headTail = _range[victim].headTail;
+    uint64_t old = headTail.load();
+    uint32_t head = old >> 32;
+    uint32_t tail = (uint32_t)old;
+    if (head < tail &&
+        headTail.compare_exchange_strong(old, pack(head, tail - 1))) {
+      chunk = tail - 1;
+      _range[thread].numSteals++;
+      return true;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------
+inline void WorkStealingScheduler::allocRanges(int numRanges) {
+  freeRanges();
+  void *ptr = 0;
+  if (posix_memalign(&ptr, alignof(Range), numRanges * sizeof(Range)) != 0)
+    ptr = 0;
+  qs_assert(ptr != 0);
+  _range = (Range *)ptr;
+  for (int thread = 0; thread < numRanges; thread++)
+    new (&_range[thread]) Range();
+  _numThreads = numRanges;
+}
+
+// -----------------------------------------------------------------------
+inline void WorkStealingScheduler::freeRanges() {
+  for (int thread = 0; thread < _numThreads; thread++)
+    _range[thread].~Range();
+  free(_range);
+  _range = 0;
+  _numThreads = 0;
+}
+
+// -----------------------------------------------------------------------
+inline uint64_t WorkStealingScheduler::numSteals() const {
+  uint64_t sum = 0;
+  for (int thread = 0; thread < _numThreads; thread++)
+    sum += _range[thread].numSteals;
+  return sum;
+}
+
+// -----------------------------------------------------------------------
+inline void
+WorkStealingScheduler::busyClocks(std::vector<uint64_t> &busy) const {
+  busy.resize(_numThreads);
+  for (int thread = 0; thread < _numThreads; thread++)
+    busy[thread] = _range[thread].busyClock;
+}
+
+// -----------------------------------------------------------------------
+inline void WorkStealingScheduler::resetStats() {
+  for (int thread = 0; thread < _numThreads; thread++) {
+    _range[thread].busyClock = 0;
+    _range[thread].numSteals = 0;
+  }
+  _numChunks = 0;
+}
+
+#endif
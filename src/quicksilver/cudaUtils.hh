@@ -1,7 +1,24 @@
 #ifndef CUDAUTILS_HH
 #define CUDAUTILS_HH
 
-#if defined(HAVE_CUDA) || defined(HAVE_OPENMP_TARGET)
+// A HIP build (HAVE_HIP together with HAVE_CUDA) runs the CUDA code path,
+// with the few runtime calls it makes mapped to their HIP equivalents.
+#if defined(HAVE_HIP)
+#include <hip/hip_runtime.h>
+#define cudaDevAttrMultiProcessorCount hipDeviceAttributeMultiprocessorCount
+#define cudaDeviceGetAttribute hipDeviceGetAttribute
+#define cudaDeviceSetLimit hipDeviceSetLimit
+#define cudaDeviceSynchronize hipDeviceSynchronize
+#define cudaFree hipFree
+#define cudaGetDevice hipGetDevice
+#define cudaGetDeviceCount hipGetDeviceCount
+#define cudaLimitStackSize hipLimitStackSize
+#define cudaMallocManaged hipMallocManaged
+#define cudaMemAttachGlobal hipMemAttachGlobal
+#define cudaMemAttachHost hipMemAttachHost
+#define cudaPeekAtLastError hipPeekAtLastError
+#define cudaSetDevice hipSetDevice
+#elif defined(HAVE_CUDA) || defined(HAVE_OPENMP_TARGET)
 #include <cuda.h>
 #include <cuda_runtime.h>
 #include <cuda_runtime_api.h>
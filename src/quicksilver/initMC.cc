@@ -1,12 +1,16 @@
 #include "initMC.hh"
+#include "Checkpoint.hh"
 #include "CommObject.hh"
 #include "DecompositionObject.hh"
 #include "GlobalFccGrid.hh"
 #include "MC_Base_Particle.hh"
 #include "MC_Processor_Info.hh"
+#include "MC_RNG_State.hh"
 #include "MC_Time_Info.hh"
 #include "MC_Vector.hh"
+#include "MacroscopicCrossSection.hh"
 #include "MaterialDatabase.hh"
+#include "MemoryArena.hh"
 #include "MeshPartition.hh"
 #include "MonteCarlo.hh"
 #include "MpiCommObject.hh"
@@ -14,6 +18,7 @@
 #include "QS_Vector.hh"
 #include "SharedMemoryCommObject.hh"
 #include "Tallies.hh"
+#include "ThreadRanks.hh"
 #include "cudaFunctions.hh"
 #include "cudaUtils.hh"
 #include "utilsMpi.hh"
@@ -32,6 +37,8 @@ using std::string;
 using std::vector;
 
 namespace {
+thread_local MeshSetupTime meshSetupTime;
+
 void initGPUInfo(MonteCarlo *monteCarlo);
 void initNuclearData(MonteCarlo *monteCarlo, const Parameters &params);
 void initMesh(MonteCarlo *monteCarlo, const Parameters &params);
@@ -48,6 +55,12 @@ void checkCrossSections(MonteCarlo *monteCarlo, const Parameters &params);
 
 MonteCarlo *initMC(const Parameters &params) {
   MonteCarlo *monteCarlo;
+
+  // Vaults, tallies and cross section caches are carved from the arena,
+  // so it has to exist before anything is allocated.
+  MemoryArena::instance().reserve(
+      (size_t)params.simulationParams.arenaSize * 1024 * 1024);
+
 #ifdef HAVE_UVM
   void *ptr;
   cudaMallocManaged(&ptr, sizeof(MonteCarlo), cudaMemAttachGlobal);
@@ -61,13 +74,23 @@ MonteCarlo *initMC(const Parameters &params) {
   initMesh(monteCarlo, params);
   initTallies(monteCarlo, params);
 
-  MC_Base_Particle::Update_Counts();
+  // With ThreadRanks main has done these before starting the ranks.
+  if (!ThreadRanks::active()) {
+    MC_Base_Particle::Update_Counts(params.simulationParams.compactComm);
+    rngSetType(params.simulationParams.rngType);
+  }
 
   //   used when debugging cross sections
   checkCrossSections(monteCarlo, params);
+
+  if (!params.simulationParams.restartFile.empty())
+    ReadCheckpoint(monteCarlo, params.simulationParams.restartFile);
+
   return monteCarlo;
 }
 
+MeshSetupTime lastMeshSetupTime() { return meshSetupTime; }
+
 namespace {
 // Init GPU usage information
 void initGPUInfo(MonteCarlo *monteCarlo) {
@@ -112,26 +135,31 @@ void initGPUInfo(MonteCarlo *monteCarlo) {
 }
 } // namespace
 
-/// Initializes both the NuclearData and the MaterialDatabase.  These
+/// Initializes both the NuclearData and the MaterialDatabase, then
+/// flattens them into the material cross section tables.  The first
 /// two structures are inherently linked since the isotopeGids stored in
 /// the MaterialDatabase must correspond to the isotope indices in the
 /// NuclearData.
 namespace {
 void initNuclearData(MonteCarlo *monteCarlo, const Parameters &params) {
 #if defined HAVE_UVM
-  void *ptr1, *ptr2;
+  void *ptr1, *ptr2, *ptr3;
   cudaMallocManaged(&ptr1, sizeof(NuclearData), cudaMemAttachGlobal);
   cudaMallocManaged(&ptr2, sizeof(MaterialDatabase), cudaMemAttachGlobal);
+  cudaMallocManaged(&ptr3, sizeof(MacroscopicCrossSectionTable),
+                    cudaMemAttachGlobal);
 
   monteCarlo->_nuclearData = new (ptr1)
       NuclearData(params.simulationParams.nGroups, params.simulationParams.eMin,
                   params.simulationParams.eMax);
   monteCarlo->_materialDatabase = new (ptr2) MaterialDatabase();
+  monteCarlo->_crossSectionTable = new (ptr3) MacroscopicCrossSectionTable();
 #else
   monteCarlo->_nuclearData = new NuclearData(params.simulationParams.nGroups,
                                              params.simulationParams.eMin,
                                              params.simulationParams.eMax);
   monteCarlo->_materialDatabase = new MaterialDatabase();
+  monteCarlo->_crossSectionTable = new MacroscopicCrossSectionTable();
 #endif
 
   map<string, Polynomial> crossSection;
@@ -177,6 +205,9 @@ void initNuclearData(MonteCarlo *monteCarlo, const Parameters &params) {
     }
     monteCarlo->_materialDatabase->addMaterial(material);
   }
+
+  // Builds the material tables from the data above.
+  monteCarlo->crossSectionDataChanged();
 }
 } // namespace
 
@@ -271,12 +302,22 @@ void initMesh(MonteCarlo *monteCarlo, const Parameters &params) {
   else
     qs_assert(false);
 
-  for (unsigned ii = 0; ii < myDomainGid.size(); ++ii) {
-    if (myRank == 0) {
-      cout << "Building partition " << myDomainGid[ii] << endl;
-    }
-    partition[ii].buildMeshPartition(globalGrid, domainCenter, comm);
+  double partitionStart = mpiWtime();
+
+  // The floods of the domains of this rank are independent.  The exchange
+  // writes into the partitions of the nbrs, so it waits for all of them.
+  if (myRank == 0) {
+    cout << "Building " << myDomainGid.size() << " partition(s)" << endl;
   }
+  int numPartitions = myDomainGid.size();
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+  for (int ii = 0; ii < numPartitions; ++ii)
+    partition[ii].assignCells(globalGrid, domainCenter);
+
+  for (unsigned ii = 0; ii < myDomainGid.size(); ++ii)
+    partition[ii].exchangeCells(globalGrid, comm);
 
   mpiBarrier(MPI_COMM_WORLD);
   if (myRank == 0) {
@@ -286,6 +327,9 @@ void initMesh(MonteCarlo *monteCarlo, const Parameters &params) {
 
   delete comm;
 
+  double domainStart = mpiWtime();
+  meshSetupTime.partition = domainStart - partitionStart;
+
   monteCarlo->domain.reserve(myDomainGid.size(), VAR_MEM);
   monteCarlo->domain.Open();
   for (unsigned ii = 0; ii < myDomainGid.size(); ++ii) {
@@ -298,6 +342,8 @@ void initMesh(MonteCarlo *monteCarlo, const Parameters &params) {
   }
   monteCarlo->domain.Close();
 
+  meshSetupTime.domain = mpiWtime() - domainStart;
+
   if (nRanks == 1)
     consistencyCheck(myRank, monteCarlo->domain);
 
@@ -312,7 +358,8 @@ void initTallies(MonteCarlo *monteCarlo, const Parameters &params) {
   monteCarlo->_tallies->InitializeTallies(
       monteCarlo, params.simulationParams.balanceTallyReplications,
       params.simulationParams.fluxTallyReplications,
-      params.simulationParams.cellTallyReplications);
+      params.simulationParams.cellTallyReplications,
+      params.simulationParams.tallyMode);
 }
 } // namespace
 
@@ -326,10 +373,14 @@ namespace {
 // scatter the centers (somewhat) randomly
 void initializeCentersRandomly(int nCenters, const GlobalFccGrid &grid,
                                vector<MC_Vector> &centers) {
+  // Every rank has to pick the same centers.  erand48 with the default
+  // drand48 seed gives the drand48 sequence without the global state that
+  // the rank threads of ThreadRanks would share.
+  unsigned short seed[3] = {0x330E, 0xABCD, 0x1234};
   set<Tuple> picked;
   do {
-    Tuple iTuple(drand48() * grid.nx() / 2, drand48() * grid.ny() / 2,
-                 drand48() * grid.nz() / 2);
+    Tuple iTuple(erand48(seed) * grid.nx() / 2, erand48(seed) * grid.ny() / 2,
+                 erand48(seed) * grid.nz() / 2);
 
     if (!picked.insert(iTuple).second)
       continue;
@@ -6,4 +6,15 @@ class MonteCarlo;
 
 MonteCarlo *initMC(const Parameters &params);
 
+// Seconds the last initMC of this rank spent building the mesh partitions
+// and the MC_Domains.
+struct MeshSetupTime {
+  double partition;
+  double domain;
+
+  MeshSetupTime() : partition(0.0), domain(0.0) {}
+};
+
+MeshSetupTime lastMeshSetupTime();
+
 #endif
@@ -1,19 +1,31 @@
+#include "Checkpoint.hh"
 #include "CoralBenchmark.hh"
+#include "CycleMetrics.hh"
 #include "CycleTracking.hh"
+#include "CycleTrackingEvent.hh"
 #include "EnergySpectrum.hh"
+#include "MC_Compact_Particle.hh"
 #include "MC_Fast_Timer.hh"
 #include "MC_Particle_Buffer.hh"
 #include "MC_Processor_Info.hh"
+#include "MC_RNG_State.hh"
 #include "MC_SourceNow.hh"
 #include "MC_Time_Info.hh"
+#include "MemoryArena.hh"
 #include "MonteCarlo.hh"
 #include "NVTX_Range.hh"
+#include "NuclearData.hh"
 #include "Parameters.hh"
 #include "ParticleVault.hh"
 #include "ParticleVaultContainer.hh"
+#include "PersistentTracking.hh"
 #include "PopulationControl.hh"
+#include "ScalingBenchmark.hh"
 #include "SendQueue.hh"
 #include "Tallies.hh"
+#include "ThreadRanks.hh"
+#include "VaultSort.hh"
+#include "WorkStealingScheduler.hh"
 #include "cudaFunctions.hh"
 #include "cudaUtils.hh"
 #include "initMC.hh"
@@ -21,7 +33,10 @@
 #include "qs_assert.hh"
 #include "utils.hh"
 #include "utilsMpi.hh"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <vector>
 
 //#include "git_hash.hh"
 //#include "git_vers.hh"
@@ -30,10 +45,20 @@ void gameOver();
 void cycleInit(bool loadBalance);
 void cycleTracking(MonteCarlo *monteCarlo);
 void cycleFinalize();
+void runCycles(const Parameters &params);
+void runProblem(Parameters &params);
+void deleteMC();
+void benchmarkVariants(Parameters &params, int &variant,
+                       const char *variantTitle, const char *variantName[],
+                       int numVariants = 2);
+void energyGroupBenchmark(MonteCarlo *monteCarlo);
+void rngBenchmark();
+void meshBenchmark(Parameters params);
+void compactParticleAccuracy(MonteCarlo *monteCarlo);
 
 using namespace std;
 
-MonteCarlo *mcco = NULL;
+thread_local MonteCarlo *mcco = NULL;
 
 int main(int argc, char **argv) {
   mpiInit(&argc, &argv);
@@ -42,42 +67,536 @@ int main(int argc, char **argv) {
   Parameters params = getParameters(argc, argv);
   printParameters(params, cout);
 
+#ifdef QS_SCALING_BENCHMARK
+  // The QuicksilverScaling target sweeps the problem instead.
+  scalingBenchmark(params);
+  mpiFinalize();
+  return 0;
+#endif
+
+  if (params.simulationParams.vaultBenchmark) {
+    const char *layoutName[3] = {"AoS", "SoA", "compact"};
+    benchmarkVariants(params, params.simulationParams.vaultLayout,
+                      "vaultLayout", layoutName, 3);
+    mpiFinalize();
+    return 0;
+  }
+
+  if (params.simulationParams.vaultSortBenchmark) {
+    const char *orderName[3] = {"unsorted", "cell", "Morton"};
+    benchmarkVariants(params, params.simulationParams.vaultSort, "vaultSort",
+                      orderName, 3);
+    mpiFinalize();
+    return 0;
+  }
+
+  if (params.simulationParams.trackingBenchmark) {
+    const char *modeName[2] = {"history", "event"};
+    benchmarkVariants(params, params.simulationParams.trackingMode,
+                      "trackingMode", modeName);
+    mpiFinalize();
+    return 0;
+  }
+
+  if (params.simulationParams.trackingKernelBenchmark) {
+    const char *kernelName[2] = {"per-vault", "persistent"};
+    benchmarkVariants(params, params.simulationParams.trackingKernel,
+                      "trackingKernel", kernelName);
+    mpiFinalize();
+    return 0;
+  }
+
+  if (params.simulationParams.meshBenchmark) {
+    meshBenchmark(params);
+    mpiFinalize();
+    return 0;
+  }
+
+  if (params.simulationParams.rngBenchmark) {
+    const char *typeName[2] = {"LCG", "Philox"};
+    rngBenchmark();
+    benchmarkVariants(params, params.simulationParams.rngType, "rngType",
+                      typeName);
+    mpiFinalize();
+    return 0;
+  }
+
+  int numThreadRanks = params.simulationParams.threadRanks;
+  if (numThreadRanks > 1) {
+#ifdef HAVE_MPI
+    MC_Fatal_Jump("threadRanks needs a build without MPI\n");
+#endif
+    // The ranks share the particle layout and the random number generator,
+    // set them up before they start.
+    MC_Base_Particle::Update_Counts(params.simulationParams.compactComm);
+    rngSetType(params.simulationParams.rngType);
+    ThreadRanks::run(numThreadRanks, [&params]() { runProblem(params); });
+  } else {
+    runProblem(params);
+  }
+
+  mpiFinalize();
+
+  return 0;
+}
+
+// Sets up, runs and tears down the problem of this rank.
+void runProblem(Parameters &params) {
   // mcco stores just about everything.
   mcco = initMC(params);
 
-  int loadBalance = params.simulationParams.loadBalance;
-
   MC_FASTTIMER_START(MC_Fast_Timer::main); // this can be done once mcco exist.
 
+  runCycles(params);
+
+  MC_FASTTIMER_STOP(MC_Fast_Timer::main);
+
+  gameOver();
+
+  coralBenchmarkCorrectness(mcco, params);
+
+  if (params.simulationParams.compactAccuracy)
+    compactParticleAccuracy(mcco);
+
+  if (params.simulationParams.energyGroupBenchmark)
+    energyGroupBenchmark(mcco);
+
+  deleteMC();
+}
+
+void runCycles(const Parameters &params) {
+  int loadBalance = params.simulationParams.loadBalance;
+
   const int nSteps = params.simulationParams.nSteps;
 
-  for (int ii = 0; ii < nSteps; ++ii) {
+  CycleMetrics metrics(params.simulationParams.metricsFile,
+                       mcco->processor_info->rank);
+
+  const string &checkpointFile = params.simulationParams.checkpointFile;
+  const int checkpointInterval = params.simulationParams.checkpointInterval;
+
+  // After a restart the run continues with the cycles that are left.
+  for (int ii = mcco->time_info->cycle; ii < nSteps; ++ii) {
     cycleInit(bool(loadBalance));
     cycleTracking(mcco);
     cycleFinalize();
 
+    metrics.record(mcco);
+
+    if (!checkpointFile.empty() &&
+        (ii == nSteps - 1 ||
+         (checkpointInterval > 0 && (ii + 1) % checkpointInterval == 0)))
+      WriteCheckpoint(mcco, checkpointFile);
+
     mcco->fast_timer->Last_Cycle_Report(params.simulationParams.cycleTimers,
                                         mcco->processor_info->rank,
                                         mcco->processor_info->num_processors,
                                         mcco->processor_info->comm_mc_world);
   }
+}
 
-  MC_FASTTIMER_STOP(MC_Fast_Timer::main);
-
-  gameOver();
-
-  coralBenchmarkCorrectness(mcco, params);
-
+void deleteMC() {
 #ifdef HAVE_UVM
   mcco->~MonteCarlo();
   cudaFree(mcco);
 #else
   delete mcco;
 #endif
+  mcco = NULL;
+  MemoryArena::instance().release();
+}
 
-  mpiFinalize();
+// Runs the same problem once for each value (0 to numVariants - 1) of an
+// option, such as the particle vault layout, and reports the figure of merit
+// of each.  kernel(s) is the part of cycleTracking spent in the tracking
+// kernels.  When a variant sorts the vaults, sort(s) and the net speedup
+// report the sort time, which is outside the cycleTracking time of the
+// figure of merit.  flux diff is the relative difference of the scalar flux
+// of the last cycle from the first variant, for variants that do not give
+// identical tallies.
+void benchmarkVariants(Parameters &params, int &variant,
+                       const char *variantTitle, const char *variantName[],
+                       int numVariants) {
+  vector<double> figureOfMerit(numVariants);
+  vector<uint64_t> numSegments(numVariants);
+  // Cumulative cycleTracking, cycleTracking_Kernel and cycleInit_VaultSort
+  // time of the slowest rank.
+  vector<uint64_t> trackingClock(numVariants);
+  vector<uint64_t> kernelClock(numVariants);
+  vector<uint64_t> sortClock(numVariants);
+  vector<double> scalarFlux(numVariants);
+  bool anySort = false;
+
+  for (int ii = 0; ii < numVariants; ii++) {
+    variant = ii;
+    Print0("\n%s benchmark: running with %s = %s\n", variantTitle,
+           variantTitle, variantName[ii]);
+
+    mcco = initMC(params);
+
+    MC_FASTTIMER_START(MC_Fast_Timer::main);
+    runCycles(params);
+    MC_FASTTIMER_STOP(MC_Fast_Timer::main);
+
+    numSegments[ii] = mcco->_tallies->_balanceCumulative._numSegments;
+    figureOfMerit[ii] = mcco->fast_timer->Figure_Of_Merit(
+        mcco->processor_info->comm_mc_world, numSegments[ii]);
+
+    uint64_t clock[3] = {
+        mcco->fast_timer->timers[MC_Fast_Timer::cycleTracking].cumulativeClock,
+        mcco->fast_timer->timers[MC_Fast_Timer::cycleTracking_Kernel]
+            .cumulativeClock,
+        mcco->fast_timer->timers[MC_Fast_Timer::cycleInit_VaultSort]
+            .cumulativeClock};
+    uint64_t maxClock[3];
+    mpiAllreduce(clock, maxClock, 3, MPI_UINT64_T, MPI_MAX,
+                 mcco->processor_info->comm_mc_world);
+    trackingClock[ii] = maxClock[0];
+    kernelClock[ii] = maxClock[1];
+    sortClock[ii] = maxClock[2];
+    if (mcco->fast_timer->timers[MC_Fast_Timer::cycleInit_VaultSort]
+            .numCalls > 0)
+      anySort = true;
+    scalarFlux[ii] = mcco->_tallies->_scalarFluxLastCycle;
+
+    coralBenchmarkCorrectness(mcco, params);
+
+    deleteMC();
+  }
 
-  return 0;
+  Print0("\n%-17s %14s %14s %10s %12s %12s", variantTitle, "numSegments",
+         "segments/sec", "speedup", "tracking(s)", "kernel(s)");
+  if (anySort)
+    Print0(" %12s %12s", "sort(s)", "net speedup");
+  Print0(" %12s\n", "flux diff");
+  for (int ii = 0; ii < numVariants; ii++) {
+    double fluxDiff = (scalarFlux[0] != 0.0)
+                          ? fabs(scalarFlux[ii] / scalarFlux[0] - 1.0)
+                          : 0.0;
+    Print0("%-17s %14" PRIu64 " %14.3e %10.3f %12.3f %12.3f", variantName[ii],
+           numSegments[ii], figureOfMerit[ii],
+           figureOfMerit[ii] / figureOfMerit[0], trackingClock[ii] * 1e-6,
+           kernelClock[ii] * 1e-6);
+    if (anySort)
+      Print0(" %12.3f %12.3f", sortClock[ii] * 1e-6,
+             (double)(trackingClock[0] + sortClock[0]) /
+                 (trackingClock[ii] + sortClock[ii]));
+    Print0(" %12.2e\n", fluxDiff);
+  }
+}
+
+void runScalingSample(Parameters &params, ScalingSample &sample) {
+  double start = mpiWtime();
+  mcco = initMC(params);
+  sample.initSeconds = mpiWtime() - start;
+  sample.vaultSize = mcco->_particleVaultContainer->getVaultSize();
+
+  MC_FASTTIMER_START(MC_Fast_Timer::main);
+  runCycles(params);
+  MC_FASTTIMER_STOP(MC_Fast_Timer::main);
+
+  sample.numSegments = mcco->_tallies->_balanceCumulative._numSegments;
+  sample.segmentsPerSec = mcco->fast_timer->Figure_Of_Merit(
+      mcco->processor_info->comm_mc_world, sample.numSegments);
+  for (int timer_index = 0; timer_index < MC_Fast_Timer::Num_Timers;
+       timer_index++)
+    sample.timerClock[timer_index] =
+        mcco->fast_timer->timers[timer_index].cumulativeClock;
+
+  coralBenchmarkCorrectness(mcco, params);
+
+  deleteMC();
+}
+
+// Times initMC, and the mesh partition and MC_Domain setup in it, on cubic
+// meshes of 1e5, 1e6, ... up to 10^meshBenchmark cells.  The times are the
+// ones of the slowest rank.
+void meshBenchmark(Parameters params) {
+  SimulationParameters &sp = params.simulationParams;
+  const int maxExponent = sp.meshBenchmark;
+
+  Print0("\n%14s %8s %14s %14s %14s %14s\n", "cells", "nx", "partition(s)",
+         "domains(s)", "initMC(s)", "cells/sec");
+  for (int exponent = 5; exponent <= maxExponent; exponent++) {
+    int nx = (int)floor(pow(10.0, exponent / 3.0) + 0.5);
+    sp.nx = sp.ny = sp.nz = nx;
+
+    double start = mpiWtime();
+    mcco = initMC(params);
+    double local[3] = {lastMeshSetupTime().partition,
+                       lastMeshSetupTime().domain, mpiWtime() - start};
+    deleteMC();
+
+    double seconds[3];
+    mpiAllreduce(local, seconds, 3, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+    double numCells = (double)nx * nx * nx;
+    Print0("%14.0f %8d %14.3f %14.3f %14.3f %14.3e\n", numCells, nx,
+           seconds[0], seconds[1], seconds[2], numCells / seconds[2]);
+  }
+}
+
+// Returns the number of energy group lookups per second made by lookup over
+// energies.  The group indices are summed into checksum so that the lookups
+// can not be optimized away.
+double energyGroupLookupRate(NuclearData *nuclearData,
+                             int (NuclearData::*lookup)(double),
+                             const vector<double> &energies,
+                             uint64_t &checksum) {
+  const uint64_t minLookups = 1 << 24;
+  uint64_t numLookups = 0;
+
+  double start = mpiWtime();
+  while (numLookups < minLookups) {
+    for (size_t ii = 0; ii < energies.size(); ii++)
+      checksum += (nuclearData->*lookup)(energies[ii]);
+    numLookups += energies.size();
+  }
+  double stop = mpiWtime();
+
+  return numLookups / (stop - start);
+}
+
+// Compares the direct NuclearData::getEnergyGroup lookup with the binary
+// search over the whole grid on three energy distributions: the energies of
+// the particles in census at the end of the run, log-uniform over the group
+// grid, and uniform in energy.
+void energyGroupBenchmark(MonteCarlo *monteCarlo) {
+  NuclearData *nuclearData = monteCarlo->_nuclearData;
+  ParticleVaultContainer *container = monteCarlo->_particleVaultContainer;
+  const char *distributionName[3] = {"census", "log-uniform", "uniform"};
+  vector<double> energies[3];
+
+  for (uint64_t vaultIndex = 0; vaultIndex < container->processedSize();
+       vaultIndex++) {
+    ParticleVault *vault = container->getTaskProcessedVault(vaultIndex);
+    MC_Base_Particle particle;
+    for (size_t ii = 0; ii < vault->size(); ii++) {
+      vault->getBaseParticle(particle, ii);
+      energies[0].push_back(particle.kinetic_energy);
+    }
+  }
+
+  const int numSamples = 1 << 20;
+  uint64_t seed = monteCarlo->_params.simulationParams.seed;
+  double eLow = nuclearData->_energies[0];
+  double eHigh = nuclearData->_energies[nuclearData->_energies.size() - 1];
+  for (int ii = 0; ii < numSamples; ii++) {
+    double randomNumber = rngSample(&seed);
+    energies[1].push_back(eLow * pow(eHigh / eLow, randomNumber));
+    energies[2].push_back(eLow + (eHigh - eLow) * randomNumber);
+  }
+
+  Print0("\nenergy group lookup benchmark (%s)\n",
+         nuclearData->_groupLookup.size() > 0 ? "log bucket table"
+                                              : "binary search fallback");
+  Print0("%-12s %10s %14s %14s %10s %10s\n", "energies", "samples",
+         "search/sec", "lookup/sec", "speedup", "mismatch");
+  for (int dist = 0; dist < 3; dist++) {
+    if (energies[dist].empty())
+      continue;
+
+    int mismatch = 0;
+    for (size_t ii = 0; ii < energies[dist].size(); ii++)
+      if (nuclearData->getEnergyGroup(energies[dist][ii]) !=
+          nuclearData->searchEnergyGroup(energies[dist][ii]))
+        mismatch++;
+
+    uint64_t checksum[2] = {0, 0};
+    double searchRate = energyGroupLookupRate(
+        nuclearData, &NuclearData::searchEnergyGroup, energies[dist],
+        checksum[0]);
+    double lookupRate = energyGroupLookupRate(
+        nuclearData, &NuclearData::getEnergyGroup, energies[dist], checksum[1]);
+    qs_assert(mismatch != 0 || checksum[0] == checksum[1]);
+
+    Print0("%-12s %10zu %14.3e %14.3e %10.3f %10d\n", distributionName[dist],
+           energies[dist].size(), searchRate, lookupRate,
+           lookupRate / searchRate, mismatch);
+  }
+
+  // The lookup of a few more group grids is checked against the binary
+  // search at every group boundary, the doubles next to it, and log-uniform
+  // energies.
+  const int numGrids = 2;
+  const int gridGroups[numGrids] = {230, 2000};
+  const double gridLow[numGrids] = {1e-11, 1e-9};
+  const double gridHigh[numGrids] = {10.0, 20.0};
+  Print0("%-12s %10s %10s %10s %10s\n", "grid", "groups", "eMin", "eMax",
+         "mismatch");
+  for (int grid = 0; grid < numGrids; grid++) {
+    NuclearData gridData(gridGroups[grid], gridLow[grid], gridHigh[grid]);
+    vector<double> gridEnergies;
+    for (int ii = 0; ii < gridData._energies.size(); ii++) {
+      double energy = gridData._energies[ii];
+      gridEnergies.push_back(energy);
+      gridEnergies.push_back(nextafter(energy, 0.0));
+      gridEnergies.push_back(nextafter(energy, 2.0 * energy));
+    }
+    for (int ii = 0; ii < numSamples; ii++)
+      gridEnergies.push_back(gridLow[grid] *
+                             pow(gridHigh[grid] / gridLow[grid],
+                                 rngSample(&seed)));
+
+    int mismatch = 0;
+    for (size_t ii = 0; ii < gridEnergies.size(); ii++)
+      if (gridData.getEnergyGroup(gridEnergies[ii]) !=
+          gridData.searchEnergyGroup(gridEnergies[ii]))
+        mismatch++;
+
+    Print0("%-12s %10d %10.3e %10.3e %10d\n",
+           gridData._groupLookup.size() > 0 ? "table" : "search",
+           gridGroups[grid], gridLow[grid], gridHigh[grid], mismatch);
+  }
+}
+
+// Packs the particles in census at the end of the run into
+// MC_Compact_Particle and back, and reports the largest error of each reduced
+// field over all ranks, the number of particles whose exact fields did not
+// survive, and the bytes per particle of each form.
+void compactParticleAccuracy(MonteCarlo *monteCarlo) {
+  ParticleVaultContainer *container = monteCarlo->_particleVaultContainer;
+  const char *fieldName[6] = {"direction", "speed", "weight",
+                              "time_to_census", "age", "mean_free_paths"};
+  // Absolute errors of the direction cosines, relative errors of the rest.
+  double maxError[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+  uint64_t counts[2] = {0, 0}; // particles, mismatches
+
+  for (uint64_t vaultIndex = 0; vaultIndex < container->processedSize();
+       vaultIndex++) {
+    ParticleVault *vault = container->getTaskProcessedVault(vaultIndex);
+    MC_Base_Particle particle;
+    MC_Base_Particle roundTrip;
+    for (size_t ii = 0; ii < vault->size(); ii++) {
+      vault->getBaseParticle(particle, ii);
+      MC_Compact_Particle(particle).unpack(roundTrip);
+
+      double speed = particle.velocity.Length();
+      double newSpeed = roundTrip.velocity.Length();
+      MC_Vector direction = particle.velocity * (1.0 / speed);
+      MC_Vector newDirection = roundTrip.velocity * (1.0 / newSpeed);
+      double error[6] = {
+          std::max(fabs(newDirection.x - direction.x),
+                   std::max(fabs(newDirection.y - direction.y),
+                            fabs(newDirection.z - direction.z))),
+          fabs(newSpeed / speed - 1.0),
+          fabs(roundTrip.weight / particle.weight - 1.0),
+          fabs(roundTrip.time_to_census / particle.time_to_census - 1.0),
+          fabs(roundTrip.age / particle.age - 1.0),
+          fabs(roundTrip.num_mean_free_paths / particle.num_mean_free_paths -
+               1.0)};
+      for (int field = 0; field < 6; field++)
+        if (std::isfinite(error[field]))
+          maxError[field] = std::max(maxError[field], error[field]);
+
+      if (!(roundTrip.coordinate == particle.coordinate) ||
+          roundTrip.kinetic_energy != particle.kinetic_energy ||
+          roundTrip.random_number_seed != particle.random_number_seed ||
+          roundTrip.identifier != particle.identifier ||
+          roundTrip.num_segments != particle.num_segments ||
+          roundTrip.num_collisions != particle.num_collisions ||
+          roundTrip.last_event != particle.last_event ||
+          roundTrip.breed != particle.breed ||
+          roundTrip.species != particle.species ||
+          roundTrip.domain != particle.domain ||
+          roundTrip.cell != particle.cell)
+        counts[1]++;
+      counts[0]++;
+    }
+  }
+
+  double globalError[6];
+  uint64_t globalCounts[2];
+  mpiAllreduce(maxError, globalError, 6, MPI_DOUBLE, MPI_MAX,
+               monteCarlo->processor_info->comm_mc_world);
+  mpiAllreduce(counts, globalCounts, 2, MPI_UINT64_T, MPI_SUM,
+               monteCarlo->processor_info->comm_mc_world);
+
+  int wireBytes = MC_Base_Particle::num_base_ints * (int)sizeof(int) +
+                  MC_Base_Particle::num_base_floats * (int)sizeof(double) +
+                  MC_Base_Particle::num_base_chars;
+  Print0("\ncompact particle accuracy: %" PRIu64
+         " particles in census, %" PRIu64 " with exact fields changed\n",
+         globalCounts[0], globalCounts[1]);
+  Print0("%-16s %14s\n", "field", "max error");
+  for (int field = 0; field < 6; field++)
+    Print0("%-16s %14.3e\n", fieldName[field], globalError[field]);
+  Print0("bytes per particle: vault %zu -> %zu, particle buffers %d%s\n",
+         sizeof(MC_Base_Particle), sizeof(MC_Compact_Particle), wireBytes,
+         MC_Base_Particle::compact_comm ? " (compact)" : "");
+}
+
+// Returns the random numbers per second drawn with the current generator,
+// one at a time if batchSize is 0 or else batchSize at a time with
+// rngSampleBatch.  The numbers are summed into checksum so that they can
+// not be optimized away.
+double rngSampleRate(int batchSize, double &checksum) {
+  const int numSamples = 1 << 26;
+  vector<double> sample(std::max(batchSize, 1));
+  uint64_t seed = 1029384756;
+
+  double start = mpiWtime();
+  if (batchSize == 0) {
+    for (int ii = 0; ii < numSamples; ii++)
+      checksum += rngSample(&seed);
+  } else {
+    for (int ii = 0; ii < numSamples; ii += batchSize) {
+      rngSampleBatch(&seed, batchSize, &sample[0]);
+      for (int jj = 0; jj < batchSize; jj++)
+        checksum += sample[jj];
+    }
+  }
+  double stop = mpiWtime();
+
+  return numSamples / (stop - start);
+}
+
+// Counts the numbers of the current generator that rngSampleAt and
+// rngSampleBatch get wrong compared with drawing them one at a time.
+int rngMismatches() {
+  const int numSamples = 1000;
+  uint64_t first = 1029384756;
+  uint64_t seed = first, batchSeed = first;
+  vector<double> batch(numSamples);
+  rngSampleBatch(&batchSeed, numSamples, &batch[0]);
+
+  int mismatch = 0;
+  for (int ii = 0; ii < numSamples; ii++) {
+    double sample = rngSample(&seed);
+    if (sample != batch[ii] || sample != rngSampleAt(first, ii))
+      mismatch++;
+  }
+  if (seed != batchSeed)
+    mismatch++;
+  return mismatch;
+}
+
+// Compares the throughput of the lcg and of Philox, drawing one number at a
+// time as the particles do and in batches.
+void rngBenchmark() {
+  const char *typeName[2] = {"LCG", "Philox"};
+  const int batchSize[2] = {0, 1024};
+  int savedType = rng_type;
+  double lcgRate = 0.0;
+
+  Print0("\nrandom number generator benchmark\n");
+  Print0("%-8s %10s %14s %10s %10s\n", "rngType", "batch", "samples/sec",
+         "speedup", "mismatch");
+  for (int type = 0; type < 2; type++) {
+    rngSetType(type);
+    int mismatch = rngMismatches();
+    for (int ii = 0; ii < 2; ii++) {
+      double checksum = 0.0;
+      double rate = rngSampleRate(batchSize[ii], checksum);
+      if (lcgRate == 0.0)
+        lcgRate = rate;
+      qs_assert(checksum > 0.0);
+
+      Print0("%-8s %10d %14.3e %10.3f %10d\n", typeName[type], batchSize[ii],
+             rate, rate / lcgRate, mismatch);
+    }
+  }
+  rngSetType(savedType);
 }
 
 void gameOver() {
@@ -86,13 +605,14 @@ void gameOver() {
       mcco->processor_info->comm_mc_world,
       mcco->_tallies->_balanceCumulative._numSegments);
   mcco->_tallies->_spectrum.PrintSpectrum(mcco);
+  MemoryArena::instance().printUsage();
 }
 
 void cycleInit(bool loadBalance) {
 
   MC_FASTTIMER_START(MC_Fast_Timer::cycleInit);
 
-  mcco->clearCrossSectionCache();
+  mcco->updateCrossSectionCache();
 
   mcco->_tallies->CycleInitialize(mcco);
 
@@ -113,6 +633,12 @@ void cycleInit(bool loadBalance) {
   RouletteLowWeightParticles(
       mcco); // Delete particles with low statistical weight
 
+  if (mcco->_params.simulationParams.vaultSort != VaultSortOrder::None) {
+    MC_FASTTIMER_START(MC_Fast_Timer::cycleInit_VaultSort);
+    SortProcessingVaults(mcco, mcco->_params.simulationParams.vaultSort);
+    MC_FASTTIMER_STOP(MC_Fast_Timer::cycleInit_VaultSort);
+  }
+
   MC_FASTTIMER_STOP(MC_Fast_Timer::cycleInit);
 }
 
@@ -131,6 +657,113 @@ __global__ void CycleTrackingKernel(MonteCarlo *monteCarlo, int num_particles,
 
 #endif
 
+// Loop body of the history-based CPU tracking for the work stealing
+// scheduler.  Item ii is particle first + ii of the processing vault.
+struct TrackParticle {
+  MonteCarlo *monteCarlo;
+  ParticleVault *processingVault;
+  ParticleVault *processedVault;
+  int first;
+
+  TrackParticle(MonteCarlo *mc, ParticleVault *processing,
+                ParticleVault *processed, int first_)
+      : monteCarlo(mc), processingVault(processing),
+        processedVault(processed), first(first_) {}
+
+  void operator()(int ii) {
+    CycleTrackingGuts(monteCarlo, first + ii, processingVault, processedVault);
+  }
+};
+
+// History-based CPU tracking of the particles [first, last) of a vault,
+// either as a static OpenMP loop or with the work stealing scheduler.
+void trackParticles(MonteCarlo *monteCarlo, ParticleVault *processingVault,
+                    ParticleVault *processedVault, int first, int last,
+                    WorkStealingScheduler *scheduler) {
+  if (scheduler != NULL) {
+    TrackParticle track(monteCarlo, processingVault, processedVault, first);
+    scheduler->parallelFor(last - first, track);
+    return;
+  }
+
+#include "mc_omp_parallel_for_schedule_static.hh"
+  for (int particle_index = first; particle_index < last; particle_index++) {
+    CycleTrackingGuts(monteCarlo, particle_index, processingVault,
+                      processedVault);
+  }
+}
+
+// Persistent tracking of all processing vaults, in batches of
+// persistentVaults vaults with one launch of the persistent kernel each.
+// After a batch the particles that left the domain are sent, the
+// secondaries moved to the processing vaults and arriving particles
+// received, as the per vault loop of cycleTracking does after every vault.
+void trackVaultBatches(MonteCarlo *monteCarlo, ExecutionPolicy execPolicy,
+                       TrackingWorkQueue *queue, uint64_t &fill_vault) {
+  ParticleVaultContainer &my_particle_vault =
+      *(monteCarlo->_particleVaultContainer);
+  const uint64_t batchSize =
+      std::max(monteCarlo->_params.simulationParams.persistentVaults, 1);
+
+  for (uint64_t first_vault = 0;
+       first_vault < my_particle_vault.processingSize();
+       first_vault += batchSize) {
+    MC_FASTTIMER_START(MC_Fast_Timer::cycleTracking_Kernel);
+    uint64_t last_vault =
+        std::min(first_vault + batchSize, my_particle_vault.processingSize());
+    uint64_t processed_vault =
+        my_particle_vault.getEmptyProcessedVaults(last_vault - first_vault);
+
+    queue->clear();
+    for (uint64_t vault = first_vault; vault < last_vault; vault++)
+      queue->addVault(my_particle_vault.getTaskProcessingVault(vault),
+                      my_particle_vault.getTaskProcessedVault(
+                          processed_vault + vault - first_vault));
+
+    NVTX_Range trackingKernel("cycleTracking_PersistentKernel");
+    PersistentTracking(monteCarlo, execPolicy, queue);
+    trackingKernel.endRange();
+
+    MC_FASTTIMER_STOP(MC_Fast_Timer::cycleTracking_Kernel);
+
+    MC_FASTTIMER_START(MC_Fast_Timer::cycleTracking_MPI);
+
+    NVTX_Range cleanAndComm("cycleTracking_clean_and_comm");
+
+    SendQueue &sendQueue = *(my_particle_vault.getSendQueue());
+    monteCarlo->particle_buffer->Allocate_Send_Buffer(sendQueue);
+
+    // Move particles from send queue to the send buffers
+    for (int index = 0; index < sendQueue.size(); index++) {
+      sendQueueTuple &sendQueueT = sendQueue.getTuple(index);
+      MC_Base_Particle mcb_particle;
+
+      my_particle_vault.getTaskProcessingVault(first_vault + sendQueueT._vault)
+          ->getBaseParticleComm(mcb_particle, sendQueueT._particleIndex);
+
+      int buffer =
+          monteCarlo->particle_buffer->Choose_Buffer(sendQueueT._neighbor);
+      monteCarlo->particle_buffer->Buffer_Particle(mcb_particle, buffer);
+    }
+
+    monteCarlo->particle_buffer->Send_Particle_Buffers(); // post MPI sends
+
+    for (uint64_t vault = first_vault; vault < last_vault; vault++)
+      my_particle_vault.getTaskProcessingVault(vault)->clear();
+    sendQueue.clear();
+
+    // Move particles in "extra" vaults into the regular vaults.
+    my_particle_vault.cleanExtraVaults();
+
+    // receive any particles that have arrived from other ranks
+    monteCarlo->particle_buffer->Receive_Particle_Buffers(fill_vault);
+
+    cleanAndComm.endRange();
+
+    MC_FASTTIMER_STOP(MC_Fast_Timer::cycleTracking_MPI);
+  }
+}
+
 void cycleTracking(MonteCarlo *monteCarlo) {
   MC_FASTTIMER_START(MC_Fast_Timer::cycleTracking);
 
@@ -152,13 +785,50 @@ void cycleTracking(MonteCarlo *monteCarlo) {
   MC_New_Test_Done_Method::Enum new_test_done_method =
       monteCarlo->particle_buffer->new_test_done_method;
 
+  // Event-based tracking replaces the per-particle loop on the CPU.  Its
+  // scratch space is reused for every vault.
+  bool eventBasedTracking =
+      (monteCarlo->_params.simulationParams.trackingMode == 1);
+  EventTrackingBuffers eventBuffers;
+
+  // The work stealing scheduler balances the history-based loop over the
+  // threads one vault at a time.
+  bool workStealing =
+      (monteCarlo->_params.simulationParams.trackingScheduler == 1);
+  WorkStealingScheduler scheduler(
+      monteCarlo->_params.simulationParams.trackingChunkSize);
+
+  // Pipelined sends: the CPU loop tracks a vault in chunks of sendChunkSize
+  // particles and the particles that left the domain are sent between the
+  // chunks instead of after the whole vault.
+  int sendChunkSize = monteCarlo->particle_buffer->send_chunk_size;
+  bool pipelinedSends = (sendChunkSize > 0);
+
+  // The persistent kernel replaces the per vault loop of the history-based
+  // tracking, on the CPU and with CUDA or HIP.  It does not stream sends or
+  // steal work.
+  bool persistentTracking =
+      (monteCarlo->_params.simulationParams.trackingKernel ==
+       TrackingKernel::Persistent) &&
+      !eventBasedTracking && execPolicy != gpuWithOpenMP;
+  TrackingWorkQueue *workQueue = NULL;
+  if (persistentTracking) {
+    workQueue = MemoryControl::allocate<TrackingWorkQueue>(1, VAR_MEM);
+    workQueue->reserve(
+        std::max(monteCarlo->_params.simulationParams.persistentVaults, 1));
+  }
+
   do {
     int particle_count = 0; // Initialize count of num_particles processed
 
     while (!done) {
       uint64_t fill_vault = 0;
 
+      if (persistentTracking)
+        trackVaultBatches(monteCarlo, execPolicy, workQueue, fill_vault);
+
       for (uint64_t processing_vault = 0;
+           !persistentTracking &&
            processing_vault < my_particle_vault.processingSize();
            processing_vault++) {
         MC_FASTTIMER_START(MC_Fast_Timer::cycleTracking_Kernel);
@@ -171,6 +841,7 @@ void cycleTracking(MonteCarlo *monteCarlo) {
             my_particle_vault.getTaskProcessedVault(processed_vault);
 
         int numParticles = processingVault->size();
+        int firstUnsent = 0; // send queue entries already in send buffers
 
         if (numParticles != 0) {
           NVTX_Range trackingKernel(
@@ -226,12 +897,25 @@ void cycleTracking(MonteCarlo *monteCarlo) {
           } break;
 
           case cpu:
-#include "mc_omp_parallel_for_schedule_static.hh"
-            for (int particle_index = 0; particle_index < numParticles;
-                 particle_index++) {
-              CycleTrackingGuts(monteCarlo, particle_index, processingVault,
-                                processedVault);
+            if (eventBasedTracking) {
+              CycleTrackingEventBased(monteCarlo, processingVault,
+                                      processedVault, eventBuffers);
+              break;
             }
+            if (pipelinedSends) {
+              SendQueue &sendQueue = *(my_particle_vault.getSendQueue());
+              for (int first = 0; first < numParticles;
+                   first += sendChunkSize) {
+                int last = std::min(numParticles, first + sendChunkSize);
+                trackParticles(monteCarlo, processingVault, processedVault,
+                               first, last, workStealing ? &scheduler : NULL);
+                monteCarlo->particle_buffer->Stream_Send_Queue(
+                    sendQueue, processingVault, firstUnsent);
+              }
+              break;
+            }
+            trackParticles(monteCarlo, processingVault, processedVault, 0,
+                           numParticles, workStealing ? &scheduler : NULL);
             break;
           default:
             qs_assert(false);
@@ -249,25 +933,33 @@ void cycleTracking(MonteCarlo *monteCarlo) {
         NVTX_Range cleanAndComm("cycleTracking_clean_and_comm");
 
         SendQueue &sendQueue = *(my_particle_vault.getSendQueue());
-        monteCarlo->particle_buffer->Allocate_Send_Buffer(sendQueue);
-
-        // Move particles from send queue to the send buffers
-        for (int index = 0; index < sendQueue.size(); index++) {
-          sendQueueTuple &sendQueueT = sendQueue.getTuple(index);
-          MC_Base_Particle mcb_particle;
-
-          processingVault->getBaseParticleComm(mcb_particle,
-                                               sendQueueT._particleIndex);
-
-          int buffer =
-              monteCarlo->particle_buffer->Choose_Buffer(sendQueueT._neighbor);
-          monteCarlo->particle_buffer->Buffer_Particle(mcb_particle, buffer);
+        if (pipelinedSends) {
+          // Send whatever was not streamed during tracking, including the
+          // partly filled chunks.
+          monteCarlo->particle_buffer->Stream_Send_Queue(
+              sendQueue, processingVault, firstUnsent);
+        } else {
+          monteCarlo->particle_buffer->Allocate_Send_Buffer(sendQueue);
+
+          // Move particles from send queue to the send buffers
+          for (int index = 0; index < sendQueue.size(); index++) {
+            sendQueueTuple &sendQueueT = sendQueue.getTuple(index);
+            MC_Base_Particle mcb_particle;
+
+            processingVault->getBaseParticleComm(mcb_particle,
+                                                 sendQueueT._particleIndex);
+
+            int buffer = monteCarlo->particle_buffer->Choose_Buffer(
+                sendQueueT._neighbor);
+            monteCarlo->particle_buffer->Buffer_Particle(mcb_particle, buffer);
+          }
         }
 
         monteCarlo->particle_buffer->Send_Particle_Buffers(); // post MPI sends
 
         processingVault->clear(); // remove the invalid particles
         sendQueue.clear();
+        firstUnsent = 0;
 
         // Move particles in "extra" vaults into the regular vaults.
         my_particle_vault.cleanExtraVaults();
@@ -306,6 +998,16 @@ void cycleTracking(MonteCarlo *monteCarlo) {
   // Make sure Buffers Memory is Free
   monteCarlo->particle_buffer->Free_Buffers();
 
+  if (workQueue != NULL)
+    MemoryControl::deallocate(workQueue, 1, VAR_MEM);
+
+  if (workStealing && scheduler.numThreads() > 0) {
+    MC_Thread_Load &threadLoad = monteCarlo->fast_timer->threadLoad;
+    scheduler.busyClocks(threadLoad.busyClock);
+    threadLoad.numChunks = scheduler.numChunks();
+    threadLoad.numSteals = scheduler.numSteals();
+  }
+
   MC_FASTTIMER_STOP(MC_Fast_Timer::cycleTracking);
 }
 
@@ -322,5 +1024,8 @@ void cycleFinalize() {
 
   mcco->particle_buffer->Free_Memory();
 
+  // The particle buffers were the only per cycle arena blocks.
+  MemoryArena::instance().resetCycle();
+
   MC_FASTTIMER_STOP(MC_Fast_Timer::cycleFinalize);
 }
@@ -160,7 +160,12 @@ void mpiSend(void *buf, int count, MPI_Datatype datatype, int dest, int tag,
       // -------------------------------------------------------------------------------
       // -------------------------------------------------------------------------------
 
+#include "ThreadRanks.hh"
 #include "mpi_stubs_internal.hh" // This will be our internal C++ structs.
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 static Handleitem *init_block(int block, Handleitem *b);
 static void init_handles();
@@ -180,8 +185,72 @@ static size_t mpi_datatype_sizes[MPI_UNSIGNED_LONG_LONG + 1] = {
     sizeof(unsigned long long) // slot 5 MPI_Unsigned_Long_Long
 };
 
+// Sizes of the types made by mpiType_contiguous, which numbers them from
+// MPI_UNSIGNED_LONG_LONG + 1 on.
+static std::vector<size_t> mpi_derived_datatype_sizes;
+static std::mutex mpi_derived_datatype_mutex;
+
+static size_t mpi_datatype_size(MPI_Datatype datatype) {
+  if (datatype <= MPI_UNSIGNED_LONG_LONG)
+    return mpi_datatype_sizes[datatype];
+  std::lock_guard<std::mutex> lock(mpi_derived_datatype_mutex);
+  return mpi_derived_datatype_sizes[datatype - MPI_UNSIGNED_LONG_LONG - 1];
+}
+
+template <class T>
+static void mpi_combine(T *result, const T *data, int count, MPI_Op op) {
+  for (int ii = 0; ii < count; ii++) {
+    switch (op) {
+    case MPI_MAX:
+      result[ii] = std::max(result[ii], data[ii]);
+      break;
+    case MPI_MIN:
+      result[ii] = std::min(result[ii], data[ii]);
+      break;
+    case MPI_SUM:
+      result[ii] += data[ii];
+      break;
+    default:
+      printf("%s:%d - MPI_Op (%d) not implemented.", __FILE__, __LINE__, op);
+      qs_assert(false);
+    }
+  }
+}
+
+// Combines the sendbufs of ranks 0 through last_rank, in rank order, into
+// recvbuf (when it is not NULL).  Every rank has to call this.
+static void mpi_reduce_ranks(void *sendbuf, void *recvbuf, int count,
+                             MPI_Datatype datatype, MPI_Op op, int last_rank) {
+  std::vector<char> result(count * mpi_datatype_sizes[datatype] + 1);
+
+  const void *const *data = ThreadRanks::exchangePointers(sendbuf);
+  memcpy(&result[0], data[0], count * mpi_datatype_sizes[datatype]);
+  for (int rank = 1; rank <= last_rank; rank++) {
+    switch (datatype) {
+    case MPI_INT:
+      mpi_combine((int *)&result[0], (const int *)data[rank], count, op);
+      break;
+    case MPI_LONG_LONG:
+      mpi_combine((long long *)&result[0], (const long long *)data[rank],
+                  count, op);
+      break;
+    case MPI_DOUBLE:
+      mpi_combine((double *)&result[0], (const double *)data[rank], count, op);
+      break;
+    case MPI_UNSIGNED_LONG_LONG:
+      mpi_combine((unsigned long long *)&result[0],
+                  (const unsigned long long *)data[rank], count, op);
+      break;
+    }
+  }
+  ThreadRanks::barrier();
+
+  if (recvbuf != NULL)
+    memcpy(recvbuf, &result[0], count * mpi_datatype_sizes[datatype]);
+}
+
 void mpiReduce(void *sendbuf, void *recvbuf, int count, MPI_Datatype datatype,
-               MPI_Op op, int root, MPI_Comm comm) {
+               MPI_Op op, int root, MPI_Comm) {
   if (((sendbuf == NULL) || (recvbuf == NULL)) && (count > 0)) {
     printf("%s:%d - MPI_Reduce sendbuf or recvbuf is NULL \n", __FILE__,
            __LINE__);
@@ -198,7 +267,8 @@ void mpiReduce(void *sendbuf, void *recvbuf, int count, MPI_Datatype datatype,
   case MPI_LONG_LONG:
   case MPI_DOUBLE:
   case MPI_UNSIGNED_LONG_LONG:
-    memcpy(recvbuf, sendbuf, count * mpi_datatype_sizes[datatype]);
+    mpi_reduce_ranks(sendbuf, (ThreadRanks::rank() == root) ? recvbuf : NULL,
+                     count, datatype, op, ThreadRanks::size() - 1);
     break;
   default:
     printf("%s:%d - MPI_Reduce type (%d) not implemented.", __FILE__, __LINE__,
@@ -208,7 +278,7 @@ void mpiReduce(void *sendbuf, void *recvbuf, int count, MPI_Datatype datatype,
 }
 
 void mpiAllreduce(void *sendbuf, void *recvbuf, int count,
-                  MPI_Datatype datatype, MPI_Op operation, MPI_Comm comm) {
+                  MPI_Datatype datatype, MPI_Op operation, MPI_Comm) {
   if (((sendbuf == NULL) || (recvbuf == NULL)) && (count > 0)) {
     printf("%s:%d - MPI_Allreduce sendbuf or recvbuf is NULL \n", __FILE__,
            __LINE__);
@@ -220,7 +290,8 @@ void mpiAllreduce(void *sendbuf, void *recvbuf, int count,
   case MPI_LONG_LONG:
   case MPI_DOUBLE:
   case MPI_UNSIGNED_LONG_LONG:
-    memcpy(recvbuf, sendbuf, count * mpi_datatype_sizes[datatype]);
+    mpi_reduce_ranks(sendbuf, recvbuf, count, datatype, operation,
+                     ThreadRanks::size() - 1);
     break;
   default:
     printf("%s:%d - MPI_Allreduce type (%d) not implemented.", __FILE__,
@@ -229,31 +300,16 @@ void mpiAllreduce(void *sendbuf, void *recvbuf, int count,
   }
 }
 
+// The reduction is done right away, so the request is complete.
 void mpiIAllreduce(void *sendbuf, void *recvbuf, int count,
                    MPI_Datatype datatype, MPI_Op operation, MPI_Comm comm,
                    MPI_Request *request) {
-  if (((sendbuf == NULL) || (recvbuf == NULL)) && (count > 0)) {
-    printf("%s:%d - MPI_Allreduce sendbuf or recvbuf is NULL \n", __FILE__,
-           __LINE__);
-    qs_assert(false);
-  }
-
-  switch (datatype) {
-  case MPI_INT:
-  case MPI_LONG_LONG:
-  case MPI_DOUBLE:
-  case MPI_UNSIGNED_LONG_LONG:
-    memcpy(recvbuf, sendbuf, count * mpi_datatype_sizes[datatype]);
-    break;
-  default:
-    printf("%s:%d - MPI_Allreduce type (%d) not implemented.", __FILE__,
-           __LINE__, datatype);
-    qs_assert(false);
-  }
+  mpiAllreduce(sendbuf, recvbuf, count, datatype, operation, comm);
+  *request = MPI_REQUEST_NULL;
 }
 
 void mpiScan(void *sendbuf, void *recvbuf, int count, MPI_Datatype datatype,
-             MPI_Op operation, MPI_Comm comm) {
+             MPI_Op operation, MPI_Comm) {
   if (((sendbuf == NULL) || (recvbuf == NULL)) && (count > 0)) {
     printf("%s:%d - MPI_Scan sendbuf or recvbuf is NULL \n", __FILE__,
            __LINE__);
@@ -265,7 +321,8 @@ void mpiScan(void *sendbuf, void *recvbuf, int count, MPI_Datatype datatype,
   case MPI_LONG_LONG:
   case MPI_DOUBLE:
   case MPI_UNSIGNED_LONG_LONG:
-    memcpy(recvbuf, sendbuf, count * mpi_datatype_sizes[datatype]);
+    mpi_reduce_ranks(sendbuf, recvbuf, count, datatype, operation,
+                     ThreadRanks::rank());
     break;
   default:
     printf("%s:%d - MPI_Scan type (%d) not implemented.", __FILE__, __LINE__,
@@ -276,7 +333,7 @@ void mpiScan(void *sendbuf, void *recvbuf, int count, MPI_Datatype datatype,
 
 void mpiGather(void *sendbuf, int sendcount, MPI_Datatype sendtype,
                void *recvbuf, int recvcount, MPI_Datatype recvtype, int root,
-               MPI_Comm comm) {
+               MPI_Comm) {
   if (sendcount != recvcount) {
     printf("%s:%d - MPI_Gather sendcount=%d != recvcount=%d\n", __FILE__,
            __LINE__, sendcount, recvcount);
@@ -305,9 +362,15 @@ void mpiGather(void *sendbuf, int sendcount, MPI_Datatype sendtype,
   case MPI_INT:
   case MPI_LONG_LONG:
   case MPI_DOUBLE:
-  case MPI_UNSIGNED_LONG_LONG:
-    memcpy(recvbuf, sendbuf, recvcount * mpi_datatype_sizes[recvtype]);
-    break;
+  case MPI_UNSIGNED_LONG_LONG: {
+    size_t bytes = recvcount * mpi_datatype_sizes[recvtype];
+    const void *const *data = ThreadRanks::exchangePointers(sendbuf);
+    if (ThreadRanks::rank() == root) {
+      for (int rank = 0; rank < ThreadRanks::size(); rank++)
+        memcpy((char *)recvbuf + rank * bytes, data[rank], bytes);
+    }
+    ThreadRanks::barrier();
+  } break;
   default:
     printf("%s:%d - MPI_Gather type (%d) not implemented.", __FILE__, __LINE__,
            recvtype);
@@ -315,6 +378,110 @@ void mpiGather(void *sendbuf, int sendcount, MPI_Datatype sendtype,
   }
 }
 
+void mpiBcast(void *buf, int count, MPI_Datatype datatype, int root,
+              MPI_Comm) {
+  const void *const *data = ThreadRanks::exchangePointers(buf);
+  if (ThreadRanks::rank() != root)
+    memcpy(buf, data[root], count * mpi_datatype_size(datatype));
+  ThreadRanks::barrier();
+}
+
+void mpiComm_rank(MPI_Comm, int *rank) { *rank = ThreadRanks::rank(); }
+
+void mpiComm_size(MPI_Comm, int *size) { *size = ThreadRanks::size(); }
+
+void mpiBarrier(MPI_Comm) { ThreadRanks::barrier(); }
+
+void mpiType_contiguous(int count, MPI_Datatype old_type,
+                        MPI_Datatype *newtype) {
+  size_t size = count * mpi_datatype_size(old_type);
+  std::lock_guard<std::mutex> lock(mpi_derived_datatype_mutex);
+  mpi_derived_datatype_sizes.push_back(size);
+  *newtype = MPI_UNSIGNED_LONG_LONG + mpi_derived_datatype_sizes.size();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Point-to-point messages between thread ranks.  Sends are buffered by
+// ThreadRanks and complete immediately.  A receive request is an index into
+// the pending receives of the calling rank and is matched when it is tested
+// or waited on.
+//----------------------------------------------------------------------------------------------------------------------
+
+struct mpi_pending_recv {
+  void *buf;
+  size_t bytes;
+  int source;
+  int tag;
+};
+
+static thread_local std::vector<mpi_pending_recv> mpi_pending_recvs;
+static thread_local std::vector<MPI_Request> mpi_free_requests;
+
+static void mpi_free_request(MPI_Request *request) {
+  mpi_free_requests.push_back(*request);
+  *request = MPI_REQUEST_NULL;
+}
+
+void mpiIsend(void *buf, int count, MPI_Datatype datatype, int dest, int tag,
+              MPI_Comm, MPI_Request *request) {
+  ThreadRanks::send(dest, tag, buf, count * mpi_datatype_size(datatype));
+  *request = MPI_REQUEST_NULL;
+}
+
+void mpiSend(void *buf, int count, MPI_Datatype datatype, int dest, int tag,
+             MPI_Comm) {
+  ThreadRanks::send(dest, tag, buf, count * mpi_datatype_size(datatype));
+}
+
+void mpiIrecv(void *buf, int count, MPI_Datatype datatype, int source, int tag,
+              MPI_Comm, MPI_Request *request) {
+  mpi_pending_recv recv = {buf, count * mpi_datatype_size(datatype), source,
+                           tag};
+  if (mpi_free_requests.empty()) {
+    mpi_pending_recvs.push_back(recv);
+    *request = mpi_pending_recvs.size(); // 0 is MPI_REQUEST_NULL
+  } else {
+    *request = mpi_free_requests.back();
+    mpi_free_requests.pop_back();
+    mpi_pending_recvs[*request - 1] = recv;
+  }
+}
+
+void mpiTest(MPI_Request *request, int *flag, MPI_Status *) {
+  if (*request == MPI_REQUEST_NULL) {
+    *flag = 1;
+    return;
+  }
+
+  mpi_pending_recv &recv = mpi_pending_recvs[*request - 1];
+  *flag = ThreadRanks::tryReceive(recv.source, recv.tag, recv.buf, recv.bytes);
+  if (*flag)
+    mpi_free_request(request);
+}
+
+void mpiWait(MPI_Request *request, MPI_Status *status) {
+  int flag = 0;
+  mpiTest(request, &flag, status);
+  while (!flag) {
+    std::this_thread::yield();
+    mpiTest(request, &flag, status);
+  }
+}
+
+void mpiWaitall(int count, MPI_Request *array_of_requests,
+                MPI_Status *) {
+  for (int ii = 0; ii < count; ii++)
+    mpiWait(&array_of_requests[ii], MPI_STATUS_IGNORE);
+}
+
+// A pending receive can always be cancelled; it is dropped right away.
+void mpiCancel(MPI_Request *request) {
+  if (*request != MPI_REQUEST_NULL)
+    mpi_free_request(request);
+}
+
+void mpiTest_cancelled(MPI_Status *, int *flag) { *flag = 1; }
+
 double mpiWtime(void) {
   double value;
   value = (double)clock() / (double)CLOCKS_PER_SEC;
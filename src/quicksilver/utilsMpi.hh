@@ -103,23 +103,12 @@ typedef int MPI_Op;
 #define MPI_MIN (2)
 #define MPI_SUM (3)
 
+// Without MPI there is one rank, unless ThreadRanks runs several ranks as
+// threads of this process.  The routines below then communicate between
+// those threads; all communicators are MPI_COMM_WORLD.
 inline void mpiInit(int *argc, char ***argv) { return; }
 inline void mpiFinalize(void) { return; }
-inline void mpiCancel(MPI_Request *request) { return; }
-inline void mpiTest_cancelled(MPI_Status *status, int *flag) { return; }
-inline void mpiWait(MPI_Request *request, MPI_Status *status) { return; }
-inline void mpiWaitall(int count, MPI_Request *array_of_requests,
-                       MPI_Status *array_of_statuses) {
-  return;
-}
-inline void mpiBarrier(MPI_Comm comm) { return; }
 inline void mpiType_commit(MPI_Datatype *datatype) { return; }
-inline void mpiType_contiguous(int count, MPI_Datatype old_type,
-                               MPI_Datatype *newtype) {
-  return;
-}
-inline void mpiComm_rank(MPI_Comm comm, int *rank) { *rank = 0; }
-inline void mpiComm_size(MPI_Comm comm, int *size) { *size = 1; }
 inline void mpiGet_version(int *version, int *subversion) {
   *version = 3;
   *subversion = 0;
@@ -129,30 +118,25 @@ inline void mpiAbort(MPI_Comm comm, int errorcode) {
   exit(errorcode);
 }
 
-inline void mpiTest(MPI_Request *, int *, MPI_Status *) {
-  printf("mpiTest should not be called in serial run\n");
-  qs_assert(false);
-}
-inline void mpiIrecv(void *buf, int count, MPI_Datatype datatype, int source,
-                     int tag, MPI_Comm comm, MPI_Request *request) {
-  printf("mpiIrecv should not be called in serial run\n");
-  qs_assert(false);
-}
-inline void mpiIsend(void *buf, int count, MPI_Datatype datatype, int dest,
-                     int tag, MPI_Comm comm, MPI_Request *request) {
-  printf("mpiIsend should not be called in serial run\n");
-  qs_assert(false);
-}
-inline void mpiSend(void *buf, int count, MPI_Datatype datatype, int dest,
-                    int tag, MPI_Comm comm) {
-  printf("mpiSend should not be called in serial run\n");
-  qs_assert(false);
-}
-
-inline void mpiBcast(void *buf, int count, MPI_Datatype datatype, int root,
-                     MPI_Comm comm) {
-  return;
-}
+void mpiComm_rank(MPI_Comm comm, int *rank);
+void mpiComm_size(MPI_Comm comm, int *size);
+void mpiBarrier(MPI_Comm comm);
+void mpiType_contiguous(int count, MPI_Datatype old_type,
+                        MPI_Datatype *newtype);
+void mpiCancel(MPI_Request *request);
+void mpiTest_cancelled(MPI_Status *status, int *flag);
+void mpiWait(MPI_Request *request, MPI_Status *status);
+void mpiWaitall(int count, MPI_Request *array_of_requests,
+                MPI_Status *array_of_statuses);
+void mpiTest(MPI_Request *request, int *flag, MPI_Status *status);
+void mpiIrecv(void *buf, int count, MPI_Datatype datatype, int source, int tag,
+              MPI_Comm comm, MPI_Request *request);
+void mpiIsend(void *buf, int count, MPI_Datatype datatype, int dest, int tag,
+              MPI_Comm comm, MPI_Request *request);
+void mpiSend(void *buf, int count, MPI_Datatype datatype, int dest, int tag,
+             MPI_Comm comm);
+void mpiBcast(void *buf, int count, MPI_Datatype datatype, int root,
+              MPI_Comm comm);
 
 double mpiWtime(void);
 int mpiComm_split(MPI_Comm comm, int color, int key, MPI_Comm *newcomm);